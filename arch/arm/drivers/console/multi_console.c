@@ -5,12 +5,50 @@
  */
 
 #include <assert.h>
+#include <stdbool.h>
+#include <string.h>
 
+#include <arch_helpers.h>
+#include <cassert.h>
 #include <drivers/console/console.h>
+#include <platform.h>
+#include <platform_def.h>
+#include <spinlock.h>
 
 console_t *console_list;
 uint8_t console_state = CONSOLE_FLAG_BOOT;
 
+/*
+ * Per-CPU log ring used once console_ring_enable() has been called. Each CPU
+ * only ever appends to its own ring, so producers never take a lock: the ring
+ * follows the kfifo scheme of a power-of-two buffer with free-running 'in' and
+ * 'out' indices, where 'in' is only written by the owning CPU and 'out' only
+ * by the drain. Records are a 32-bit length followed by the characters, padded
+ * to 4 bytes so that the length never wraps around the end of the buffer.
+ */
+#ifndef CONSOLE_RING_SIZE
+#define CONSOLE_RING_SIZE		U(4096)
+#endif
+#define CONSOLE_RING_MASK		(CONSOLE_RING_SIZE - 1U)
+#define CONSOLE_RING_HDR_SIZE		sizeof(uint32_t)
+#define CONSOLE_RING_REC_SIZE(len)	\
+	(CONSOLE_RING_HDR_SIZE + (((len) + 3U) & ~3U))
+
+CASSERT(IS_POWER_OF_TWO(CONSOLE_RING_SIZE), assert_console_ring_size_pow2);
+
+typedef struct console_ring {
+	char data[CONSOLE_RING_SIZE];
+	volatile unsigned int in;
+	volatile unsigned int out;
+	/* Set while the owning CPU is appending, to catch nested writers. */
+	bool busy;
+	unsigned int dropped;
+} __aligned(CACHE_WRITEBACK_GRANULE) console_ring_t;
+
+static console_ring_t console_rings[PLATFORM_CORE_COUNT];
+static spinlock_t console_ring_lock;
+static volatile bool console_ring_active;
+
 IMPORT_SYM(console_t *, __STACKS_START__, stacks_start)
 IMPORT_SYM(console_t *, __STACKS_END__, stacks_end)
 
@@ -84,7 +122,7 @@ static int do_putc(int c, console_t *console)
 	return console->putc(c, console);
 }
 
-int console_putc(int c)
+static int console_putc_sync(int c)
 {
 	int err = ERROR_NO_VALID_CONSOLE;
 	console_t *console;
@@ -99,6 +137,205 @@ int console_putc(int c)
 	return err;
 }
 
+static int do_write(const char *buf, size_t len, console_t *console)
+{
+	size_t start = 0U;
+	size_t i;
+	int ret = 0;
+
+	if (console->write == NULL) {
+		for (i = 0U; i < len; i++) {
+			ret = do_putc(buf[i], console);
+			if (ret < 0)
+				return ret;
+		}
+		return (int)len;
+	}
+
+	if ((console->flags & CONSOLE_FLAG_TRANSLATE_CRLF) == 0)
+		return console->write(buf, len, console);
+
+	/* Split the buffer at each '\n' so that a '\r' can be put in front. */
+	for (i = 0U; i < len; i++) {
+		if (buf[i] != '\n')
+			continue;
+
+		if (i > start) {
+			ret = console->write(&buf[start], i - start, console);
+			if (ret < 0)
+				return ret;
+		}
+
+		ret = console->write("\r", 1U, console);
+		if (ret < 0)
+			return ret;
+
+		/* The '\n' itself goes out with the next chunk. */
+		start = i;
+	}
+
+	if (len > start) {
+		ret = console->write(&buf[start], len - start, console);
+		if (ret < 0)
+			return ret;
+	}
+
+	return (int)len;
+}
+
+static int console_write_sync(const char *buf, size_t len)
+{
+	int err = ERROR_NO_VALID_CONSOLE;
+	console_t *console;
+
+	for (console = console_list; console != NULL; console = console->next)
+		if ((console->flags & console_state) &&
+		    ((console->write != NULL) || (console->putc != NULL))) {
+			int ret = do_write(buf, len, console);
+			if ((err == ERROR_NO_VALID_CONSOLE) || (ret < err))
+				err = ret;
+		}
+
+	return err;
+}
+
+static int console_ring_write(const char *buf, size_t len)
+{
+	console_ring_t *ring = &console_rings[plat_my_core_pos()];
+	unsigned int in, free, off, first;
+	u_register_t flags;
+
+	/*
+	 * Interrupts are masked while appending so that a print from an
+	 * interrupt handler cannot interleave with the record under way. A
+	 * synchronous exception taken in the middle still could, those records
+	 * are dropped and accounted for instead.
+	 */
+	flags = read_daif();
+	disable_irq();
+	disable_fiq();
+
+	if (ring->busy ||
+	    (CONSOLE_RING_REC_SIZE(len) > CONSOLE_RING_SIZE)) {
+		ring->dropped++;
+		write_daif(flags);
+		return (int)len;
+	}
+	ring->busy = true;
+
+	in = ring->in;
+	free = CONSOLE_RING_SIZE - (in - ring->out);
+	if (CONSOLE_RING_REC_SIZE(len) > free) {
+		ring->dropped++;
+	} else {
+		*(uint32_t *)&ring->data[in & CONSOLE_RING_MASK] = (uint32_t)len;
+
+		off = (in + CONSOLE_RING_HDR_SIZE) & CONSOLE_RING_MASK;
+		first = MIN((unsigned int)len, CONSOLE_RING_SIZE - off);
+		(void)memcpy(&ring->data[off], buf, first);
+		(void)memcpy(&ring->data[0], buf + first, len - first);
+
+		/* Publish the record only once its contents are visible. */
+		dmbish();
+		ring->in = in + CONSOLE_RING_REC_SIZE(len);
+	}
+
+	ring->busy = false;
+	write_daif(flags);
+
+	return (int)len;
+}
+
+static void console_ring_flush(console_ring_t *ring)
+{
+	unsigned int out = ring->out;
+	unsigned int in = ring->in;
+	unsigned int len, off, first;
+
+	/* Read the records only after having observed 'in'. */
+	dmbish();
+
+	while (out != in) {
+		len = *(uint32_t *)&ring->data[out & CONSOLE_RING_MASK];
+		off = (out + CONSOLE_RING_HDR_SIZE) & CONSOLE_RING_MASK;
+		first = MIN(len, CONSOLE_RING_SIZE - off);
+
+		(void)console_write_sync(&ring->data[off], first);
+		if (len > first)
+			(void)console_write_sync(&ring->data[0], len - first);
+
+		out += CONSOLE_RING_REC_SIZE(len);
+	}
+
+	/* Only hand the space back once the records have been read. */
+	dmbish();
+	ring->out = out;
+}
+
+void console_ring_enable(void)
+{
+	console_ring_active = true;
+}
+
+void console_ring_drain(void)
+{
+	unsigned int i;
+
+	if (!console_ring_active)
+		return;
+
+	spin_lock(&console_ring_lock);
+	for (i = 0U; i < PLATFORM_CORE_COUNT; i++)
+		console_ring_flush(&console_rings[i]);
+	spin_unlock(&console_ring_lock);
+}
+
+void console_ring_emergency(void)
+{
+	unsigned int i;
+
+	if (!console_ring_active)
+		return;
+
+	/*
+	 * Go back to synchronous output and push out what is still queued
+	 * without taking the drain lock, its holder may never release it.
+	 */
+	console_ring_active = false;
+	for (i = 0U; i < PLATFORM_CORE_COUNT; i++)
+		console_ring_flush(&console_rings[i]);
+}
+
+unsigned int console_ring_dropped(void)
+{
+	unsigned int i, dropped = 0U;
+
+	for (i = 0U; i < PLATFORM_CORE_COUNT; i++)
+		dropped += console_rings[i].dropped;
+
+	return dropped;
+}
+
+int console_putc(int c)
+{
+	char ch = (char)c;
+
+	if (console_ring_active) {
+		(void)console_ring_write(&ch, 1U);
+		return c;
+	}
+
+	return console_putc_sync(c);
+}
+
+int console_write(const char *buf, size_t len)
+{
+	if (console_ring_active)
+		return console_ring_write(buf, len);
+
+	return console_write_sync(buf, len);
+}
+
 int console_getc(void)
 {
 	int err = ERROR_NO_VALID_CONSOLE;
@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2015-2022, ARM Limited and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <assert.h>
+
+#include <drivers/delay_timer/clocksource.h>
+
+/* Clocksource used by the delay loops, if any */
+static const clocksource_t *delay_clocksource;
+
+/***********************************************************
+ * Compute the mult/shift pair converting a 'from' Hz clock
+ * into a 'to' Hz clock, such that (value * mult) >> shift
+ * does not overflow 64 bits for values covering up to
+ * 'maxsec' seconds of the 'from' clock. A 'maxsec' of 0
+ * only requires mult to fit in 32 bits, which is what
+ * mul_u64_u32_shr() needs. The largest such shift is
+ * used for best precision.
+ ***********************************************************/
+void clocks_calc_mult_shift(uint32_t *mult, uint32_t *shift, uint32_t from,
+			    uint32_t to, uint32_t maxsec)
+{
+	uint64_t tmp;
+	uint32_t sft, sftacc = 32U;
+
+	assert((from != 0U) && (to != 0U));
+
+	/* Work out how many bits the largest input value takes above 32. */
+	tmp = ((uint64_t)maxsec * from) >> 32;
+	while (tmp != 0U) {
+		tmp >>= 1;
+		sftacc--;
+	}
+
+	for (sft = 32U; sft > 0U; sft--) {
+		tmp = ((uint64_t)to << sft) + (from / 2U);
+		tmp /= from;
+		if ((tmp >> sftacc) == 0U)
+			break;
+	}
+
+	*mult = (uint32_t)tmp;
+	*shift = sft;
+}
+
+/***********************************************************
+ * Fill in a clocksource for a 'bits' wide counter running
+ * at 'freq' Hz. The division happens here, once.
+ ***********************************************************/
+void clocksource_init(clocksource_t *cs, uint64_t (*read)(void),
+		      unsigned int bits, uint32_t freq)
+{
+	assert((cs != NULL) && (read != NULL) &&
+		(bits != 0U) && (freq != 0U));
+
+	cs->read = read;
+	cs->mask = CLOCKSOURCE_MASK(bits);
+	cs->freq = freq;
+
+	clocks_calc_mult_shift(&cs->mult, &cs->shift,
+			       freq, NSEC_PER_SEC, 0U);
+	clocks_calc_mult_shift(&cs->inv_mult, &cs->inv_shift,
+			       NSEC_PER_SEC, freq, 0U);
+}
+
+/***********************************************************
+ * Make 'cs' the counter used by udelay() and the timeout
+ * helpers.
+ ***********************************************************/
+void clocksource_register(clocksource_t *cs)
+{
+	assert((cs != NULL) && (cs->read != NULL) && (cs->mult != 0U));
+
+	delay_clocksource = cs;
+}
+
+const clocksource_t *clocksource_get(void)
+{
+	return delay_clocksource;
+}
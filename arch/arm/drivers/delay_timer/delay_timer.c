@@ -8,6 +8,7 @@
 
 #include <platform_def.h>
 
+#include <drivers/delay_timer/clocksource.h>
 #include <drivers/delay_timer/delay_timer.h>
 #include <utils.h>
 
@@ -16,28 +17,56 @@
  ***********************************************************/
 static const timer_ops_t *timer_ops;
 
+/*
+ * Ticks per microsecond of the timer_ops counter as a mult/shift pair,
+ * precomputed from clk_div / clk_mult by timer_init().
+ */
+static uint32_t timer_us_mult;
+static uint32_t timer_us_shift;
+
+/***********************************************************
+ * Busy-wait on a registered 64-bit clocksource. The delta
+ * is masked to the counter width, so a wrap of the counter
+ * during the wait is harmless and there is no limit on the
+ * length of the delay.
+ ***********************************************************/
+static void clocksource_udelay(const clocksource_t *cs, uint32_t usec)
+{
+	uint64_t start, cycles;
+
+	start = clocksource_read(cs);
+
+	/* Add an extra tick to avoid delaying less than requested. */
+	cycles = clocksource_us2cyc(cs, usec) + 1U;
+
+	while (clocksource_delta(cs, clocksource_read(cs), start) < cycles)
+		;
+}
+
 /***********************************************************
  * Delay for the given number of microseconds. The driver must
  * be initialized before calling this function.
  ***********************************************************/
 void udelay(uint32_t usec)
 {
+	const clocksource_t *cs = clocksource_get();
+
+	if (cs != NULL) {
+		clocksource_udelay(cs, usec);
+		return;
+	}
+
 	assert((timer_ops != NULL) &&
-		(timer_ops->clk_mult != 0U) &&
-		(timer_ops->clk_div != 0U) &&
+		(timer_us_mult != 0U) &&
 		(timer_ops->get_timer_value != NULL));
 
 	uint32_t start, delta;
 	uint64_t total_delta;
 
-	assert(usec < (UINT64_MAX / timer_ops->clk_div));
-
 	start = timer_ops->get_timer_value();
 
 	/* Add an extra tick to avoid delaying less than requested. */
-	total_delta =
-		div_round_up((uint64_t)usec * timer_ops->clk_div,
-						timer_ops->clk_mult) + 1U;
+	total_delta = (((uint64_t)usec * timer_us_mult) >> timer_us_shift) + 1U;
 	/*
 	 * Precaution for the total_delta ~ UINT32_MAX and the fact that we
 	 * cannot catch every tick of the timer.
@@ -63,7 +92,7 @@ void udelay(uint32_t usec)
  ***********************************************************/
 void mdelay(uint32_t msec)
 {
-	assert((msec * 1000UL) < UINT32_MAX);
+	assert(((uint64_t)msec * 1000U) < UINT32_MAX);
 	udelay(msec * 1000U);
 }
 
@@ -78,5 +107,12 @@ void timer_init(const timer_ops_t *ops_ptr)
 		(ops_ptr->clk_div != 0U) &&
 		(ops_ptr->get_timer_value != NULL));
 
+	/*
+	 * The only divide of the delay path: udelay() then turns
+	 * microseconds into ticks with a multiply and a shift.
+	 * usec * mult must not overflow for any 32-bit usec.
+	 */
+	clocks_calc_mult_shift(&timer_us_mult, &timer_us_shift,
+			       ops_ptr->clk_mult, ops_ptr->clk_div, 0U);
 	timer_ops = ops_ptr;
 }
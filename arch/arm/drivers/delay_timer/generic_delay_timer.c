@@ -11,12 +11,27 @@
 #include <arch_helpers.h>
 #include <common.h>
 #include <debug.h>
+#include <drivers/delay_timer/clocksource.h>
 #include <drivers/delay_timer/delay_timer.h>
 #include <drivers/delay_timer/generic_delay_timer.h>
+#include <platform.h>
 #include <utils.h>
 
+/* Width guaranteed by the architecture for the system counter */
+#define GENERIC_COUNTER_BITS	U(56)
 
 static timer_ops_t ops;
+static clocksource_t generic_cs;
+
+static uint64_t generic_counter_read(void)
+{
+	/*
+	 * The full 64-bit count, read in one access even on AArch32. The
+	 * ISB keeps the read from being speculated ahead of earlier code.
+	 */
+	isb();
+	return read_cntpct_el0();
+}
 
 static uint32_t get_timer_value(void)
 {
@@ -41,6 +56,20 @@ void generic_delay_timer_init_args(uint32_t mult, uint32_t div)
 		mult, div);
 }
 
+/*
+ * Register the system counter as the delay clocksource, so that udelay() and
+ * the timeout helpers use the 64-bit count and precomputed mult/shift factors.
+ */
+void generic_delay_timer_clocksource_init(uint32_t freq)
+{
+	clocksource_init(&generic_cs, generic_counter_read,
+			 GENERIC_COUNTER_BITS, freq);
+	clocksource_register(&generic_cs);
+
+	VERBOSE("Generic clocksource at %u Hz, mult=%u shift=%u\n",
+		freq, generic_cs.mult, generic_cs.shift);
+}
+
 void generic_delay_timer_init(void)
 {
 	assert(is_armv7_gentimer_present());
@@ -58,5 +87,6 @@ void generic_delay_timer_init(void)
 	}
 
 	generic_delay_timer_init_args(mult, div);
+	generic_delay_timer_clocksource_init(plat_get_syscnt_freq2());
 }
 
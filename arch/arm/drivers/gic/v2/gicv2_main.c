@@ -447,6 +447,41 @@ void gicv2_raise_sgi(int sgi_num, int proc_num)
 	gicd_write_sgir(driver_data->gicd_base, sgir_val);
 }
 
+/*******************************************************************************
+ * This function raises the specified SGI on every PE whose linear index is set
+ * in the 'procs' bitmap of 'nr_procs' bits, with a single write of GICD_SGIR.
+ ******************************************************************************/
+void gicv2_raise_sgi_many(int sgi_num, const unsigned long *procs,
+			  unsigned int nr_procs)
+{
+	const unsigned int bits = 8U * (unsigned int)sizeof(unsigned long);
+	unsigned int sgir_val, target = 0U, i;
+
+	assert(driver_data != NULL);
+	assert(driver_data->gicd_base != 0U);
+	assert(driver_data->target_masks != NULL);
+	assert(nr_procs <= driver_data->target_masks_num);
+
+	for (i = 0U; i < nr_procs; i++) {
+		if (((procs[i / bits] >> (i % bits)) & 1UL) != 0UL) {
+			assert(driver_data->target_masks[i] != 0U);
+			target |= driver_data->target_masks[i];
+		}
+	}
+
+	if (target == 0U)
+		return;
+
+	sgir_val = GICV2_SGIR_VALUE(SGIR_TGT_SPECIFIC, target, sgi_num);
+
+	/*
+	 * Ensure that any shared variable updates depending on out of band
+	 * interrupt trigger are observed before raising SGI.
+	 */
+	dsbishst();
+	gicd_write_sgir(driver_data->gicd_base, sgir_val);
+}
+
 /*******************************************************************************
  * This function sets the interrupt routing for the given SPI interrupt id.
  * The interrupt routing is specified in routing mode. The proc_num parameter is
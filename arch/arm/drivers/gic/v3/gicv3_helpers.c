@@ -215,6 +215,8 @@ unsigned int gicv3_secure_spis_config_props(uintptr_t gicd_base,
 			continue;
 		}
 
+		gicv3_shadow_mark(intr_num);
+
 		/* Configure this interrupt as a secure interrupt */
 		gicd_clr_igroupr(gicd_base, intr_num);
 
@@ -0,0 +1,939 @@
+/*
+ * Copyright (c) 2015-2022, ARM Limited and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <platform_def.h>
+
+#include <arch_helpers.h>
+#include <cassert.h>
+#include <debug.h>
+#include <drivers/gic/gicv3.h>
+#include <drivers/gic/gicv3_its.h>
+#include <irq.h>
+#include <irqflags.h>
+#include <linux/bitmap.h>
+#include <platform.h>
+#include <spinlock.h>
+
+#include "gicv3_private.h"
+
+#if GICV3_ITS_SUPPORT
+
+CASSERT(((GICV3_ITS_NR_LPIS & (GICV3_ITS_NR_LPIS - 1U)) == 0U) &&
+	(GICV3_ITS_NR_LPIS >= MIN_LPI_ID), assert_its_nr_lpis_pow2);
+CASSERT(PLATFORM_CORE_COUNT <= 0xffffU, assert_its_icid_range);
+
+/*
+ * The LPIs handed out are MIN_LPI_ID to MIN_LPI_ID + GICV3_ITS_NR_LPIS - 1,
+ * which fit in log2(2 * GICV3_ITS_NR_LPIS) ID bits. The tables are sized for
+ * every ID those bits can encode, the GIC may read all of them.
+ */
+#define ITS_NR_INTIDS		(2U * GICV3_ITS_NR_LPIS)
+#define ITS_PROP_TABLE_SIZE	(ITS_NR_INTIDS - MIN_LPI_ID)
+#define ITS_PEND_TABLE_SIZE	(ITS_NR_INTIDS / 8U)
+
+#define ITS_TABLE_ALIGN		U(0x10000)
+#define ITS_PAGE_SIZE		U(0x1000)
+#define ITS_CMD_QUEUE_SIZE	U(0x10000)
+#define ITS_DEVICE_TABLE_SIZE	U(0x10000)
+#define ITS_COLL_TABLE_SIZE	U(0x1000)
+#define ITS_ITT_ALIGN		U(256)
+#define ITS_ITT_NR_CHUNKS	(GICV3_ITS_ITT_POOL_SIZE / ITS_ITT_ALIGN)
+
+/* Command encodings */
+#define ITS_CMD_MOVI		U(0x01)
+#define ITS_CMD_INT		U(0x03)
+#define ITS_CMD_SYNC		U(0x05)
+#define ITS_CMD_MAPD		U(0x08)
+#define ITS_CMD_MAPC		U(0x09)
+#define ITS_CMD_MAPTI		U(0x0a)
+#define ITS_CMD_INV		U(0x0c)
+#define ITS_CMD_INVALL		U(0x0d)
+#define ITS_CMD_DISCARD		U(0x0f)
+
+#define ITS_CMD_VALID		BIT_64(63)
+#define ITS_CMD_RDBASE_SHIFT	U(16)
+#define ITS_CMD_ITT_MASK	GENMASK_64(51, 8)
+
+#define ITS_NO_OWNER		UINT32_MAX
+
+typedef struct its_cmd {
+	uint64_t raw[4];
+} its_cmd_t;
+
+CASSERT(sizeof(its_cmd_t) == 32U, assert_its_cmd_size);
+
+typedef struct its_device {
+	uint32_t devid;
+	unsigned int nr_events;
+	/* Offset of the first LPI from MIN_LPI_ID */
+	unsigned int lpi_base;
+	unsigned int itt_chunk;
+	unsigned int itt_nr_chunks;
+	bool in_use;
+} its_device_t;
+
+/* Reverse mapping of an allocated LPI */
+typedef struct its_lpi {
+	uint16_t dev;
+	uint16_t icid;
+} its_lpi_t;
+
+typedef struct its_pend_table {
+	uint8_t bits[ITS_PEND_TABLE_SIZE];
+} __aligned(ITS_TABLE_ALIGN) its_pend_table_t;
+
+static its_cmd_t its_cmd_queue[ITS_CMD_QUEUE_SIZE / sizeof(its_cmd_t)]
+	__aligned(ITS_TABLE_ALIGN);
+/* Configuration bytes of the LPIs, a cache line holds those of a few LPIs */
+static uint8_t its_prop_table[ITS_PROP_TABLE_SIZE] __aligned(ITS_TABLE_ALIGN);
+static its_pend_table_t its_pend_tables[PLATFORM_CORE_COUNT];
+static uint64_t its_device_table[ITS_DEVICE_TABLE_SIZE / sizeof(uint64_t)]
+	__aligned(ITS_TABLE_ALIGN);
+static uint64_t its_coll_table[ITS_COLL_TABLE_SIZE / sizeof(uint64_t)]
+	__aligned(ITS_PAGE_SIZE);
+static uint8_t its_itt_pool[GICV3_ITS_ITT_POOL_SIZE] __aligned(ITS_ITT_ALIGN);
+
+static its_device_t its_devices[GICV3_ITS_MAX_DEVICES];
+static its_lpi_t its_lpis[GICV3_ITS_NR_LPIS];
+static DECLARE_BITMAP(its_lpi_map, GICV3_ITS_NR_LPIS);
+static DECLARE_BITMAP(its_itt_map, ITS_ITT_NR_CHUNKS);
+
+static struct {
+	uintptr_t base;
+	bool pta;
+	unsigned int itt_entry_size;
+	unsigned int nr_devids;
+	/* The ITS or the Redistributors do not snoop the caches */
+	bool flush_cmds;
+	bool flush_prop;
+	/* Redistributor of each collection, as encoded in the commands */
+	uint64_t rdbase[PLATFORM_CORE_COUNT];
+
+	/* Commands written but not published yet start at 'published' */
+	unsigned int cwriter;
+	unsigned int published;
+	/* Last GITS_CREADR value seen, the ITS is at or past it */
+	unsigned int creadr;
+
+	/* State of the current batch */
+	unsigned int owner;
+	/* Interrupt mask of the owner before the batch */
+	u_register_t irq_flags;
+	unsigned int nr_dirty;
+	DECLARE_BITMAP(dirty, GICV3_ITS_NR_LPIS);
+	DECLARE_BITMAP(sync, PLATFORM_CORE_COUNT);
+} its = {
+	.owner = ITS_NO_OWNER,
+};
+
+static spinlock_t its_lock;
+
+static inline unsigned int its_lpi_offset(unsigned int lpi)
+{
+	assert((lpi >= MIN_LPI_ID) && (lpi < (MIN_LPI_ID + GICV3_ITS_NR_LPIS)));
+	return lpi - MIN_LPI_ID;
+}
+
+static inline uint64_t its_table_attrs(unsigned int inner, unsigned int share,
+				       unsigned int inner_shift,
+				       unsigned int outer_shift,
+				       unsigned int share_shift)
+{
+	return ((uint64_t)inner << inner_shift) |
+	       ((uint64_t)GIC_BASER_CACHE_SAME_AS_INNER << outer_shift) |
+	       ((uint64_t)share << share_shift);
+}
+
+/*******************************************************************************
+ * Command queue. Slots are filled at 'cwriter' and handed to the ITS by
+ * its_publish(), which makes the whole run since the last publish visible
+ * with a single GITS_CWRITER write.
+ ******************************************************************************/
+static void its_clean_cmds(unsigned int from, unsigned int to)
+{
+	uintptr_t q = (uintptr_t)its_cmd_queue;
+
+	if (to >= from) {
+		clean_dcache_range(q + from, to - from);
+	} else {
+		clean_dcache_range(q + from, ITS_CMD_QUEUE_SIZE - from);
+		clean_dcache_range(q, to);
+	}
+}
+
+static void its_publish(void)
+{
+	if (its.cwriter == its.published)
+		return;
+
+	if (its.flush_cmds)
+		its_clean_cmds(its.published, its.cwriter);
+	dsbishst();
+
+	gits_write_cwriter(its.base, its.cwriter);
+	its.published = its.cwriter;
+}
+
+static unsigned int its_read_creadr(void)
+{
+	uint64_t creadr = gits_read_creadr(its.base);
+
+	if ((creadr & GITS_CREADR_STALLED) != 0U) {
+		ERROR("GICv3 ITS: command queue stalled at 0x%llx\n",
+		      (unsigned long long)(creadr & GITS_CQ_OFFSET_MASK));
+		panic();
+	}
+
+	return (unsigned int)(creadr & GITS_CQ_OFFSET_MASK);
+}
+
+static its_cmd_t *its_cmd_alloc(void)
+{
+	unsigned int next = (its.cwriter + sizeof(its_cmd_t)) %
+			    ITS_CMD_QUEUE_SIZE;
+	its_cmd_t *cmd;
+
+	/* Looks full: only then is GITS_CREADR worth reading */
+	if (next == its.creadr) {
+		its.creadr = its_read_creadr();
+		if (next == its.creadr) {
+			its_publish();
+			while (next == its.creadr)
+				its.creadr = its_read_creadr();
+		}
+	}
+
+	cmd = &its_cmd_queue[its.cwriter / sizeof(its_cmd_t)];
+	its.cwriter = next;
+
+	return cmd;
+}
+
+static void its_cmd_write(uint64_t dw0, uint64_t dw1, uint64_t dw2)
+{
+	its_cmd_t *cmd = its_cmd_alloc();
+
+	cmd->raw[0] = dw0;
+	cmd->raw[1] = dw1;
+	cmd->raw[2] = dw2;
+	cmd->raw[3] = 0U;
+}
+
+static inline uint64_t its_cmd_dev(unsigned int op, uint32_t devid)
+{
+	return (uint64_t)op | ((uint64_t)devid << 32);
+}
+
+static void its_cmd_mapd(const its_device_t *dev, bool valid)
+{
+	uint64_t dw2 = 0U;
+
+	if (valid) {
+		dw2 = ITS_CMD_VALID | ((uintptr_t)&its_itt_pool[
+		      dev->itt_chunk * ITS_ITT_ALIGN] & ITS_CMD_ITT_MASK);
+	}
+
+	/* Size is the number of EventID bits minus one */
+	its_cmd_write(its_cmd_dev(ITS_CMD_MAPD, dev->devid),
+		      __builtin_ctz(dev->nr_events) - 1U, dw2);
+}
+
+static void its_cmd_mapc(unsigned int icid)
+{
+	its_cmd_write(ITS_CMD_MAPC, 0U, ITS_CMD_VALID | its.rdbase[icid] | icid);
+}
+
+static void its_cmd_event(unsigned int op, const its_device_t *dev,
+			  unsigned int event, uint64_t dw1_hi, uint64_t dw2)
+{
+	its_cmd_write(its_cmd_dev(op, dev->devid),
+		      event | (dw1_hi << 32), dw2);
+}
+
+/*******************************************************************************
+ * Batches. The lock is held for the whole batch, API calls made by its owner
+ * while it is open only add to it. Interrupts are masked meanwhile: the
+ * interrupt path masks LPIs through the ITS, and would otherwise spin on the
+ * lock or join the batch it interrupted.
+ ******************************************************************************/
+static bool its_enter(void)
+{
+	u_register_t flags = local_irq_save();
+	unsigned int me = plat_my_core_pos();
+
+	if (its.owner == me) {
+		local_irq_restore(flags);
+		return false;
+	}
+
+	spin_lock(&its_lock);
+	its.owner = me;
+	its.irq_flags = flags;
+
+	return true;
+}
+
+static void its_mark_dirty(unsigned int off)
+{
+	if (test_bit(off, its.dirty))
+		return;
+
+	__set_bit(off, its.dirty);
+	its.nr_dirty++;
+}
+
+static void its_need_sync(unsigned int icid)
+{
+	__set_bit(icid, its.sync);
+}
+
+/*******************************************************************************
+ * Make the configuration table updates of the batch visible, cleaning every
+ * dirty cache line once, and have the ITS drop the stale copies it cached.
+ ******************************************************************************/
+static void its_flush_prop(void)
+{
+	DECLARE_BITMAP(colls, PLATFORM_CORE_COUNT);
+	uintptr_t line, last = 0U;
+	unsigned int off, icid;
+	bool invall;
+
+	if (its.nr_dirty == 0U)
+		return;
+
+	if (its.flush_prop) {
+		for_each_set_bit(off, its.dirty, GICV3_ITS_NR_LPIS) {
+			line = (uintptr_t)&its_prop_table[off] &
+			       ~(uintptr_t)(CACHE_WRITEBACK_GRANULE - 1U);
+			if (line == last)
+				continue;
+			clean_dcache_range(line, CACHE_WRITEBACK_GRANULE);
+			last = line;
+		}
+	}
+	dsbishst();
+
+	invall = its.nr_dirty > GICV3_ITS_INVALL_THRESHOLD;
+	bitmap_zero(colls, PLATFORM_CORE_COUNT);
+
+	for_each_set_bit(off, its.dirty, GICV3_ITS_NR_LPIS) {
+		const its_lpi_t *l = &its_lpis[off];
+		const its_device_t *dev = &its_devices[l->dev];
+
+		/* Freed in this batch, DISCARD already dropped it */
+		if (!test_bit(off, its_lpi_map) || !dev->in_use)
+			continue;
+
+		if (invall) {
+			__set_bit(l->icid, colls);
+		} else {
+			its_cmd_event(ITS_CMD_INV, dev, off - dev->lpi_base,
+				      0U, 0U);
+			its_need_sync(l->icid);
+		}
+	}
+
+	if (invall) {
+		for_each_set_bit(icid, colls, PLATFORM_CORE_COUNT) {
+			its_cmd_write(ITS_CMD_INVALL, 0U, icid);
+			its_need_sync(icid);
+		}
+	}
+
+	bitmap_zero(its.dirty, GICV3_ITS_NR_LPIS);
+	its.nr_dirty = 0U;
+}
+
+static void its_flush(void)
+{
+	unsigned int icid;
+
+	its_flush_prop();
+
+	for_each_set_bit(icid, its.sync, PLATFORM_CORE_COUNT)
+		its_cmd_write(ITS_CMD_SYNC, 0U, its.rdbase[icid]);
+	bitmap_zero(its.sync, PLATFORM_CORE_COUNT);
+
+	its_publish();
+	while (its.creadr != its.cwriter)
+		its.creadr = its_read_creadr();
+}
+
+static void its_leave(bool started)
+{
+	u_register_t flags;
+
+	if (!started)
+		return;
+
+	its_flush();
+	flags = its.irq_flags;
+	its.owner = ITS_NO_OWNER;
+	spin_unlock(&its_lock);
+	local_irq_restore(flags);
+}
+
+void gicv3_its_batch_begin(void)
+{
+	bool started = its_enter();
+
+	assert(started);
+	(void)started;
+}
+
+void gicv3_its_batch_end(void)
+{
+	assert(its.owner == plat_my_core_pos());
+
+	its_leave(true);
+}
+
+/*******************************************************************************
+ * LPI configuration.
+ ******************************************************************************/
+static void its_prop_update(unsigned int lpi, uint8_t clr, uint8_t set)
+{
+	unsigned int off = its_lpi_offset(lpi);
+	bool started = its_enter();
+
+	its_prop_table[off] = (its_prop_table[off] & ~clr) | set;
+	its_mark_dirty(off);
+
+	its_leave(started);
+}
+
+void gicv3_its_lpi_enable(unsigned int lpi)
+{
+	its_prop_update(lpi, 0U, LPI_PROP_ENABLE);
+}
+
+void gicv3_its_lpi_disable(unsigned int lpi)
+{
+	its_prop_update(lpi, LPI_PROP_ENABLE, 0U);
+}
+
+void gicv3_its_lpi_set_priority(unsigned int lpi, unsigned int priority)
+{
+	its_prop_update(lpi, LPI_PROP_PRIORITY_MASK,
+			priority & LPI_PROP_PRIORITY_MASK);
+}
+
+static int its_lpi_event(unsigned int lpi, const its_device_t **dev,
+			 unsigned int *event)
+{
+	unsigned int off;
+
+	if ((lpi < MIN_LPI_ID) || (lpi >= (MIN_LPI_ID + GICV3_ITS_NR_LPIS)))
+		return -EINVAL;
+
+	off = lpi - MIN_LPI_ID;
+	if (!test_bit(off, its_lpi_map))
+		return -EINVAL;
+
+	*dev = &its_devices[its_lpis[off].dev];
+	*event = off - (*dev)->lpi_base;
+
+	return 0;
+}
+
+int gicv3_its_lpi_set_affinity(unsigned int lpi, unsigned int proc_num)
+{
+	const its_device_t *dev;
+	unsigned int event;
+	bool started;
+	int rc;
+
+	if ((proc_num >= PLATFORM_CORE_COUNT) || (its.rdbase[proc_num] == 0U))
+		return -EINVAL;
+
+	started = its_enter();
+	rc = its_lpi_event(lpi, &dev, &event);
+	if (rc == 0) {
+		its_cmd_event(ITS_CMD_MOVI, dev, event, 0U, proc_num);
+		its_lpis[lpi - MIN_LPI_ID].icid = (uint16_t)proc_num;
+		its_need_sync(proc_num);
+	}
+	its_leave(started);
+
+	return rc;
+}
+
+int gicv3_its_lpi_inject(unsigned int lpi)
+{
+	const its_device_t *dev;
+	unsigned int event;
+	bool started;
+	int rc;
+
+	started = its_enter();
+	rc = its_lpi_event(lpi, &dev, &event);
+	if (rc == 0) {
+		its_cmd_event(ITS_CMD_INT, dev, event, 0U, 0U);
+		its_need_sync(its_lpis[lpi - MIN_LPI_ID].icid);
+	}
+	its_leave(started);
+
+	return rc;
+}
+
+/*******************************************************************************
+ * Devices. A device gets a naturally aligned block of 'nr_events' LPIs, the
+ * event N of the device raising LPI '*lpi_base' + N. All its LPIs are routed
+ * to the calling CPU and start disabled.
+ ******************************************************************************/
+static its_device_t *its_find_device(uint32_t devid)
+{
+	for (unsigned int i = 0U; i < GICV3_ITS_MAX_DEVICES; i++) {
+		if (its_devices[i].in_use && (its_devices[i].devid == devid))
+			return &its_devices[i];
+	}
+
+	return NULL;
+}
+
+int gicv3_its_device_map(uint32_t devid, unsigned int nr_events,
+			 unsigned int *lpi_base)
+{
+	unsigned int icid = plat_my_core_pos();
+	unsigned int itt_nr_chunks, itt_chunk, base, slot;
+	its_device_t *dev = NULL;
+	bool started;
+
+	assert(its.base != 0U);
+	assert(lpi_base != NULL);
+
+	if ((devid >= its.nr_devids) || (nr_events == 0U) ||
+	    (nr_events > GICV3_ITS_NR_LPIS))
+		return -EINVAL;
+
+	/* At least one EventID bit */
+	nr_events = MAX(nr_events, 2U);
+	if ((nr_events & (nr_events - 1U)) != 0U)
+		nr_events = 1U << (32U - __builtin_clz(nr_events));
+
+	itt_nr_chunks = (nr_events * its.itt_entry_size + ITS_ITT_ALIGN - 1U) /
+			ITS_ITT_ALIGN;
+
+	started = its_enter();
+
+	if (its_find_device(devid) != NULL) {
+		its_leave(started);
+		return -EBUSY;
+	}
+
+	for (slot = 0U; slot < GICV3_ITS_MAX_DEVICES; slot++) {
+		if (!its_devices[slot].in_use) {
+			dev = &its_devices[slot];
+			break;
+		}
+	}
+
+	base = bitmap_find_next_zero_area(its_lpi_map, GICV3_ITS_NR_LPIS, 0U,
+					  nr_events, nr_events - 1U);
+	itt_chunk = bitmap_find_next_zero_area(its_itt_map, ITS_ITT_NR_CHUNKS,
+					       0U, itt_nr_chunks, 0U);
+	if ((dev == NULL) || (base >= GICV3_ITS_NR_LPIS) ||
+	    (itt_chunk >= ITS_ITT_NR_CHUNKS)) {
+		its_leave(started);
+		return -ENOMEM;
+	}
+
+	bitmap_set(its_lpi_map, base, nr_events);
+	bitmap_set(its_itt_map, itt_chunk, itt_nr_chunks);
+
+	dev->devid = devid;
+	dev->nr_events = nr_events;
+	dev->lpi_base = base;
+	dev->itt_chunk = itt_chunk;
+	dev->itt_nr_chunks = itt_nr_chunks;
+	dev->in_use = true;
+
+	/* The ITT is private to the ITS, it must not see stale lines of it */
+	(void)memset(&its_itt_pool[itt_chunk * ITS_ITT_ALIGN], 0,
+		     itt_nr_chunks * ITS_ITT_ALIGN);
+	flush_dcache_range((uintptr_t)&its_itt_pool[itt_chunk * ITS_ITT_ALIGN],
+			   itt_nr_chunks * ITS_ITT_ALIGN);
+
+	its_cmd_mapd(dev, true);
+
+	for (unsigned int ev = 0U; ev < nr_events; ev++) {
+		unsigned int off = base + ev;
+
+		its_lpis[off].dev = (uint16_t)slot;
+		its_lpis[off].icid = (uint16_t)icid;
+		its_prop_table[off] = GICV3_ITS_LPI_PRIORITY | LPI_PROP_RES1;
+		its_mark_dirty(off);
+
+		its_cmd_event(ITS_CMD_MAPTI, dev, ev, MIN_LPI_ID + off, icid);
+	}
+	its_need_sync(icid);
+
+	its_leave(started);
+
+	*lpi_base = MIN_LPI_ID + base;
+
+	VERBOSE("GICv3 ITS: device 0x%x, LPIs %u-%u\n", devid, *lpi_base,
+		*lpi_base + nr_events - 1U);
+
+	return 0;
+}
+
+int gicv3_its_device_unmap(uint32_t devid)
+{
+	its_device_t *dev;
+	bool started;
+
+	started = its_enter();
+
+	dev = its_find_device(devid);
+	if (dev == NULL) {
+		its_leave(started);
+		return -EINVAL;
+	}
+
+	for (unsigned int ev = 0U; ev < dev->nr_events; ev++) {
+		unsigned int off = dev->lpi_base + ev;
+
+		its_prop_table[off] &= ~LPI_PROP_ENABLE;
+		its_cmd_event(ITS_CMD_DISCARD, dev, ev, 0U, 0U);
+		its_need_sync(its_lpis[off].icid);
+	}
+	its_cmd_mapd(dev, false);
+
+	/* The queue is ordered, later commands may reuse the LPIs and ITT */
+	bitmap_clear(its_lpi_map, dev->lpi_base, dev->nr_events);
+	bitmap_clear(its_itt_map, dev->itt_chunk, dev->itt_nr_chunks);
+	dev->in_use = false;
+
+	its_leave(started);
+
+	return 0;
+}
+
+/* Address devices write their EventID to */
+uintptr_t gicv3_its_doorbell(void)
+{
+	return its.base + GITS_TRANSLATER;
+}
+
+/*******************************************************************************
+ * Program one of the GITS_BASER<n> with the table at 'pa'. Returns the number
+ * of entries the table holds, or 0 if the ITS does not accept it.
+ ******************************************************************************/
+static unsigned int its_setup_baser(unsigned int n, uint64_t val, uintptr_t pa,
+				    size_t size)
+{
+	const uint64_t ro = ((uint64_t)GITS_BASER_TYPE_MASK <<
+			     GITS_BASER_TYPE_SHIFT) |
+			    ((uint64_t)GITS_BASER_ENTRY_SIZE_MASK <<
+			     GITS_BASER_ENTRY_SIZE_SHIFT);
+	unsigned int entry_size;
+	uint64_t ret;
+
+	entry_size = (unsigned int)((val >> GITS_BASER_ENTRY_SIZE_SHIFT) &
+				    GITS_BASER_ENTRY_SIZE_MASK) + 1U;
+
+	val = (val & ro) | GITS_BASER_VALID |
+	      its_table_attrs(GIC_BASER_CACHE_RAWAWB, GIC_BASER_SHARE_IS,
+			      GITS_BASER_INNER_CACHE_SHIFT,
+			      GITS_BASER_OUTER_CACHE_SHIFT,
+			      GITS_BASER_SHARE_SHIFT) |
+	      (pa & GITS_BASER_PA_MASK) |
+	      ((uint64_t)GITS_BASER_PAGE_SIZE_4K << GITS_BASER_PAGE_SIZE_SHIFT) |
+	      ((size / ITS_PAGE_SIZE) - 1U);
+	gits_write_baser(its.base, n, val);
+	ret = gits_read_baser(its.base, n);
+
+	if (((ret >> GITS_BASER_PAGE_SIZE_SHIFT) & 0x3U) !=
+	    GITS_BASER_PAGE_SIZE_4K)
+		return 0U;
+
+	/* Not shareable: fall back to an uncached table */
+	if (((ret >> GITS_BASER_SHARE_SHIFT) & GIC_BASER_SHARE_MASK) ==
+	    GIC_BASER_SHARE_NS) {
+		val = (val & ~(((uint64_t)GIC_BASER_CACHE_MASK <<
+				GITS_BASER_INNER_CACHE_SHIFT) |
+			       ((uint64_t)GIC_BASER_SHARE_MASK <<
+				GITS_BASER_SHARE_SHIFT))) |
+		      ((uint64_t)GIC_BASER_CACHE_NC <<
+		       GITS_BASER_INNER_CACHE_SHIFT);
+		gits_write_baser(its.base, n, val);
+	}
+
+	flush_dcache_range(pa, size);
+
+	return (unsigned int)(size / entry_size);
+}
+
+static int its_setup_tables(unsigned int devbits)
+{
+	unsigned int n, type, nr;
+	uint64_t val;
+
+	for (n = 0U; n < GITS_BASER_NR; n++) {
+		val = gits_read_baser(its.base, n);
+		type = (unsigned int)((val >> GITS_BASER_TYPE_SHIFT) &
+				      GITS_BASER_TYPE_MASK);
+
+		switch (type) {
+		case GITS_BASER_TYPE_DEVICE:
+			nr = its_setup_baser(n, val,
+					     (uintptr_t)its_device_table,
+					     sizeof(its_device_table));
+			if (nr == 0U)
+				return -EINVAL;
+			/* A 32-bit DeviceID space can't be shifted out */
+			its.nr_devids = (devbits >= 32U) ? nr :
+					MIN(nr, 1U << devbits);
+			break;
+		case GITS_BASER_TYPE_COLLECTION:
+			nr = its_setup_baser(n, val, (uintptr_t)its_coll_table,
+					     sizeof(its_coll_table));
+			if (nr < PLATFORM_CORE_COUNT)
+				return -EINVAL;
+			break;
+		default:
+			break;
+		}
+	}
+
+	return (its.nr_devids != 0U) ? 0 : -EINVAL;
+}
+
+static void its_setup_cmd_queue(void)
+{
+	uint64_t attrs, val;
+
+	attrs = its_table_attrs(GIC_BASER_CACHE_RAWAWB, GIC_BASER_SHARE_IS,
+				GITS_CBASER_INNER_CACHE_SHIFT,
+				GITS_CBASER_OUTER_CACHE_SHIFT,
+				GITS_CBASER_SHARE_SHIFT);
+	val = GITS_CBASER_VALID | attrs |
+	      ((uintptr_t)its_cmd_queue & GITS_CBASER_PA_MASK) |
+	      ((ITS_CMD_QUEUE_SIZE / ITS_PAGE_SIZE) - 1U);
+	gits_write_cbaser(its.base, val);
+
+	if (((gits_read_cbaser(its.base) >> GITS_CBASER_SHARE_SHIFT) &
+	     GIC_BASER_SHARE_MASK) == GIC_BASER_SHARE_NS) {
+		val &= ~(attrs);
+		val |= its_table_attrs(GIC_BASER_CACHE_NC, GIC_BASER_SHARE_NS,
+				       GITS_CBASER_INNER_CACHE_SHIFT,
+				       GITS_CBASER_OUTER_CACHE_SHIFT,
+				       GITS_CBASER_SHARE_SHIFT);
+		gits_write_cbaser(its.base, val);
+		its.flush_cmds = true;
+	}
+
+	flush_dcache_range((uintptr_t)its_cmd_queue, sizeof(its_cmd_queue));
+
+	its.cwriter = 0U;
+	its.published = 0U;
+	its.creadr = 0U;
+	gits_write_cwriter(its.base, 0U);
+}
+
+/*******************************************************************************
+ * Bring up the ITS at 'gits_base'. Called once, on the primary CPU, after the
+ * GICv3 driver has been initialised; every CPU then calls
+ * gicv3_its_cpu_init() once its Redistributor is on.
+ ******************************************************************************/
+int gicv3_its_init(uintptr_t gits_base)
+{
+	uint64_t typer;
+	unsigned int devbits;
+	int rc;
+
+	assert(gits_base != 0U);
+	assert(its.base == 0U);
+
+	its.base = gits_base;
+
+	if ((gits_read_ctlr(gits_base) & GITS_CTLR_ENABLED_BIT) != 0U) {
+		gits_write_ctlr(gits_base, 0U);
+		gits_wait_for_quiescent_bit(gits_base);
+	}
+
+	typer = gits_read_typer(gits_base);
+	its.pta = (typer & GITS_TYPER_PTA) != 0U;
+	its.itt_entry_size = (unsigned int)((typer >>
+				GITS_TYPER_ITT_ENTRY_SIZE_SHIFT) &
+				GITS_TYPER_ITT_ENTRY_SIZE_MASK) + 1U;
+	devbits = (unsigned int)((typer >> GITS_TYPER_DEVBITS_SHIFT) &
+				 GITS_TYPER_DEVBITS_MASK) + 1U;
+
+	rc = its_setup_tables(devbits);
+	if (rc != 0) {
+		ERROR("GICv3 ITS: unsupported table layout\n");
+		its.base = 0U;
+		return rc;
+	}
+
+	its_setup_cmd_queue();
+
+	(void)memset(its_prop_table, 0, sizeof(its_prop_table));
+	flush_dcache_range((uintptr_t)its_prop_table, sizeof(its_prop_table));
+
+	gits_write_ctlr(gits_base, GITS_CTLR_ENABLED_BIT);
+
+	INFO("GICv3 ITS: %u LPIs, %u device IDs\n", GICV3_ITS_NR_LPIS,
+	     its.nr_devids);
+
+	return 0;
+}
+
+/*******************************************************************************
+ * Enable LPIs on the Redistributor of 'proc_num' and map its collection. Does
+ * nothing if there is no ITS.
+ ******************************************************************************/
+void gicv3_its_cpu_init(unsigned int proc_num)
+{
+	uintptr_t gicr_base;
+	uint64_t attrs, val;
+	bool started;
+
+	if (its.base == 0U)
+		return;
+
+	assert(gicv3_driver_data != NULL);
+	assert(proc_num < gicv3_driver_data->rdistif_num);
+	assert(proc_num < PLATFORM_CORE_COUNT);
+
+	gicr_base = gicv3_driver_data->rdistif_base_addrs[proc_num];
+	assert(gicr_base != 0U);
+
+	/* The tables cannot be changed once LPIs are on, e.g. after a resume */
+	if ((gicr_read_ctlr(gicr_base) & GICR_CTLR_EN_LPIS_BIT) == 0U) {
+		attrs = its_table_attrs(GIC_BASER_CACHE_RAWAWB,
+					GIC_BASER_SHARE_IS,
+					GICR_BASER_INNER_CACHE_SHIFT,
+					GICR_BASER_OUTER_CACHE_SHIFT,
+					GICR_BASER_SHARE_SHIFT);
+
+		val = attrs | ((uintptr_t)its_prop_table &
+			       GICR_PROPBASER_PA_MASK) |
+		      (__builtin_ctz(ITS_NR_INTIDS) - 1U);
+		gicr_write_propbaser(gicr_base, val);
+		if (((gicr_read_propbaser(gicr_base) >>
+		      GICR_BASER_SHARE_SHIFT) & GIC_BASER_SHARE_MASK) ==
+		    GIC_BASER_SHARE_NS) {
+			val = (val & ~attrs) |
+			      its_table_attrs(GIC_BASER_CACHE_NC,
+					      GIC_BASER_SHARE_NS,
+					      GICR_BASER_INNER_CACHE_SHIFT,
+					      GICR_BASER_OUTER_CACHE_SHIFT,
+					      GICR_BASER_SHARE_SHIFT);
+			gicr_write_propbaser(gicr_base, val);
+			its.flush_prop = true;
+		}
+
+		flush_dcache_range((uintptr_t)&its_pend_tables[proc_num],
+				   sizeof(its_pend_tables[proc_num]));
+		val = attrs | GICR_PENDBASER_PTZ |
+		      ((uintptr_t)&its_pend_tables[proc_num] &
+		       GICR_PENDBASER_PA_MASK);
+		gicr_write_pendbaser(gicr_base, val);
+		if (((gicr_read_pendbaser(gicr_base) >>
+		      GICR_BASER_SHARE_SHIFT) & GIC_BASER_SHARE_MASK) ==
+		    GIC_BASER_SHARE_NS) {
+			val = (val & ~attrs) |
+			      its_table_attrs(GIC_BASER_CACHE_NC,
+					      GIC_BASER_SHARE_NS,
+					      GICR_BASER_INNER_CACHE_SHIFT,
+					      GICR_BASER_OUTER_CACHE_SHIFT,
+					      GICR_BASER_SHARE_SHIFT);
+			gicr_write_pendbaser(gicr_base, val);
+		}
+
+		dsbsy();
+		gicr_write_ctlr(gicr_base, gicr_read_ctlr(gicr_base) |
+				GICR_CTLR_EN_LPIS_BIT);
+		dsbsy();
+	}
+
+	if (its.pta) {
+		its.rdbase[proc_num] = gicr_base & GICR_PENDBASER_PA_MASK;
+	} else {
+		its.rdbase[proc_num] = ((gicr_read_typer(gicr_base) >>
+					 TYPER_PROC_NUM_SHIFT) &
+					TYPER_PROC_NUM_MASK) <<
+				       ITS_CMD_RDBASE_SHIFT;
+	}
+
+	started = its_enter();
+	its_cmd_mapc(proc_num);
+	its_need_sync(proc_num);
+	its_leave(started);
+}
+
+#if GICV3_ITS_SELFTEST
+#define ITS_SELFTEST_EVENTS	U(64)
+
+static irq_desc_t its_selftest_descs[ITS_SELFTEST_EVENTS];
+static volatile unsigned int its_selftest_hits;
+
+static irq_return_t its_selftest_fn(unsigned int intid, void *data)
+{
+	its_selftest_hits++;
+	return IRQ_HANDLED;
+}
+
+/*******************************************************************************
+ * Map a fake device, inject each of its events with INT commands in a single
+ * batch and check that every LPI got delivered. Meant for QEMU virt with
+ * its=on; interrupts must be unmasked on the calling CPU.
+ ******************************************************************************/
+int gicv3_its_selftest(void)
+{
+	uint32_t devid = its.nr_devids - 1U;
+	unsigned int lpi_base, i;
+	int rc;
+
+	rc = gicv3_its_device_map(devid, ITS_SELFTEST_EVENTS, &lpi_base);
+	if (rc != 0)
+		return rc;
+
+	gicv3_its_batch_begin();
+	for (i = 0U; i < ITS_SELFTEST_EVENTS; i++) {
+		rc = irq_request_lpi(lpi_base + i, &its_selftest_descs[i],
+				     its_selftest_fn, NULL, "its-selftest");
+		if (rc != 0)
+			break;
+	}
+	gicv3_its_batch_end();
+
+	if (rc == 0) {
+		its_selftest_hits = 0U;
+
+		gicv3_its_batch_begin();
+		for (i = 0U; i < ITS_SELFTEST_EVENTS; i++)
+			(void)gicv3_its_lpi_inject(lpi_base + i);
+		gicv3_its_batch_end();
+
+		for (i = 0U; (i < 1000000U) &&
+		     (its_selftest_hits < ITS_SELFTEST_EVENTS); i++)
+			;
+
+		if (its_selftest_hits != ITS_SELFTEST_EVENTS)
+			rc = -EIO;
+	}
+
+	INFO("GICv3 ITS selftest: %u/%u LPIs delivered\n", its_selftest_hits,
+	     ITS_SELFTEST_EVENTS);
+
+	for (i = 0U; i < ITS_SELFTEST_EVENTS; i++)
+		irq_free(lpi_base + i);
+	(void)gicv3_its_device_unmap(devid);
+
+	return rc;
+}
+#endif /* GICV3_ITS_SELFTEST */
+
+#endif /* GICV3_ITS_SUPPORT */
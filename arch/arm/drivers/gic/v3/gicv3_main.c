@@ -5,12 +5,14 @@
  */
 
 #include <assert.h>
+#include <stdbool.h>
 
 #include <arch.h>
 #include <arch_helpers.h>
 #include <debug.h>
 #include <interrupt_props.h>
 #include <drivers/gic/gicv3.h>
+#include <linux/bitmap.h>
 #include <spinlock.h>
 
 #include "gicv3_private.h"
@@ -90,6 +92,268 @@ static bool is_sgi_ppi(unsigned int id);
 #define RESTORE_GICD_EREGS(base, ctx, intr_num, reg, REG)
 #endif /* GIC_EXT_INTID */
 
+#if GICV3_SHADOW_REGS
+/*
+ * Shadow register mode.
+ *
+ * The driver tracks which banks of 32 SPIs may have been changed through its
+ * API since gicv3_distif_init(). The others still hold the boot defaults of
+ * gicv3_spis_config_defaults(): Group 1 NS, default priority, level, disabled
+ * and neither pending nor active, so they are saved without reading the
+ * Distributor and restored by writing the defaults only. Registers which
+ * reset to zero are not written back when they hold zero. ESPIs are always
+ * saved and restored in full.
+ *
+ * Changes made behind the driver's back, e.g. by writing the Distributor
+ * directly, are not seen. The pending state of an SPI of a clean bank is not
+ * preserved across a save and restore.
+ */
+static unsigned long gicd_dirty[BITS_TO_LONGS(GICD_NUM_REGS(IGROUPR))];
+
+/* SPI enables and priorities buffered between gicv3_batch_begin() and end */
+static struct {
+	bool active;
+	u_register_t owner;
+	uint32_t enable[GICD_NUM_REGS(ISENABLER)];
+	uint8_t priority[TOTAL_SPI_INTR_NUM];
+	DECLARE_BITMAP(priority_set, TOTAL_SPI_INTR_NUM);
+} gicv3_batch;
+
+static spinlock_t gicv3_batch_lock;
+
+#define SAVE_GICD_RANGE(base, ctx, from, to, reg, REG)			\
+	do {								\
+		for (unsigned int int_id = (from); int_id < (to);	\
+				int_id += (1U << REG##R_SHIFT)) {	\
+			(ctx)->gicd_##reg[(int_id - MIN_SPI_ID) >>	\
+			REG##R_SHIFT] = gicd_read_##reg((base), int_id); \
+		}							\
+	} while (false)
+
+#define FILL_GICD_RANGE(ctx, from, to, reg, REG, val)			\
+	do {								\
+		for (unsigned int int_id = (from); int_id < (to);	\
+				int_id += (1U << REG##R_SHIFT)) {	\
+			(ctx)->gicd_##reg[(int_id - MIN_SPI_ID) >>	\
+			REG##R_SHIFT] = (val);				\
+		}							\
+	} while (false)
+
+#define RESTORE_GICD_RANGE(base, ctx, from, to, reg, REG)		\
+	do {								\
+		for (unsigned int int_id = (from); int_id < (to);	\
+				int_id += (1U << REG##R_SHIFT)) {	\
+			gicd_write_##reg((base), int_id,		\
+				(ctx)->gicd_##reg[(int_id - MIN_SPI_ID) >> \
+							REG##R_SHIFT]);	\
+		}							\
+	} while (false)
+
+/* Same for registers which reset to zero, zero is not written back */
+#define RESTORE_GICD_RANGE_NZ(base, ctx, from, to, reg, REG)		\
+	do {								\
+		for (unsigned int int_id = (from); int_id < (to);	\
+				int_id += (1U << REG##R_SHIFT)) {	\
+			unsigned int n = (int_id - MIN_SPI_ID) >>	\
+					 REG##R_SHIFT;			\
+			if ((ctx)->gicd_##reg[n] != 0U) {		\
+				gicd_write_##reg((base), int_id,	\
+						 (ctx)->gicd_##reg[n]);	\
+			}						\
+		}							\
+	} while (false)
+
+#define RESTORE_GICR_REG_NZ(base, ctx, name, i)			\
+	do {								\
+		if ((ctx)->gicr_##name[(i)] != 0U) {			\
+			RESTORE_GICR_REG(base, ctx, name, i);		\
+		}							\
+	} while (false)
+
+static inline bool gicv3_is_tracked_spi(unsigned int id)
+{
+	return (id >= MIN_SPI_ID) && (id <= MAX_SPI_ID);
+}
+
+/* Bank 'id' belongs to may no longer hold its boot defaults */
+void gicv3_shadow_mark(unsigned int id)
+{
+	unsigned int bank;
+
+	if (!gicv3_is_tracked_spi(id)) {
+		return;
+	}
+
+	bank = (id - MIN_SPI_ID) >> IGROUPR_SHIFT;
+	(void)__atomic_fetch_or(&gicd_dirty[BIT_WORD(bank)], BIT_MASK(bank),
+				__ATOMIC_RELAXED);
+}
+
+static inline bool gicv3_bank_is_dirty(unsigned int bank)
+{
+	return (__atomic_load_n(&gicd_dirty[BIT_WORD(bank)], __ATOMIC_RELAXED) &
+		BIT_MASK(bank)) != 0UL;
+}
+
+/* Whether an operation on SPI 'id' goes to the batch of the calling CPU */
+static inline bool gicv3_batching(unsigned int id)
+{
+	return gicv3_batch.active && gicv3_is_tracked_spi(id) &&
+	       (gicv3_batch.owner == (read_mpidr() & MPIDR_AFFINITY_MASK));
+}
+
+static void gicv3_shadow_save_spis(uintptr_t gicd_base,
+				   gicv3_dist_ctx_t * const ctx,
+				   unsigned int num_ints)
+{
+	unsigned int from, to, bank;
+
+	for (from = MIN_SPI_ID; from < num_ints;
+	     from += (1U << IGROUPR_SHIFT)) {
+		to = MIN(from + (1U << IGROUPR_SHIFT), num_ints);
+		bank = (from - MIN_SPI_ID) >> IGROUPR_SHIFT;
+
+		if (!gicv3_bank_is_dirty(bank)) {
+			FILL_GICD_RANGE(ctx, from, to, igroupr, IGROUP, ~0U);
+			FILL_GICD_RANGE(ctx, from, to, isenabler, ISENABLE, 0U);
+			FILL_GICD_RANGE(ctx, from, to, ispendr, ISPEND, 0U);
+			FILL_GICD_RANGE(ctx, from, to, isactiver, ISACTIVE, 0U);
+			FILL_GICD_RANGE(ctx, from, to, ipriorityr, IPRIORITY,
+					GICD_IPRIORITYR_DEF_VAL);
+			FILL_GICD_RANGE(ctx, from, to, icfgr, ICFG, 0U);
+			FILL_GICD_RANGE(ctx, from, to, igrpmodr, IGRPMOD, 0U);
+			FILL_GICD_RANGE(ctx, from, to, nsacr, NSAC, 0U);
+			FILL_GICD_RANGE(ctx, from, to, irouter, IROUTE, 0U);
+			continue;
+		}
+
+		SAVE_GICD_RANGE(gicd_base, ctx, from, to, igroupr, IGROUP);
+		SAVE_GICD_RANGE(gicd_base, ctx, from, to, isenabler, ISENABLE);
+		SAVE_GICD_RANGE(gicd_base, ctx, from, to, ispendr, ISPEND);
+		SAVE_GICD_RANGE(gicd_base, ctx, from, to, isactiver, ISACTIVE);
+		SAVE_GICD_RANGE(gicd_base, ctx, from, to, ipriorityr, IPRIORITY);
+		SAVE_GICD_RANGE(gicd_base, ctx, from, to, icfgr, ICFG);
+		SAVE_GICD_RANGE(gicd_base, ctx, from, to, igrpmodr, IGRPMOD);
+		SAVE_GICD_RANGE(gicd_base, ctx, from, to, nsacr, NSAC);
+		SAVE_GICD_RANGE(gicd_base, ctx, from, to, irouter, IROUTE);
+	}
+}
+
+/*
+ * The Distributor is at its reset values. The configuration of every SPI is
+ * restored before any of them is enabled, made pending or active.
+ */
+static void gicv3_shadow_restore_spis(uintptr_t gicd_base,
+				      const gicv3_dist_ctx_t * const ctx,
+				      unsigned int num_ints)
+{
+	unsigned int from, to;
+
+	/* The boot defaults of clean banks are not the reset values */
+	for (from = MIN_SPI_ID; from < num_ints;
+	     from += (1U << IGROUPR_SHIFT)) {
+		to = MIN(from + (1U << IGROUPR_SHIFT), num_ints);
+
+		RESTORE_GICD_RANGE_NZ(gicd_base, ctx, from, to, igroupr,
+				      IGROUP);
+		RESTORE_GICD_RANGE_NZ(gicd_base, ctx, from, to, ipriorityr,
+				      IPRIORITY);
+		/* The reset value is IMPLEMENTATION DEFINED */
+		RESTORE_GICD_RANGE(gicd_base, ctx, from, to, icfgr, ICFG);
+
+		if (!gicv3_bank_is_dirty((from - MIN_SPI_ID) >> IGROUPR_SHIFT)) {
+			continue;
+		}
+
+		RESTORE_GICD_RANGE_NZ(gicd_base, ctx, from, to, igrpmodr,
+				      IGRPMOD);
+		RESTORE_GICD_RANGE_NZ(gicd_base, ctx, from, to, nsacr, NSAC);
+		/* The reset value is UNKNOWN */
+		RESTORE_GICD_RANGE(gicd_base, ctx, from, to, irouter, IROUTE);
+	}
+
+	for (from = MIN_SPI_ID; from < num_ints;
+	     from += (1U << IGROUPR_SHIFT)) {
+		to = MIN(from + (1U << IGROUPR_SHIFT), num_ints);
+		RESTORE_GICD_RANGE_NZ(gicd_base, ctx, from, to, isenabler,
+				      ISENABLE);
+	}
+
+	for (from = MIN_SPI_ID; from < num_ints;
+	     from += (1U << IGROUPR_SHIFT)) {
+		to = MIN(from + (1U << IGROUPR_SHIFT), num_ints);
+		RESTORE_GICD_RANGE_NZ(gicd_base, ctx, from, to, ispendr,
+				      ISPEND);
+		RESTORE_GICD_RANGE_NZ(gicd_base, ctx, from, to, isactiver,
+				      ISACTIVE);
+	}
+}
+
+/*******************************************************************************
+ * Start buffering the SPI enables and priority changes of the calling CPU.
+ * gicv3_batch_end() writes them with as few register writes as possible:
+ * one GICD_ISENABLER write per 32 SPIs and one GICD_IPRIORITYR write per 4
+ * SPIs. Other CPUs wait in gicv3_batch_begin() while a batch is open.
+ ******************************************************************************/
+void gicv3_batch_begin(void)
+{
+	spin_lock(&gicv3_batch_lock);
+
+	assert(!gicv3_batch.active);
+	gicv3_batch.owner = read_mpidr() & MPIDR_AFFINITY_MASK;
+	gicv3_batch.active = true;
+}
+
+void gicv3_batch_end(void)
+{
+	uintptr_t gicd_base = gicv3_driver_data->gicd_base;
+	unsigned int i, val;
+
+	assert(gicv3_batching(MIN_SPI_ID));
+
+	/* Priorities first, an SPI is never enabled at its old priority */
+	for_each_set_bit(i, gicv3_batch.priority_set, TOTAL_SPI_INTR_NUM) {
+		/* MIN_SPI_ID is a multiple of 4, so is the first SPI of a word */
+		if (((i & 3U) == 0U) && ((i + 3U) < TOTAL_SPI_INTR_NUM) &&
+		    test_bit(i + 1U, gicv3_batch.priority_set) &&
+		    test_bit(i + 2U, gicv3_batch.priority_set) &&
+		    test_bit(i + 3U, gicv3_batch.priority_set)) {
+			val = (unsigned int)gicv3_batch.priority[i] |
+			      ((unsigned int)gicv3_batch.priority[i + 1U] << 8) |
+			      ((unsigned int)gicv3_batch.priority[i + 2U] << 16) |
+			      ((unsigned int)gicv3_batch.priority[i + 3U] << 24);
+			gicd_write_ipriorityr(gicd_base, MIN_SPI_ID + i, val);
+			__clear_bit(i + 1U, gicv3_batch.priority_set);
+			__clear_bit(i + 2U, gicv3_batch.priority_set);
+			__clear_bit(i + 3U, gicv3_batch.priority_set);
+		} else {
+			gicd_set_ipriorityr(gicd_base, MIN_SPI_ID + i,
+					    gicv3_batch.priority[i]);
+		}
+	}
+	bitmap_zero(gicv3_batch.priority_set, TOTAL_SPI_INTR_NUM);
+
+	/*
+	 * Ensure that any shared variable updates depending on out of band
+	 * interrupt trigger are observed before enabling interrupts.
+	 */
+	dsbishst();
+
+	for (i = 0U; i < ARRAY_SIZE(gicv3_batch.enable); i++) {
+		if (gicv3_batch.enable[i] == 0U) {
+			continue;
+		}
+		gicd_write_isenabler(gicd_base,
+				     MIN_SPI_ID + (i << ISENABLER_SHIFT),
+				     gicv3_batch.enable[i]);
+		gicv3_batch.enable[i] = 0U;
+	}
+
+	gicv3_batch.active = false;
+	spin_unlock(&gicv3_batch_lock);
+}
+#endif /* GICV3_SHADOW_REGS */
+
 /*******************************************************************************
  * This function initialises the ARM GICv3 driver in EL3 with provided platform
  * inputs.
@@ -673,7 +937,11 @@ void gicv3_rdistif_init_restore(unsigned int proc_num,
 	/* 32 interrupt IDs per register */
 	for (i = 0U; i < ppi_regs_num; ++i) {
 		RESTORE_GICR_REG(gicr_base, rdist_ctx, igroupr, i);
+#if GICV3_SHADOW_REGS
+		RESTORE_GICR_REG_NZ(gicr_base, rdist_ctx, igrpmodr, i);
+#else
 		RESTORE_GICR_REG(gicr_base, rdist_ctx, igrpmodr, i);
+#endif
 	}
 
 	/* 4 interrupt IDs per GICR_IPRIORITYR register */
@@ -695,8 +963,14 @@ void gicv3_rdistif_init_restore(unsigned int proc_num,
 	 * 32 interrupt IDs per register
 	 */
 	for (i = 0U; i < ppi_regs_num; ++i) {
+#if GICV3_SHADOW_REGS
+		/* Writing zero to these does nothing */
+		RESTORE_GICR_REG_NZ(gicr_base, rdist_ctx, ispendr, i);
+		RESTORE_GICR_REG_NZ(gicr_base, rdist_ctx, isactiver, i);
+#else
 		RESTORE_GICR_REG(gicr_base, rdist_ctx, ispendr, i);
 		RESTORE_GICR_REG(gicr_base, rdist_ctx, isactiver, i);
+#endif
 	}
 
 	/*
@@ -707,7 +981,11 @@ void gicv3_rdistif_init_restore(unsigned int proc_num,
 
 	/* 32 interrupt IDs per GICR_ISENABLER register */
 	for (i = 0U; i < ppi_regs_num; ++i) {
+#if GICV3_SHADOW_REGS
+		RESTORE_GICR_REG_NZ(gicr_base, rdist_ctx, isenabler, i);
+#else
 		RESTORE_GICR_REG(gicr_base, rdist_ctx, isenabler, i);
+#endif
 	}
 
 	/*
@@ -743,6 +1021,13 @@ void gicv3_distif_save(gicv3_dist_ctx_t * const dist_ctx)
 	/* Save the GICD_CTLR */
 	dist_ctx->gicd_ctlr = gicd_read_ctlr(gicd_base);
 
+#if GICV3_SHADOW_REGS
+	gicv3_shadow_save_spis(gicd_base, dist_ctx, num_ints);
+
+	/* The SPIs are done, leave only the ESPIs to the loops below */
+	num_ints = MIN_SPI_ID;
+#endif
+
 	/* Save GICD_IGROUPR for INTIDs 32 - 1019 */
 	SAVE_GICD_REGS(gicd_base, dist_ctx, num_ints, igroupr, IGROUP);
 
@@ -838,6 +1123,14 @@ void gicv3_distif_init_restore(const gicv3_dist_ctx_t * const dist_ctx)
 #if GIC_EXT_INTID
 	unsigned int num_eints = gicv3_get_espi_limit(gicd_base);
 #endif
+
+#if GICV3_SHADOW_REGS
+	gicv3_shadow_restore_spis(gicd_base, dist_ctx, num_ints);
+
+	/* The SPIs are done, leave only the ESPIs to the loops below */
+	num_ints = MIN_SPI_ID;
+#endif
+
 	/* Restore GICD_IGROUPR for INTIDs 32 - 1019 */
 	RESTORE_GICD_REGS(gicd_base, dist_ctx, num_ints, igroupr, IGROUP);
 
@@ -947,6 +1240,15 @@ void gicv3_enable_interrupt(unsigned int id, unsigned int proc_num)
 	assert(proc_num < gicv3_driver_data->rdistif_num);
 	assert(gicv3_driver_data->rdistif_base_addrs != NULL);
 
+#if GICV3_SHADOW_REGS
+	gicv3_shadow_mark(id);
+	if (gicv3_batching(id)) {
+		gicv3_batch.enable[(id - MIN_SPI_ID) >> ISENABLER_SHIFT] |=
+			BIT_32(id & ((1U << ISENABLER_SHIFT) - 1U));
+		return;
+	}
+#endif
+
 	/*
 	 * Ensure that any shared variable updates depending on out of band
 	 * interrupt trigger are observed before enabling interrupt.
@@ -991,6 +1293,14 @@ void gicv3_disable_interrupt(unsigned int id, unsigned int proc_num)
 		gicr_wait_for_pending_write(
 			gicv3_driver_data->rdistif_base_addrs[proc_num]);
 	} else {
+#if GICV3_SHADOW_REGS
+		/* Drop an enable still buffered */
+		if (gicv3_batching(id)) {
+			gicv3_batch.enable[(id - MIN_SPI_ID) >>
+					   ISENABLER_SHIFT] &=
+				~BIT_32(id & ((1U << ISENABLER_SHIFT) - 1U));
+		}
+#endif
 		/* For SPIs: 32-1019 and ESPIs: 4096-5119 */
 		gicd_set_icenabler(gicv3_driver_data->gicd_base, id);
 
@@ -1021,6 +1331,15 @@ void gicv3_set_interrupt_priority(unsigned int id, unsigned int proc_num,
 		gicr_base = gicv3_driver_data->rdistif_base_addrs[proc_num];
 		gicr_set_ipriorityr(gicr_base, id, priority);
 	} else {
+#if GICV3_SHADOW_REGS
+		gicv3_shadow_mark(id);
+		if (gicv3_batching(id)) {
+			gicv3_batch.priority[id - MIN_SPI_ID] =
+				(uint8_t)(priority & GIC_PRI_MASK);
+			__set_bit(id - MIN_SPI_ID, gicv3_batch.priority_set);
+			return;
+		}
+#endif
 		/* For SPIs: 32-1019 and ESPIs: 4096-5119 */
 		gicd_set_ipriorityr(gicv3_driver_data->gicd_base, id, priority);
 	}
@@ -1072,6 +1391,8 @@ void gicv3_set_interrupt_type(unsigned int id, unsigned int proc_num,
 	} else {
 		/* For SPIs: 32-1019 and ESPIs: 4096-5119 */
 
+		gicv3_shadow_mark(id);
+
 		/* Serialize read-modify-write to Distributor registers */
 		spin_lock(&gic_lock);
 
@@ -1123,6 +1444,21 @@ void gicv3_raise_secure_g0_sgi(unsigned int sgi_num, u_register_t target)
 	isb();
 }
 
+/*******************************************************************************
+ * This function returns the affinity of the PE whose Redistributor is the one
+ * of linear index 'proc_num', as needed to target it with an SGI.
+ ******************************************************************************/
+u_register_t gicv3_rdistif_get_mpidr(unsigned int proc_num)
+{
+	assert(gicv3_driver_data != NULL);
+	assert(proc_num < gicv3_driver_data->rdistif_num);
+	assert(gicv3_driver_data->rdistif_base_addrs != NULL);
+	assert(gicv3_driver_data->rdistif_base_addrs[proc_num] != 0U);
+
+	return mpidr_from_gicr_typer(gicr_read_typer(
+			gicv3_driver_data->rdistif_base_addrs[proc_num]));
+}
+
 /*******************************************************************************
  * This function sets the interrupt routing for the given (E)SPI interrupt id.
  * The interrupt routing is specified in routing mode and mpidr.
@@ -1146,6 +1482,8 @@ void gicv3_set_spi_routing(unsigned int id, unsigned int irm, u_register_t mpidr
 
 	assert(IS_SPI(id));
 
+	gicv3_shadow_mark(id);
+
 	aff = gicd_irouter_val_from_mpidr(mpidr, irm);
 	gicd_write_irouter(gicv3_driver_data->gicd_base, id, aff);
 
@@ -1217,10 +1555,33 @@ void gicv3_set_interrupt_pending(unsigned int id, unsigned int proc_num)
 			gicv3_driver_data->rdistif_base_addrs[proc_num], id);
 	} else {
 		/* For SPIs: 32-1019 and ESPIs: 4096-5119 */
+		gicv3_shadow_mark(id);
 		gicd_set_ispendr(gicv3_driver_data->gicd_base, id);
 	}
 }
 
+/*******************************************************************************
+ * This function updates single interrupt configuration to be level/edge
+ * triggered. The proc_num is used if the interrupt is a PPI and programs the
+ * corresponding Redistributor interface.
+ ******************************************************************************/
+void gicv3_interrupt_set_cfg(unsigned int id, unsigned int proc_num,
+		unsigned int cfg)
+{
+	assert(gicv3_driver_data != NULL);
+	assert(gicv3_driver_data->gicd_base != 0U);
+	assert(proc_num < gicv3_driver_data->rdistif_num);
+	assert(gicv3_driver_data->rdistif_base_addrs != NULL);
+
+	if (is_sgi_ppi(id)) {
+		gicr_set_icfgr(
+			gicv3_driver_data->rdistif_base_addrs[proc_num], id, cfg);
+	} else {
+		gicv3_shadow_mark(id);
+		gicd_set_icfgr(gicv3_driver_data->gicd_base, id, cfg);
+	}
+}
+
 /*******************************************************************************
  * This function sets the PMR register with the supplied value. Returns the
  * original PMR.
@@ -250,6 +250,14 @@ void gicv3_rdistif_base_addrs_probe(uintptr_t *rdistif_base_addrs,
 void gicv3_rdistif_mark_core_awake(uintptr_t gicr_base);
 void gicv3_rdistif_mark_core_asleep(uintptr_t gicr_base);
 
+#if GICV3_SHADOW_REGS
+void gicv3_shadow_mark(unsigned int id);
+#else
+static inline void gicv3_shadow_mark(unsigned int id)
+{
+}
+#endif
+
 /*******************************************************************************
  * GIC Distributor interface accessors
  ******************************************************************************/
@@ -680,6 +688,16 @@ static inline void gits_write_cwriter(uintptr_t base, uint64_t val)
 	mmio_write_64(base + GITS_CWRITER, val);
 }
 
+static inline uint64_t gits_read_typer(uintptr_t base)
+{
+	return mmio_read_64(base + GITS_TYPER);
+}
+
+static inline uint64_t gits_read_creadr(uintptr_t base)
+{
+	return mmio_read_64(base + GITS_CREADR);
+}
+
 static inline uint64_t gits_read_baser(uintptr_t base,
 					unsigned int its_table_id)
 {
@@ -0,0 +1,283 @@
+/*
+ * Copyright (c) 2018-2020, ARM Limited and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <string.h>
+
+#include <arch_helpers.h>
+#include <cassert.h>
+#include <drivers/pl011/pl011.h>
+#include <mmio.h>
+#include <spinlock.h>
+
+/*
+ * Interrupt driven PL011 console.
+ *
+ * Both directions use a power-of-two software queue with free-running 'in' and
+ * 'out' indices. On the TX side the writer only blocks when the software queue
+ * is full; otherwise it pushes what fits into the hardware FIFO and leaves the
+ * rest to the TX interrupt, which is raised when the FIFO drops to 1/8 full.
+ * When the FIFO is known to be (nearly) empty it is filled in a single burst
+ * without polling UARTFR between characters.
+ */
+
+#define PL011_IRQ_TX_MASK	(PL011_IRQ_TX_BUF_SIZE - 1U)
+#define PL011_IRQ_RX_MASK	(PL011_IRQ_RX_BUF_SIZE - 1U)
+
+/* Free slots in the TX FIFO once the TX level interrupt (1/8) has fired. */
+#define PL011_IRQ_TX_BURST	(PL011_FIFO_DEPTH - (PL011_FIFO_DEPTH / 8))
+
+CASSERT(IS_POWER_OF_TWO(PL011_IRQ_TX_BUF_SIZE), assert_pl011_irq_tx_buf_pow2);
+CASSERT(IS_POWER_OF_TWO(PL011_IRQ_RX_BUF_SIZE), assert_pl011_irq_rx_buf_pow2);
+
+int console_pl011_core_init(uintptr_t base_addr, unsigned int uart_clk,
+			    unsigned int baud_rate);
+
+static inline console_pl011_irq_t *to_pl011_irq(console_t *console)
+{
+	return (console_pl011_irq_t *)console;
+}
+
+static inline unsigned int pl011_irq_tx_len(const console_pl011_irq_t *pl011)
+{
+	return pl011->tx_in - pl011->tx_out;
+}
+
+/*
+ * Move as much of the TX queue as possible to the hardware FIFO. Must be called
+ * with the console lock held.
+ */
+static void pl011_irq_tx_fill(console_pl011_irq_t *pl011)
+{
+	uintptr_t base = pl011->console.base;
+	unsigned int burst, out = pl011->tx_out;
+	uint32_t imsc;
+
+	if (pl011->tx_in == out)
+		goto done;
+
+	if ((mmio_read_32(base + UARTFR) & PL011_UARTFR_TXFE) != 0U)
+		burst = PL011_FIFO_DEPTH;
+	else if ((mmio_read_32(base + UARTRIS) & PL011_UARTIMSC_TXIM) != 0U)
+		burst = PL011_IRQ_TX_BURST;
+	else
+		burst = 0U;
+
+	/* The FIFO has at least 'burst' free slots, no need to poll UARTFR. */
+	while ((burst != 0U) && (pl011->tx_in != out)) {
+		mmio_write_32(base + UARTDR,
+			      (uint8_t)pl011->tx_buf[out & PL011_IRQ_TX_MASK]);
+		out++;
+		burst--;
+	}
+
+	/* Top the FIFO up one character at a time. */
+	while ((pl011->tx_in != out) &&
+	       ((mmio_read_32(base + UARTFR) & PL011_UARTFR_TXFF) == 0U)) {
+		mmio_write_32(base + UARTDR,
+			      (uint8_t)pl011->tx_buf[out & PL011_IRQ_TX_MASK]);
+		out++;
+	}
+
+	pl011->tx_out = out;
+
+done:
+	/* Only ask for the TX interrupt while there is something queued. */
+	imsc = mmio_read_32(base + UARTIMSC);
+	if (pl011->tx_in != pl011->tx_out)
+		imsc |= PL011_UARTIMSC_TXIM;
+	else
+		imsc &= ~PL011_UARTIMSC_TXIM;
+	mmio_write_32(base + UARTIMSC, imsc);
+}
+
+/* Push one character out of the TX queue by polling the FIFO. */
+static void pl011_irq_tx_poll(console_pl011_irq_t *pl011)
+{
+	uintptr_t base = pl011->console.base;
+
+	while ((mmio_read_32(base + UARTFR) & PL011_UARTFR_TXFF) != 0U)
+		;
+
+	mmio_write_32(base + UARTDR,
+		      (uint8_t)pl011->tx_buf[pl011->tx_out & PL011_IRQ_TX_MASK]);
+	pl011->tx_out++;
+}
+
+/* Drain the RX FIFO into the RX queue. Must be called with the lock held. */
+static void pl011_irq_rx_drain(console_pl011_irq_t *pl011)
+{
+	uintptr_t base = pl011->console.base;
+	uint32_t data;
+
+	while ((mmio_read_32(base + UARTFR) & PL011_UARTFR_RXFE) == 0U) {
+		data = mmio_read_32(base + UARTDR);
+		if ((data & UART_DATA_ERROR_MASK) != 0U)
+			continue;
+
+		if ((pl011->rx_in - pl011->rx_out) == PL011_IRQ_RX_BUF_SIZE) {
+			pl011->rx_overruns++;
+			continue;
+		}
+
+		pl011->rx_buf[pl011->rx_in & PL011_IRQ_RX_MASK] = (char)data;
+		pl011->rx_in++;
+	}
+}
+
+static int pl011_irq_write(const char *buf, size_t len, console_t *console)
+{
+	console_pl011_irq_t *pl011 = to_pl011_irq(console);
+	u_register_t daif;
+	size_t i;
+
+	assert(pl011 != NULL);
+
+	daif = read_daif();
+	disable_irq();
+	disable_fiq();
+	spin_lock(&pl011->lock);
+
+	for (i = 0U; i < len; i++) {
+		if (pl011_irq_tx_len(pl011) == PL011_IRQ_TX_BUF_SIZE) {
+			/* Make room in a burst rather than one at a time. */
+			pl011_irq_tx_fill(pl011);
+			if (pl011_irq_tx_len(pl011) == PL011_IRQ_TX_BUF_SIZE)
+				pl011_irq_tx_poll(pl011);
+		}
+
+		pl011->tx_buf[pl011->tx_in & PL011_IRQ_TX_MASK] = buf[i];
+		pl011->tx_in++;
+	}
+
+	pl011_irq_tx_fill(pl011);
+
+	spin_unlock(&pl011->lock);
+	write_daif(daif);
+
+	return (int)len;
+}
+
+static int pl011_irq_putc(int character, console_t *console)
+{
+	char c = (char)character;
+
+	(void)pl011_irq_write(&c, 1U, console);
+
+	return character;
+}
+
+static int pl011_irq_getc(console_t *console)
+{
+	console_pl011_irq_t *pl011 = to_pl011_irq(console);
+	u_register_t daif;
+	int ret = ERROR_NO_PENDING_CHAR;
+
+	assert(pl011 != NULL);
+
+	daif = read_daif();
+	disable_irq();
+	disable_fiq();
+	spin_lock(&pl011->lock);
+
+	/* Pick up anything that has not triggered the RX interrupt yet. */
+	if (pl011->rx_in == pl011->rx_out)
+		pl011_irq_rx_drain(pl011);
+
+	if (pl011->rx_in != pl011->rx_out) {
+		ret = (uint8_t)pl011->rx_buf[pl011->rx_out & PL011_IRQ_RX_MASK];
+		pl011->rx_out++;
+	}
+
+	spin_unlock(&pl011->lock);
+	write_daif(daif);
+
+	return ret;
+}
+
+static void pl011_irq_flush(console_t *console)
+{
+	console_pl011_irq_t *pl011 = to_pl011_irq(console);
+	uintptr_t base;
+	u_register_t daif;
+
+	assert(pl011 != NULL);
+
+	base = pl011->console.base;
+
+	daif = read_daif();
+	disable_irq();
+	disable_fiq();
+	spin_lock(&pl011->lock);
+
+	while (pl011->tx_in != pl011->tx_out)
+		pl011_irq_tx_poll(pl011);
+	pl011_irq_tx_fill(pl011);
+
+	while ((mmio_read_32(base + UARTFR) & PL011_UARTFR_BUSY) != 0U)
+		;
+
+	spin_unlock(&pl011->lock);
+	write_daif(daif);
+}
+
+void console_pl011_irq_handler(console_pl011_irq_t *console)
+{
+	uintptr_t base;
+	uint32_t mis;
+
+	assert(console != NULL);
+
+	base = console->console.base;
+
+	spin_lock(&console->lock);
+
+	mis = mmio_read_32(base + UARTMIS);
+
+	if ((mis & (PL011_UARTIMSC_RXIM | PL011_UARTIMSC_RTIM)) != 0U)
+		pl011_irq_rx_drain(console);
+
+	if ((mis & PL011_UARTIMSC_TXIM) != 0U)
+		pl011_irq_tx_fill(console);
+
+	/* The TX interrupt is cleared by refilling, or masked when idle. */
+	mmio_write_32(base + UARTICR, mis & ~PL011_UARTIMSC_TXIM);
+
+	spin_unlock(&console->lock);
+}
+
+static const console_t pl011_irq_console_template = {
+	.flags = CONSOLE_FLAG_BOOT | CONSOLE_FLAG_TRANSLATE_CRLF,
+	.putc = pl011_irq_putc,
+	.getc = pl011_irq_getc,
+	.flush = pl011_irq_flush,
+	.write = pl011_irq_write,
+};
+
+int console_pl011_irq_register(uintptr_t baseaddr, uint32_t clock,
+			       uint32_t baud, console_pl011_irq_t *console)
+{
+	if (console == NULL)
+		return 0;
+
+	if (console_pl011_core_init(baseaddr, clock, baud) == 0)
+		return 0;
+
+	memset(console, 0, sizeof(*console));
+	memcpy(&console->console, &pl011_irq_console_template,
+	       sizeof(console->console));
+	console->console.base = baseaddr;
+
+	/* Raise TX when the FIFO is 1/8 full and RX when it is half full. */
+	mmio_write_32(baseaddr + UARTIFLS,
+		      PL011_UARTIFLS_TX_1_8 | PL011_UARTIFLS_RX_1_2);
+	mmio_write_32(baseaddr + UARTICR, PL011_UARTIMSC_ALL);
+	mmio_write_32(baseaddr + UARTIMSC,
+		      PL011_UARTIMSC_RXIM | PL011_UARTIMSC_RTIM);
+
+	return console_register(&console->console);
+}
@@ -138,6 +138,7 @@ static inline void cm_set_world_context_by_index(unsigned int cpu_idx, void *con
 
 uintptr_t cm_get_curr_stack(void);
 uintptr_t cm_get_curr_process(void);
+uintptr_t cm_prepare_exit_process(void);
 /*******************************************************************************
  * Function & variable prototypes
  ******************************************************************************/
@@ -103,6 +103,7 @@ void __dead2 do_panic(void);
 #define panic()				\
 	do {				\
 		backtrace(__func__);	\
+		console_ring_emergency();	\
 		console_flush();	\
 		do_panic();		\
 	} while (false)
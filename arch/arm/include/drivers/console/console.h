@@ -14,8 +14,9 @@
 #define CONSOLE_T_PUTC			(U(2) * REGSZ)
 #define CONSOLE_T_GETC			(U(3) * REGSZ)
 #define CONSOLE_T_FLUSH			(U(4) * REGSZ)
-#define CONSOLE_T_BASE			(U(5) * REGSZ)
-#define CONSOLE_T_DRVDATA		(U(6) * REGSZ)
+#define CONSOLE_T_WRITE			(U(5) * REGSZ)
+#define CONSOLE_T_BASE			(U(6) * REGSZ)
+#define CONSOLE_T_DRVDATA		(U(7) * REGSZ)
 
 #define CONSOLE_FLAG_BOOT		(U(1) << 0)
 #define CONSOLE_FLAG_RUNTIME		(U(1) << 1)
@@ -32,6 +33,7 @@
 
 #ifndef __ASSEMBLER__
 
+#include <stddef.h>
 #include <stdint.h>
 
 typedef struct console {
@@ -44,6 +46,11 @@ typedef struct console {
 	int (*const putc)(int character, struct console *console);
 	int (*const getc)(struct console *console);
 	void (*const flush)(struct console *console);
+	/*
+	 * Optional. Output 'len' characters from 'buf' in one go and return the
+	 * number of characters written, or a negative error code.
+	 */
+	int (*const write)(const char *buf, size_t len, struct console *console);
 	uintptr_t base;
 	/* Additional private driver data may follow here. */
 } console_t;
@@ -73,11 +80,30 @@ void console_set_scope(console_t *console, unsigned int scope);
 void console_switch_state(unsigned int new_state);
 /* Output a character on all consoles registered for the current state. */
 int console_putc(int c);
+/*
+ * Output a buffer on all consoles registered for the current state. Consoles
+ * without a write callback fall back to one putc call per character.
+ */
+int console_write(const char *buf, size_t len);
 /* Read a character (blocking) from any console registered for current state. */
 int console_getc(void);
 /* Flush all consoles registered for the current state. */
 void console_flush(void);
 
+/*
+ * Defer console output to per-CPU log rings. console_putc() and
+ * console_write() then only append to the ring of the calling CPU, and the
+ * characters reach the consoles when console_ring_drain() runs, e.g. from the
+ * idle loop.
+ */
+void console_ring_enable(void);
+/* Write out the records queued on all CPUs. */
+void console_ring_drain(void);
+/* Drain all rings without locking and go back to synchronous output. */
+void console_ring_emergency(void);
+/* Number of records dropped because a ring was full or busy. */
+unsigned int console_ring_dropped(void);
+
 #endif /* __ASSEMBLER__ */
 
 #endif /* CONSOLE_H */
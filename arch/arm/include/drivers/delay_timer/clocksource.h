@@ -0,0 +1,98 @@
+/*
+ * Copyright (c) 2015-2022, ARM Limited and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef CLOCKSOURCE_H
+#define CLOCKSOURCE_H
+
+#include <stdint.h>
+
+#include <utils.h>
+
+/********************************************************************
+ * A free-running counter together with precomputed fixed-point
+ * conversion factors, so that converting between counter cycles and
+ * nanoseconds on hot paths is a multiply and a shift, never a divide:
+ *
+ *   ns     = (cycles * mult) >> shift
+ *   cycles = (ns * inv_mult) >> inv_shift
+ *
+ * Counter values are masked to 'mask', so deltas computed with
+ * clocksource_delta() stay correct across a wrap of the counter.
+ ********************************************************************/
+
+#define NSEC_PER_USEC		U(1000)
+#define NSEC_PER_SEC		U(1000000000)
+
+#define CLOCKSOURCE_MASK(bits)	\
+	(((bits) >= 64U) ? UINT64_MAX : ((ULL(1) << (bits)) - 1U))
+
+typedef struct clocksource {
+	uint64_t (*read)(void);
+	uint64_t mask;
+	uint32_t freq;
+	/* cycles -> ns */
+	uint32_t mult;
+	uint32_t shift;
+	/* ns -> cycles */
+	uint32_t inv_mult;
+	uint32_t inv_shift;
+} clocksource_t;
+
+/*
+ * Compute (a * mul) >> shift for shift <= 32 without overflowing 64 bits,
+ * using two 32x32->64 multiplies.
+ */
+static inline uint64_t mul_u64_u32_shr(uint64_t a, uint32_t mul,
+				       unsigned int shift)
+{
+	uint32_t al = (uint32_t)a;
+	uint32_t ah = (uint32_t)(a >> 32);
+	uint64_t ret;
+
+	ret = ((uint64_t)al * mul) >> shift;
+	if (ah != 0U)
+		ret += ((uint64_t)ah * mul) << (32U - shift);
+
+	return ret;
+}
+
+static inline uint64_t clocksource_read(const clocksource_t *cs)
+{
+	return cs->read() & cs->mask;
+}
+
+static inline uint64_t clocksource_delta(const clocksource_t *cs,
+					 uint64_t now, uint64_t then)
+{
+	return (now - then) & cs->mask;
+}
+
+static inline uint64_t clocksource_cyc2ns(const clocksource_t *cs,
+					  uint64_t cycles)
+{
+	return mul_u64_u32_shr(cycles, cs->mult, cs->shift);
+}
+
+static inline uint64_t clocksource_ns2cyc(const clocksource_t *cs,
+					  uint64_t ns)
+{
+	return mul_u64_u32_shr(ns, cs->inv_mult, cs->inv_shift);
+}
+
+static inline uint64_t clocksource_us2cyc(const clocksource_t *cs,
+					  uint32_t us)
+{
+	return clocksource_ns2cyc(cs, (uint64_t)us * NSEC_PER_USEC);
+}
+
+void clocks_calc_mult_shift(uint32_t *mult, uint32_t *shift, uint32_t from,
+			    uint32_t to, uint32_t maxsec);
+void clocksource_init(clocksource_t *cs, uint64_t (*read)(void),
+		      unsigned int bits, uint32_t freq);
+void clocksource_register(clocksource_t *cs);
+const clocksource_t *clocksource_get(void);
+
+#endif /* CLOCKSOURCE_H */
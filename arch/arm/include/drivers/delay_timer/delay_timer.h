@@ -12,6 +12,7 @@
 #include <stdint.h>
 
 #include <arch_helpers.h>
+#include <drivers/delay_timer/clocksource.h>
 
 /********************************************************************
  * A simple timer driver providing synchronous delay functionality.
@@ -29,6 +30,12 @@ typedef struct timer_ops {
 
 static inline uint64_t timeout_cnt_us2cnt(uint32_t us)
 {
+	const clocksource_t *cs = clocksource_get();
+
+	/* The registered clocksource converts without a 64-bit divide. */
+	if (cs != NULL)
+		return clocksource_us2cyc(cs, us);
+
 	return ((uint64_t)us * (uint64_t)read_cntfrq_el0()) / 1000000ULL;
 }
 
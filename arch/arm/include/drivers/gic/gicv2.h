@@ -186,11 +186,14 @@ void gicv2_disable_interrupt(unsigned int id);
 void gicv2_set_interrupt_priority(unsigned int id, unsigned int priority);
 void gicv2_set_interrupt_type(unsigned int id, unsigned int type);
 void gicv2_raise_sgi(int sgi_num, int proc_num);
+void gicv2_raise_sgi_many(int sgi_num, const unsigned long *procs,
+			  unsigned int nr_procs);
 void gicv2_set_spi_routing(unsigned int id, int proc_num);
 void gicv2_set_interrupt_pending(unsigned int id);
 void gicv2_clear_interrupt_pending(unsigned int id);
 unsigned int gicv2_set_pmr(unsigned int mask);
 void gicv2_interrupt_set_cfg(unsigned int id, unsigned int cfg);
+void gicv2_irq_chip_init(void);
 
 #endif /* __ASSEMBLER__ */
 #endif /* GICV2_H */
@@ -7,6 +7,14 @@
 #ifndef GICV3_H
 #define GICV3_H
 
+/*
+ * Track the Distributor banks changed since boot, so that save and restore
+ * skip the others, and allow batching SPI enables and priorities.
+ */
+#ifndef GICV3_SHADOW_REGS
+#define GICV3_SHADOW_REGS	0
+#endif
+
 /*******************************************************************************
  * GICv3 and 3.1 miscellaneous definitions
  ******************************************************************************/
@@ -274,6 +282,8 @@
 #define SGIR_INTID_MASK			ULL(0xf)
 #define SGIR_AFF2_SHIFT			32
 #define SGIR_IRM_SHIFT			40
+#define SGIR_RS_SHIFT			44
+#define SGIR_RS_MASK			ULL(0xf)
 #define SGIR_IRM_MASK			ULL(0x1)
 #define SGIR_AFF3_SHIFT			48
 #define SGIR_AFF_MASK			ULL(0xf)
@@ -298,13 +308,126 @@
 #define GITS_CWRITER			U(0x88)
 #define GITS_CREADR			U(0x90)
 #define GITS_BASER			U(0x100)
+#define GITS_TRANSLATER			U(0x10040)
 
 /* GITS_CTLR bit definitions */
 #define GITS_CTLR_ENABLED_BIT		BIT_32(0)
 #define GITS_CTLR_QUIESCENT_BIT		BIT_32(1)
 
+/* GITS_TYPER bit definitions */
+#define GITS_TYPER_ITT_ENTRY_SIZE_SHIFT	U(4)
+#define GITS_TYPER_ITT_ENTRY_SIZE_MASK	U(0xf)
+#define GITS_TYPER_IDBITS_SHIFT		U(8)
+#define GITS_TYPER_IDBITS_MASK		U(0x1f)
+#define GITS_TYPER_DEVBITS_SHIFT	U(13)
+#define GITS_TYPER_DEVBITS_MASK		U(0x1f)
+#define GITS_TYPER_PTA			BIT_64(19)
+#define GITS_TYPER_HCC_SHIFT		U(24)
+#define GITS_TYPER_HCC_MASK		U(0xff)
 #define GITS_TYPER_VSGI			BIT_64(39)
 
+/* GITS_BASER<n> bit definitions */
+#define GITS_BASER_NR			U(8)
+#define GITS_BASER_SIZE_MASK		U(0xff)
+#define GITS_BASER_PAGE_SIZE_SHIFT	U(8)
+#define GITS_BASER_PAGE_SIZE_4K		U(0)
+#define GITS_BASER_SHARE_SHIFT		U(10)
+#define GITS_BASER_PA_MASK		GENMASK_64(47, 12)
+#define GITS_BASER_ENTRY_SIZE_SHIFT	U(48)
+#define GITS_BASER_ENTRY_SIZE_MASK	U(0x1f)
+#define GITS_BASER_OUTER_CACHE_SHIFT	U(53)
+#define GITS_BASER_TYPE_SHIFT		U(56)
+#define GITS_BASER_TYPE_MASK		U(0x7)
+#define GITS_BASER_INNER_CACHE_SHIFT	U(59)
+#define GITS_BASER_INDIRECT		BIT_64(62)
+#define GITS_BASER_VALID		BIT_64(63)
+
+#define GITS_BASER_TYPE_NONE		U(0)
+#define GITS_BASER_TYPE_DEVICE		U(1)
+#define GITS_BASER_TYPE_COLLECTION	U(4)
+
+/* GITS_CBASER bit definitions */
+#define GITS_CBASER_SIZE_MASK		U(0xff)
+#define GITS_CBASER_SHARE_SHIFT		U(10)
+#define GITS_CBASER_PA_MASK		GENMASK_64(51, 12)
+#define GITS_CBASER_OUTER_CACHE_SHIFT	U(53)
+#define GITS_CBASER_INNER_CACHE_SHIFT	U(59)
+#define GITS_CBASER_VALID		BIT_64(63)
+
+/* GITS_CWRITER and GITS_CREADR bit definitions */
+#define GITS_CQ_OFFSET_MASK		GENMASK_64(19, 5)
+#define GITS_CREADR_STALLED		BIT_64(0)
+
+/* GICR_PROPBASER and GICR_PENDBASER bit definitions */
+#define GICR_PROPBASER_IDBITS_MASK	U(0x1f)
+#define GICR_PROPBASER_PA_MASK		GENMASK_64(51, 12)
+#define GICR_PENDBASER_PA_MASK		GENMASK_64(51, 16)
+#define GICR_PENDBASER_PTZ		BIT_64(62)
+#define GICR_BASER_INNER_CACHE_SHIFT	U(7)
+#define GICR_BASER_SHARE_SHIFT		U(10)
+#define GICR_BASER_OUTER_CACHE_SHIFT	U(56)
+
+/* Cacheability and shareability fields of the GITS and GICR table bases */
+#define GIC_BASER_CACHE_SAME_AS_INNER	U(0)
+#define GIC_BASER_CACHE_NC		U(1)
+#define GIC_BASER_CACHE_RAWAWB		U(7)
+#define GIC_BASER_CACHE_MASK		U(0x7)
+#define GIC_BASER_SHARE_NS		U(0)
+#define GIC_BASER_SHARE_IS		U(1)
+#define GIC_BASER_SHARE_MASK		U(0x3)
+
+/* LPI configuration table entry */
+#define LPI_PROP_ENABLE			BIT_32(0)
+#define LPI_PROP_RES1			BIT_32(1)
+#define LPI_PROP_PRIORITY_MASK		U(0xfc)
+
+/*******************************************************************************
+ * GICv3 virtual CPU interface control registers & constants
+ ******************************************************************************/
+/* ICH_HCR_EL2 bit definitions */
+#define ICH_HCR_EN_BIT			BIT_64(0)
+#define ICH_HCR_UIE_BIT			BIT_64(1)
+#define ICH_HCR_LRENPIE_BIT		BIT_64(2)
+#define ICH_HCR_NPIE_BIT		BIT_64(3)
+
+/* ICH_VTR_EL2 bit definitions */
+#define ICH_VTR_LISTREGS_MASK		U(0x1f)
+#define ICH_VTR_PREBITS_SHIFT		26
+#define ICH_VTR_PREBITS_MASK		U(0x7)
+#define ICH_VTR_PRIBITS_SHIFT		29
+#define ICH_VTR_PRIBITS_MASK		U(0x7)
+
+/* ICH_MISR_EL2 bit definitions */
+#define ICH_MISR_EOI_BIT		BIT_32(0)
+#define ICH_MISR_U_BIT			BIT_32(1)
+#define ICH_MISR_LRENP_BIT		BIT_32(2)
+#define ICH_MISR_NP_BIT			BIT_32(3)
+
+/* ICH_VMCR_EL2 bit definitions */
+#define ICH_VMCR_VENG1_BIT		BIT_64(1)
+#define ICH_VMCR_VPMR_SHIFT		24
+#define ICH_VMCR_VPMR_MASK		ULL(0xff)
+
+/* ICH_LR<n>_EL2 bit definitions */
+#define ICH_LR_VINTID_MASK		ULL(0xffffffff)
+#define ICH_LR_PINTID_SHIFT		32
+#define ICH_LR_PINTID_MASK		ULL(0x3ff)
+/* Maintenance interrupt on EOI, when ICH_LR_HW_BIT is clear */
+#define ICH_LR_EOI_BIT			BIT_64(41)
+#define ICH_LR_PRIORITY_SHIFT		48
+#define ICH_LR_PRIORITY_MASK		ULL(0xff)
+#define ICH_LR_GROUP_BIT		BIT_64(60)
+#define ICH_LR_HW_BIT			BIT_64(61)
+#define ICH_LR_STATE_SHIFT		62
+#define ICH_LR_STATE_MASK		ULL(0x3)
+#define ICH_LR_STATE_INVALID		ULL(0x0)
+#define ICH_LR_STATE_PENDING		ULL(0x1)
+#define ICH_LR_STATE_ACTIVE		ULL(0x2)
+#define ICH_LR_STATE_PENDING_ACTIVE	ULL(0x3)
+
+/* GICv3 maintenance interrupt on QEMU and Arm reference platforms, PPI 9 */
+#define GICV3_MAINT_INTID		U(25)
+
 #ifndef __ASSEMBLER__
 
 #include <stdbool.h>
@@ -537,11 +660,19 @@ void gicv3_set_interrupt_priority(unsigned int id, unsigned int proc_num,
 void gicv3_set_interrupt_type(unsigned int id, unsigned int proc_num,
 		unsigned int type);
 void gicv3_raise_secure_g0_sgi(unsigned int sgi_num, u_register_t target);
+u_register_t gicv3_rdistif_get_mpidr(unsigned int proc_num);
 void gicv3_set_spi_routing(unsigned int id, unsigned int irm,
 		u_register_t mpidr);
 void gicv3_set_interrupt_pending(unsigned int id, unsigned int proc_num);
 void gicv3_clear_interrupt_pending(unsigned int id, unsigned int proc_num);
 unsigned int gicv3_set_pmr(unsigned int mask);
+void gicv3_interrupt_set_cfg(unsigned int id, unsigned int proc_num,
+		unsigned int cfg);
+#if GICV3_SHADOW_REGS
+void gicv3_batch_begin(void);
+void gicv3_batch_end(void);
+#endif
+void gicv3_irq_chip_init(void);
 
 #endif /* __ASSEMBLER__ */
 #endif /* GICV3_H */
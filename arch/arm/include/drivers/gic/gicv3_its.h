@@ -0,0 +1,91 @@
+/*
+ * Copyright (c) 2015-2022, ARM Limited and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef GICV3_ITS_H
+#define GICV3_ITS_H
+
+/*******************************************************************************
+ * GICv3 ITS driver.
+ *
+ * The driver owns the LPI configuration table, the per-CPU LPI pending tables
+ * and the ITS device, collection and command tables, all of them statically
+ * allocated. Each CPU has one collection, whose ID is its linear index.
+ *
+ * Commands are written to the command queue but only published to the ITS
+ * when the current batch ends. A batch issues one SYNC per collection it
+ * touched, turns the INVs of many LPIs into one INVALL per collection and
+ * cleans each dirty line of the configuration table once. Every API call
+ * below is a batch of its own unless made between gicv3_its_batch_begin()
+ * and gicv3_its_batch_end(). Interrupts stay masked on the calling CPU while
+ * a batch is open.
+ ******************************************************************************/
+
+/* Build the ITS driver */
+#ifndef GICV3_ITS_SUPPORT
+#define GICV3_ITS_SUPPORT		0
+#endif
+
+/* Number of LPIs handed out by the allocator, a power of two >= 8192 */
+#ifndef GICV3_ITS_NR_LPIS
+#define GICV3_ITS_NR_LPIS		U(8192)
+#endif
+
+/* Number of devices that can be mapped at the same time */
+#ifndef GICV3_ITS_MAX_DEVICES
+#define GICV3_ITS_MAX_DEVICES		U(32)
+#endif
+
+/* Size of the pool the Interrupt Translation Tables are taken from */
+#ifndef GICV3_ITS_ITT_POOL_SIZE
+#define GICV3_ITS_ITT_POOL_SIZE		U(0x10000)
+#endif
+
+/* A batch invalidating more LPIs than this issues INVALLs instead */
+#ifndef GICV3_ITS_INVALL_THRESHOLD
+#define GICV3_ITS_INVALL_THRESHOLD	U(32)
+#endif
+
+/* Default priority of the LPIs */
+#ifndef GICV3_ITS_LPI_PRIORITY
+#define GICV3_ITS_LPI_PRIORITY		U(0xa0)
+#endif
+
+/* Build gicv3_its_selftest(), which injects LPIs through the ITS on QEMU */
+#ifndef GICV3_ITS_SELFTEST
+#define GICV3_ITS_SELFTEST		0
+#endif
+
+#ifndef __ASSEMBLER__
+
+#include <stdint.h>
+
+#if GICV3_ITS_SUPPORT
+
+int gicv3_its_init(uintptr_t gits_base);
+void gicv3_its_cpu_init(unsigned int proc_num);
+
+void gicv3_its_batch_begin(void);
+void gicv3_its_batch_end(void);
+
+int gicv3_its_device_map(uint32_t devid, unsigned int nr_events,
+			 unsigned int *lpi_base);
+int gicv3_its_device_unmap(uint32_t devid);
+uintptr_t gicv3_its_doorbell(void);
+
+void gicv3_its_lpi_enable(unsigned int lpi);
+void gicv3_its_lpi_disable(unsigned int lpi);
+void gicv3_its_lpi_set_priority(unsigned int lpi, unsigned int priority);
+int gicv3_its_lpi_set_affinity(unsigned int lpi, unsigned int proc_num);
+int gicv3_its_lpi_inject(unsigned int lpi);
+
+#if GICV3_ITS_SELFTEST
+int gicv3_its_selftest(void);
+#endif
+
+#endif /* GICV3_ITS_SUPPORT */
+
+#endif /* __ASSEMBLER__ */
+#endif /* GICV3_ITS_H */
@@ -48,9 +48,26 @@
 #define PL011_UARTFR_CTS          (1 << 0)	/* Clear to send */
 
 #define PL011_UARTFR_TXFF_BIT	5	/* Transmit FIFO full bit in UARTFR register */
+#define PL011_UARTFR_TXFE_BIT	7	/* Transmit FIFO empty bit in UARTFR register */
 #define PL011_UARTFR_RXFE_BIT	4	/* Receive FIFO empty bit in UARTFR register */
 #define PL011_UARTFR_BUSY_BIT	3	/* UART busy bit in UARTFR register */
 
+/* Interrupt mask, raw/masked status and clear reg bits */
+#define PL011_UARTIMSC_OEIM       (1 << 10)	/* Overrun error */
+#define PL011_UARTIMSC_BEIM       (1 << 9)	/* Break error */
+#define PL011_UARTIMSC_PEIM       (1 << 8)	/* Parity error */
+#define PL011_UARTIMSC_FEIM       (1 << 7)	/* Framing error */
+#define PL011_UARTIMSC_RTIM       (1 << 6)	/* Receive timeout */
+#define PL011_UARTIMSC_TXIM       (1 << 5)	/* Transmit */
+#define PL011_UARTIMSC_RXIM       (1 << 4)	/* Receive */
+#define PL011_UARTIMSC_ALL        0x7FF
+
+/*
+ * Depth of the transmit and receive FIFOs. 32 from r1p5 on, 16 before: the
+ * smaller one is assumed, as the revision is not probed.
+ */
+#define PL011_FIFO_DEPTH          16
+
 /* Control reg bits */
 #if !PL011_GENERIC_UART
 #define PL011_UARTCR_CTSEN        (1 << 15)	/* CTS hardware flow control enable */
@@ -79,12 +96,26 @@
 #define PL011_UARTLCR_H_PEN       (1 << 1)	/* Parity Enable */
 #define PL011_UARTLCR_H_BRK       (1 << 0)	/* Send break */
 
+/* Interrupt FIFO level select reg bits */
+#define PL011_UARTIFLS_RX_1_8     (0 << 3)
+#define PL011_UARTIFLS_RX_1_4     (1 << 3)
+#define PL011_UARTIFLS_RX_1_2     (2 << 3)
+#define PL011_UARTIFLS_RX_3_4     (3 << 3)
+#define PL011_UARTIFLS_RX_7_8     (4 << 3)
+#define PL011_UARTIFLS_TX_1_8     (0 << 0)
+#define PL011_UARTIFLS_TX_1_4     (1 << 0)
+#define PL011_UARTIFLS_TX_1_2     (2 << 0)
+#define PL011_UARTIFLS_TX_3_4     (3 << 0)
+#define PL011_UARTIFLS_TX_7_8     (4 << 0)
+
 #endif /* !PL011_GENERIC_UART */
 
 #ifndef __ASSEMBLER__
 
 #include <stdint.h>
 
+#include <spinlock.h>
+
 /*
  * Initialize a new PL011 console instance and register it with the console
  * framework. The |console| pointer must point to storage that will be valid
@@ -94,6 +125,49 @@
 int console_pl011_register(uintptr_t baseaddr, uint32_t clock, uint32_t baud,
 			   console_t *console);
 
+/*
+ * Size of the software queues of the interrupt driven PL011 console. Both
+ * must be powers of two.
+ */
+#ifndef PL011_IRQ_TX_BUF_SIZE
+#define PL011_IRQ_TX_BUF_SIZE		1024
+#endif
+#ifndef PL011_IRQ_RX_BUF_SIZE
+#define PL011_IRQ_RX_BUF_SIZE		256
+#endif
+
+/*
+ * Interrupt driven PL011 console. Output is queued in 'tx_buf' and moved to
+ * the hardware FIFO in bursts, either by the writer when the FIFO has room or
+ * by console_pl011_irq_handler() once the TX level interrupt reports that the
+ * FIFO has drained. Received characters are moved to 'rx_buf' by the RX and
+ * RX timeout interrupts.
+ */
+typedef struct console_pl011_irq {
+	console_t console;
+	spinlock_t lock;
+	volatile unsigned int tx_in;
+	volatile unsigned int tx_out;
+	volatile unsigned int rx_in;
+	volatile unsigned int rx_out;
+	unsigned int rx_overruns;
+	char tx_buf[PL011_IRQ_TX_BUF_SIZE];
+	char rx_buf[PL011_IRQ_RX_BUF_SIZE];
+} console_pl011_irq_t;
+
+/*
+ * Initialize a PL011 in interrupt driven mode and register it with the console
+ * framework. As for console_pl011_register(), |console| must be persistent.
+ * The UART interrupt must be routed to console_pl011_irq_handler() by the
+ * caller; until it is, output is still pushed out by polling when the queue
+ * fills up or on flush.
+ */
+int console_pl011_irq_register(uintptr_t baseaddr, uint32_t clock,
+			       uint32_t baud, console_pl011_irq_t *console);
+
+/* Service the TX level, RX and RX timeout interrupts of the UART. */
+void console_pl011_irq_handler(console_pl011_irq_t *console);
+
 #endif /*__ASSEMBLER__*/
 
 #endif /* PL011_H */
@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2013-2022, Arm Limited and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef HRTIMER_H
+#define HRTIMER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <linux/rbtree.h>
+
+/*******************************************************************************
+ * High resolution timers on the ARM generic timer.
+ *
+ * Every CPU keeps its pending timers in a leftmost-cached rbtree ordered by
+ * expiry time, and programs the compare register of its own timer with the
+ * earliest deadline only (one-shot, no periodic tick). A timer is never run
+ * before its expiry, but it may be run up to HRTIMER_BATCH_NS after it: the
+ * compare register is programmed with the last expiry within that window of
+ * the earliest one, so that closely spaced timers are run from the same
+ * interrupt.
+ *
+ * Times are absolute nanoseconds of hrtimer_now(), which counts from the
+ * system counter reset.
+ ******************************************************************************/
+
+/* Slack a timer may be delayed by to share an interrupt with later ones */
+#ifndef HRTIMER_BATCH_NS
+#define HRTIMER_BATCH_NS	ULL(50000)
+#endif
+
+/* Use the EL1 physical timer (CNTP) instead of the virtual one (CNTV) */
+#ifndef HRTIMER_USE_CNTP
+#define HRTIMER_USE_CNTP	0
+#endif
+
+/* Generic timer PPI, the EL1 physical or the virtual timer one */
+#ifndef HRTIMER_PPI
+#if HRTIMER_USE_CNTP
+#define HRTIMER_PPI		U(30)
+#else
+#define HRTIMER_PPI		U(27)
+#endif
+#endif
+
+/* Build hrtimer_jitter_bench(), a timer latency benchmark for QEMU */
+#ifndef HRTIMER_JITTER_BENCH
+#define HRTIMER_JITTER_BENCH	0
+#endif
+
+/* Compare value meaning "no timer pending" */
+#define HRTIMER_EXPIRES_NEVER	UINT64_MAX
+
+typedef enum hrtimer_restart {
+	HRTIMER_NORESTART = 0,
+	HRTIMER_RESTART
+} hrtimer_restart_t;
+
+struct hrtimer_cpu_base;
+
+typedef struct hrtimer {
+	struct rb_node node;
+	/* Absolute expiry time in nanoseconds */
+	uint64_t expires;
+	/*
+	 * Called from the timer interrupt with the base unlocked. Returning
+	 * HRTIMER_RESTART re-queues the timer at its (updated) expiry time.
+	 */
+	hrtimer_restart_t (*function)(struct hrtimer *timer);
+	/* Base the timer is queued on, NULL if it is idle */
+	struct hrtimer_cpu_base *base;
+} hrtimer_t;
+
+void hrtimer_init(hrtimer_t *timer,
+		  hrtimer_restart_t (*function)(hrtimer_t *timer));
+void hrtimer_start(hrtimer_t *timer, uint64_t expires);
+void hrtimer_start_rel(hrtimer_t *timer, uint64_t delta);
+bool hrtimer_cancel(hrtimer_t *timer);
+uint64_t hrtimer_forward(hrtimer_t *timer, uint64_t now, uint64_t interval);
+
+static inline bool hrtimer_is_queued(const hrtimer_t *timer)
+{
+	return timer->base != NULL;
+}
+
+struct clocksource;
+
+uint64_t hrtimer_now(void);
+const struct clocksource *hrtimer_clocksource(void);
+uint64_t hrtimer_next_event(void);
+
+void hrtimer_setup(void);
+void hrtimer_cpu_setup(void);
+void hrtimer_interrupt(void);
+void hrtimer_idle_enter(void);
+
+#if HRTIMER_JITTER_BENCH
+void hrtimer_jitter_bench(uint64_t period, unsigned int loops);
+#endif
+
+#endif /* HRTIMER_H */
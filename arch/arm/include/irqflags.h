@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2013-2022, Arm Limited and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef IRQFLAGS_H
+#define IRQFLAGS_H
+
+#include <stdbool.h>
+
+#include <arch.h>
+#include <arch_helpers.h>
+#include <irq.h>
+
+/*******************************************************************************
+ * Local interrupt masking.
+ *
+ * By default these set and restore PSTATE.I like disable_irq() and
+ * write_daif(). With IRQ_PSEUDO_NMI they write the GICv3 priority mask
+ * instead: every line of IRQ_PRIO_HARD or lower priority is held back by the
+ * CPU interface, while lines of IRQ_PRIO_NMI still interrupt the CPU. This
+ * lets a profiler sample, or a watchdog catch, a CPU spinning with interrupts
+ * masked. The saved flags are then the previous priority mask.
+ *
+ * disable_irq() keeps masking everything, e.g. around wfi or on the exception
+ * paths, and interrupt handlers always run with PSTATE.I set.
+ ******************************************************************************/
+
+/* Mask with the GICv3 PMR, needs the GICv3 system register interface */
+#ifndef IRQ_PSEUDO_NMI
+#define IRQ_PSEUDO_NMI		0
+#endif
+
+/* The platform has a GICv3 and uses its system register CPU interface */
+#ifndef GICV3_SUPPORT
+#define GICV3_SUPPORT		0
+#endif
+
+#if IRQ_PSEUDO_NMI && !defined(__aarch64__)
+#error "IRQ_PSEUDO_NMI is only supported on AArch64"
+#endif
+
+/* ICC_PMR_EL1 is UNDEFINED with a GICv2 */
+#if IRQ_PSEUDO_NMI && !GICV3_SUPPORT
+#error "IRQ_PSEUDO_NMI needs GICV3_SUPPORT"
+#endif
+
+/* Priority masks: everything, and only what is above IRQ_PRIO_HARD */
+#define IRQ_PMR_UNMASKED	U(0xff)
+#define IRQ_PMR_MASKED		IRQ_PRIO_HARD
+
+#if IRQ_PSEUDO_NMI
+
+static inline u_register_t local_irq_save(void)
+{
+	u_register_t flags = read_icc_pmr_el1();
+
+	COMPILER_BARRIER();
+	/* PMR writes are self-synchronising */
+	write_icc_pmr_el1(IRQ_PMR_MASKED);
+	COMPILER_BARRIER();
+
+	return flags;
+}
+
+static inline void local_irq_restore(u_register_t flags)
+{
+	/* Memory updates are visible before any interrupt it lets in */
+	dsbishst();
+	write_icc_pmr_el1(flags);
+	COMPILER_BARRIER();
+}
+
+static inline bool irqs_disabled(void)
+{
+	return (read_icc_pmr_el1() <= IRQ_PMR_MASKED) ||
+	       ((read_daif() & (DAIF_IRQ_BIT << SPSR_DAIF_SHIFT)) != 0U);
+}
+
+#else /* !IRQ_PSEUDO_NMI */
+
+static inline u_register_t local_irq_save(void)
+{
+	u_register_t flags = read_daif();
+
+	disable_irq();
+
+	return flags;
+}
+
+static inline void local_irq_restore(u_register_t flags)
+{
+	write_daif(flags);
+}
+
+#ifdef __aarch64__
+static inline bool irqs_disabled(void)
+{
+	return (read_daif() & (DAIF_IRQ_BIT << SPSR_DAIF_SHIFT)) != 0U;
+}
+#endif
+
+#endif /* IRQ_PSEUDO_NMI */
+
+static inline void local_irq_disable(void)
+{
+	(void)local_irq_save();
+}
+
+static inline void local_irq_enable(void)
+{
+#if IRQ_PSEUDO_NMI
+	local_irq_restore(IRQ_PMR_UNMASKED);
+#else
+	enable_irq();
+#endif
+}
+
+#endif /* IRQFLAGS_H */
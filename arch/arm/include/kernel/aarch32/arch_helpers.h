@@ -224,6 +224,7 @@ DEFINE_COPROCR_READ_FUNC(id_pfr1, ID_PFR1)
 DEFINE_COPROCR_READ_FUNC(isr, ISR)
 DEFINE_COPROCR_READ_FUNC(clidr, CLIDR)
 DEFINE_COPROCR_READ_FUNC_64(cntpct, CNTPCT_64)
+DEFINE_COPROCR_READ_FUNC_64(cntvct, CNTVCT_64)
 
 DEFINE_COPROCR_RW_FUNCS(scr, SCR)
 DEFINE_COPROCR_RW_FUNCS(ctr, CTR)
@@ -234,6 +235,9 @@ DEFINE_COPROCR_RW_FUNCS(hcr, HCR)
 DEFINE_COPROCR_RW_FUNCS(hcptr, HCPTR)
 DEFINE_COPROCR_RW_FUNCS(cntfrq, CNTFRQ)
 DEFINE_COPROCR_RW_FUNCS(cnthctl, CNTHCTL)
+DEFINE_COPROCR_RW_FUNCS(cntkctl, CNTKCTL)
+DEFINE_COPROCR_RW_FUNCS(cntp_ctl, CNTP_CTL_32)
+DEFINE_COPROCR_RW_FUNCS(cntv_ctl, CNTV_CTL)
 DEFINE_COPROCR_RW_FUNCS(mair0, MAIR0)
 DEFINE_COPROCR_RW_FUNCS(mair1, MAIR1)
 DEFINE_COPROCR_RW_FUNCS(hmair0, HMAIR0)
@@ -248,6 +252,8 @@ DEFINE_COPROCR_RW_FUNCS(vmpidr, VMPIDR)
 DEFINE_COPROCR_RW_FUNCS_64(vttbr, VTTBR_64)
 DEFINE_COPROCR_RW_FUNCS_64(ttbr1, TTBR1_64)
 DEFINE_COPROCR_RW_FUNCS_64(cntvoff, CNTVOFF_64)
+DEFINE_COPROCR_RW_FUNCS_64(cntp_cval, CNTP_CVAL_64)
+DEFINE_COPROCR_RW_FUNCS_64(cntv_cval, CNTV_CVAL_64)
 DEFINE_COPROCR_RW_FUNCS(csselr, CSSELR)
 DEFINE_COPROCR_RW_FUNCS(hstr, HSTR)
 DEFINE_COPROCR_RW_FUNCS(cnthp_ctl_el2, CNTHP_CTL)
@@ -400,6 +406,20 @@ static inline unsigned int get_current_el(void)
 #define read_isr_el1()		read_isr()
 
 #define read_cntpct_el0()	read64_cntpct()
+#define read_cntvct_el0()	read64_cntvct()
+
+#define read_cntkctl_el1()	read_cntkctl()
+#define write_cntkctl_el1(_v)	write_cntkctl(_v)
+
+#define read_cntp_ctl_el0()	read_cntp_ctl()
+#define write_cntp_ctl_el0(_v)	write_cntp_ctl(_v)
+#define read_cntp_cval_el0()	read64_cntp_cval()
+#define write_cntp_cval_el0(_v)	write64_cntp_cval(_v)
+
+#define read_cntv_ctl_el0()	read_cntv_ctl()
+#define write_cntv_ctl_el0(_v)	write_cntv_ctl(_v)
+#define read_cntv_cval_el0()	read64_cntv_cval()
+#define write_cntv_cval_el0(_v)	write64_cntv_cval(_v)
 
 #define read_ctr_el0()		read_ctr()
 
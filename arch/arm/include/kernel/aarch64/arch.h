@@ -108,7 +108,31 @@
 #define HFGRTR_EL2		S3_4_C1_C1_4
 #define HFGWTR_EL2		S3_4_C1_C1_5
 #define ICH_HCR_EL2		S3_4_C12_C11_0
+#define ICH_VTR_EL2		S3_4_C12_C11_1
+#define ICH_MISR_EL2		S3_4_C12_C11_2
+#define ICH_EISR_EL2		S3_4_C12_C11_3
+#define ICH_ELRSR_EL2		S3_4_C12_C11_5
 #define ICH_VMCR_EL2		S3_4_C12_C11_7
+#define ICH_AP1R0_EL2		S3_4_C12_C9_0
+#define ICH_AP1R1_EL2		S3_4_C12_C9_1
+#define ICH_AP1R2_EL2		S3_4_C12_C9_2
+#define ICH_AP1R3_EL2		S3_4_C12_C9_3
+#define ICH_LR0_EL2		S3_4_C12_C12_0
+#define ICH_LR1_EL2		S3_4_C12_C12_1
+#define ICH_LR2_EL2		S3_4_C12_C12_2
+#define ICH_LR3_EL2		S3_4_C12_C12_3
+#define ICH_LR4_EL2		S3_4_C12_C12_4
+#define ICH_LR5_EL2		S3_4_C12_C12_5
+#define ICH_LR6_EL2		S3_4_C12_C12_6
+#define ICH_LR7_EL2		S3_4_C12_C12_7
+#define ICH_LR8_EL2		S3_4_C12_C13_0
+#define ICH_LR9_EL2		S3_4_C12_C13_1
+#define ICH_LR10_EL2		S3_4_C12_C13_2
+#define ICH_LR11_EL2		S3_4_C12_C13_3
+#define ICH_LR12_EL2		S3_4_C12_C13_4
+#define ICH_LR13_EL2		S3_4_C12_C13_5
+#define ICH_LR14_EL2		S3_4_C12_C13_6
+#define ICH_LR15_EL2		S3_4_C12_C13_7
 #define MPAMVPM0_EL2		S3_4_C10_C6_0
 #define MPAMVPM1_EL2		S3_4_C10_C6_1
 #define MPAMVPM2_EL2		S3_4_C10_C6_2
@@ -243,6 +267,9 @@
 /* ID_AA64ISAR0_EL1 definitions */
 #define ID_AA64ISAR0_RNDR_SHIFT	U(60)
 #define ID_AA64ISAR0_RNDR_MASK	ULL(0xf)
+#define ID_AA64ISAR0_TLB_SHIFT	U(56)
+#define ID_AA64ISAR0_TLB_MASK	ULL(0xf)
+#define ID_AA64ISAR0_TLB_RANGE	ULL(0x2)
 
 /* ID_AA64ISAR1_EL1 definitions */
 #define ID_AA64ISAR1_EL1		S3_0_C0_C6_1
@@ -275,6 +302,10 @@
 #define ID_AA64MMFR0_EL1_PARANGE_SHIFT	U(0)
 #define ID_AA64MMFR0_EL1_PARANGE_MASK	ULL(0xf)
 
+#define ID_AA64MMFR0_EL1_ASIDBITS_SHIFT	U(4)
+#define ID_AA64MMFR0_EL1_ASIDBITS_MASK	ULL(0xf)
+#define ID_AA64MMFR0_EL1_ASIDBITS_16	ULL(0x2)
+
 #define PARANGE_0000	U(32)
 #define PARANGE_0001	U(36)
 #define PARANGE_0010	U(40)
@@ -793,6 +824,7 @@
 
 #define TCR_EPD0_BIT		(ULL(1) << 7)
 #define TCR_EPD1_BIT		(ULL(1) << 23)
+#define TCR_AS_BIT		(ULL(1) << 36)
 
 #define MODE_SP_SHIFT		U(0x0)
 #define MODE_SP_MASK		U(0x1)
@@ -848,6 +880,8 @@
  * TTBR Definitions
  */
 #define TTBR_CNP_BIT		ULL(0x1)
+#define TTBR_ASID_SHIFT		U(48)
+#define TTBR_ASID_MASK		ULL(0xffff)
 
 /*
  * CTR_EL0 definitions
@@ -918,6 +952,16 @@
  */
 #define ESR_ISS_EABORT_EA_BIT		U(9)
 
+/* Write not Read bit and Fault Status Code of Data Abort syndromes */
+#define ESR_ISS_DABORT_WNR_BIT		U(6)
+#define ESR_ISS_FSC_MASK		U(0x3f)
+
+/* Fault Status Code classes, the two low bits hold the lookup level */
+#define ESR_FSC_TYPE(x)			((x) & U(0x3c))
+#define ESR_FSC_TRANSLATION		U(0x04)
+#define ESR_FSC_ACCESS_FLAG		U(0x08)
+#define ESR_FSC_PERMISSION		U(0x0c)
+
 #define EC_BITS(x)			(((x) >> ESR_EC_SHIFT) & ESR_EC_MASK)
 
 /* Reset bit inside the Reset management register for EL3 (RMR_EL3) */
@@ -933,6 +977,27 @@
 #define TLBI_ADDR_MASK		ULL(0x00000FFFFFFFFFFF)
 #define TLBI_ADDR(x)		(((x) >> TLBI_ADDR_SHIFT) & TLBI_ADDR_MASK)
 
+/*
+ * Operand of the TLBI range instructions (FEAT_TLBIRANGE) with a 4KB granule:
+ * (NUM + 1) * 2^(5 * SCALE + 1) pages starting at BaseADDR.
+ */
+#define TLBI_RANGE_TG_4KB	ULL(1)
+#define TLBI_RANGE_TG_SHIFT	U(46)
+#define TLBI_RANGE_SCALE_SHIFT	U(44)
+#define TLBI_RANGE_SCALE_MAX	U(3)
+#define TLBI_RANGE_NUM_SHIFT	U(39)
+#define TLBI_RANGE_NUM_MASK	U(0x1f)
+#define TLBI_RANGE_BADDR_MASK	ULL(0x1FFFFFFFFF)
+#define TLBI_RANGE_PAGES(num, scale)	\
+	((uint64_t)((num) + 1U) << ((5U * (scale)) + 1U))
+#define TLBI_RANGE_MAX_PAGES	\
+	TLBI_RANGE_PAGES(TLBI_RANGE_NUM_MASK, TLBI_RANGE_SCALE_MAX)
+#define TLBI_RANGE(va, scale, num)					\
+	((TLBI_RANGE_TG_4KB << TLBI_RANGE_TG_SHIFT) |			\
+	 ((uint64_t)(scale) << TLBI_RANGE_SCALE_SHIFT) |		\
+	 ((uint64_t)(num) << TLBI_RANGE_NUM_SHIFT) |			\
+	 (((va) >> TLBI_ADDR_SHIFT) & TLBI_RANGE_BADDR_MASK))
+
 /*******************************************************************************
  * Definitions of register offsets and fields in the CNTCTLBase Frame of the
  * system level implementation of the Generic Timer.
@@ -114,6 +114,12 @@ static inline bool is_armv8_5_rng_present(void)
 		ID_AA64ISAR0_RNDR_MASK);
 }
 
+static inline bool is_armv8_4_tlbi_range_present(void)
+{
+	return ((read_id_aa64isar0_el1() >> ID_AA64ISAR0_TLB_SHIFT) &
+		ID_AA64ISAR0_TLB_MASK) >= ID_AA64ISAR0_TLB_RANGE;
+}
+
 static inline bool is_armv8_6_feat_amuv1p1_present(void)
 {
 	return (((read_id_aa64pfr0_el1() >> ID_AA64PFR0_AMU_SHIFT) &
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2013-2022, Arm Limited and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef FPU_H
+#define FPU_H
+
+#include <stdint.h>
+
+#include <context.h>
+
+/*******************************************************************************
+ * Lazy FP/SIMD context switching.
+ *
+ * The FP/SIMD registers of a CPU belong to at most one process, its owner.
+ * Switching to another process only arms the FP/SIMD access trap; nothing is
+ * saved. The first FP/SIMD instruction of the new process traps, and only
+ * then the owner's registers are saved and the new process' restored. A
+ * process that does not use FP/SIMD, or that runs again before anybody else
+ * touched FP/SIMD on this CPU, never causes a save.
+ ******************************************************************************/
+
+#if CTX_INCLUDE_FPREGS
+
+typedef struct fpu_stats {
+	/* Context switches that would have saved the FP registers eagerly */
+	uint64_t nr_switches;
+	uint64_t nr_saves;
+	uint64_t nr_restores;
+	uint64_t nr_traps;
+} fpu_stats_t;
+
+void fpu_setup(void);
+void fpu_cpu_setup(void);
+void fpu_switch_to(logical_cpu_context_t *next);
+void fpu_get_stats(unsigned int cpu, fpu_stats_t *stats);
+uint64_t fpu_saves_avoided(void);
+
+#endif /* CTX_INCLUDE_FPREGS */
+
+#endif /* FPU_H */
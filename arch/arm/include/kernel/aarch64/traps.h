@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2013-2022, Arm Limited and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef TRAPS_H
+#define TRAPS_H
+
+#include <utils.h>
+
+/*******************************************************************************
+ * Exception dispatch from lower ELs.
+ *
+ * SVCs and IRQs take a fast path in traps.S that only saves the registers a
+ * C function may clobber (x0 - x18, x30, SP_EL0, ELR/SPSR). Their C handlers
+ * return TRAP_EXIT_FAST to go straight back to the interrupted code, or
+ * TRAP_EXIT_FULL to have x19 - x29 saved as well and leave through
+ * exit_kernel_entry, e.g. because another process has to run.
+ *
+ * All other synchronous exceptions save the full frame and are routed on the
+ * ESR_ELx exception class to the handlers in sync_handlers[].
+ *
+ * Exceptions taken from the kernel itself arrive at the SP_EL0 vectors, as
+ * kernel code runs on SP_EL0. Their frame is pushed on the interrupted kernel
+ * stack and their handlers run below it, leaving the frames above intact.
+ ******************************************************************************/
+
+#define TRAP_EXIT_FAST		U(0)
+#define TRAP_EXIT_FULL		U(1)
+
+/* Number of entries in the syscall table */
+#ifndef NR_SYSCALLS
+#define NR_SYSCALLS		U(64)
+#endif
+
+/* Syscall doing nothing, used to measure the round-trip cost of an SVC */
+#define SYSCALL_NULL		U(0)
+
+/* Return value of a syscall number without handler */
+#define SYSCALL_ENOSYS		(~UL(0))
+
+/* Build syscall_null_bench(), a null-syscall latency benchmark for QEMU */
+#ifndef TRAPS_SYSCALL_BENCH
+#define TRAPS_SYSCALL_BENCH	0
+#endif
+
+#ifndef __ASSEMBLER__
+
+#include <stdint.h>
+
+#include <arch_helpers.h>
+#include <context.h>
+
+/*
+ * Syscall ABI: the number is in x8 (r7 for AArch32 callers), the arguments in
+ * x0 - x5 and the result is returned in x0.
+ */
+typedef u_register_t (*syscall_fn_t)(u_register_t a0, u_register_t a1,
+				     u_register_t a2, u_register_t a3,
+				     u_register_t a4, u_register_t a5);
+
+/* Handler for one exception class, 'ctx' is the complete saved frame */
+typedef void (*trap_handler_t)(gp_regs_t *ctx, u_register_t esr);
+
+/* Handler for IRQs and FIQs, only the caller-saved registers are in 'ctx' */
+typedef void (*trap_irq_handler_t)(gp_regs_t *ctx);
+
+int syscall_register(unsigned int nr, syscall_fn_t fn);
+int trap_register_handler(unsigned int ec, trap_handler_t handler);
+void trap_set_irq_handler(trap_irq_handler_t handler);
+void trap_request_full_exit(void);
+
+/* Called from traps.S */
+u_register_t user_svc_handler(gp_regs_t *ctx);
+u_register_t user_interrupt_handler(gp_regs_t *ctx);
+void lower_el_sync_handler(gp_regs_t *ctx);
+void kernel_interrupt_handler(gp_regs_t *ctx);
+void kernel_data_abort_handler(gp_regs_t *ctx);
+void kernel_prefetch_abort_handler(void);
+void user_smc_handler(gp_regs_t *ctx);
+void user_hvc_handler(gp_regs_t *ctx);
+void user_ea_handler(unsigned int ea_reason, u_register_t syndrome,
+		     void *cookie, void *handle, u_register_t flags);
+
+#if TRAPS_SYSCALL_BENCH
+/*
+ * EL0 side of the benchmark. It must run at EL0 with the counter readable,
+ * see vdso_cpu_setup(), and returns the average round trip in counter ticks.
+ */
+static inline u_register_t syscall0(u_register_t nr)
+{
+	register u_register_t x0 __asm__("x0");
+	register u_register_t x8 __asm__("x8") = nr;
+
+	__asm__ volatile("svc	#0" : "=r" (x0) : "r" (x8) : "memory");
+
+	return x0;
+}
+
+static inline uint64_t syscall_null_bench(unsigned int loops)
+{
+	uint64_t start, end;
+	unsigned int i;
+
+	if (loops == 0U)
+		return 0U;
+
+	isb();
+	start = read_cntvct_el0();
+	for (i = 0U; i < loops; i++)
+		(void)syscall0(SYSCALL_NULL);
+	isb();
+	end = read_cntvct_el0();
+
+	return (end - start) / loops;
+}
+#endif /* TRAPS_SYSCALL_BENCH */
+
+#endif /* __ASSEMBLER__ */
+
+#endif /* TRAPS_H */
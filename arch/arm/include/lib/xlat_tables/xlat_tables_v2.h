@@ -11,6 +11,7 @@
 #include <lib/xlat_tables/xlat_tables_v2_helpers.h>
 
 #ifndef __ASSEMBLER__
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -76,6 +77,9 @@
 #define MT_SHAREABILITY_MASK	(U(3) << MT_SHAREABILITY_SHIFT)
 #define MT_SHAREABILITY(_attr)	((_attr) & MT_SHAREABILITY_MASK)
 
+/* Dynamic region whose pages are mapped on demand, see xlat_map_page_ctx() */
+#define MT_DEMAND_SHIFT		U(10)
+
 /* All other bits are reserved */
 
 /*
@@ -130,6 +134,13 @@
 #define MT_SHAREABILITY_OSH	(U(2) << MT_SHAREABILITY_SHIFT)
 #define MT_SHAREABILITY_NSH	(U(3) << MT_SHAREABILITY_SHIFT)
 
+/*
+ * A dynamic region with this attribute only gets translation tables, down to
+ * the last level: its page entries are left invalid and its owner maps pages
+ * in and out one at a time. The PA of the region is ignored.
+ */
+#define MT_DEMAND		(U(1) << MT_DEMAND_SHIFT)
+
 /* Compound attributes for most common usages */
 #define MT_CODE			(MT_MEMORY | MT_RO | MT_EXECUTE)
 #define MT_RO_DATA		(MT_MEMORY | MT_RO | MT_EXECUTE_NEVER)
@@ -307,6 +318,14 @@ int mmap_add_dynamic_region(unsigned long long base_pa, uintptr_t base_va,
 			    size_t size, unsigned int attr);
 int mmap_add_dynamic_region_ctx(xlat_ctx_t *ctx, mmap_region_t *mm);
 
+/*
+ * As mmap_add_dynamic_region(), but the region is mapped with entries no
+ * larger than 'granularity', see MAP_REGION2().
+ */
+int mmap_add_dynamic_region2(unsigned long long base_pa, uintptr_t base_va,
+			     size_t size, unsigned int attr,
+			     size_t granularity);
+
 /*
  * Add a dynamic region with defined base PA. Returns base VA calculated using
  * the highest existing region in the mmap array even if it fails to allocate
@@ -337,6 +356,41 @@ int mmap_remove_dynamic_region_ctx(xlat_ctx_t *ctx,
 				uintptr_t base_va,
 				size_t size);
 
+/*
+ * Manage the pages of a MT_DEMAND region one at a time, e.g. from a page fault
+ * handler. The caller serialises the calls on a region. Removing the region
+ * unmaps whatever pages are left.
+ *
+ * xlat_map_page_ctx() maps the page at 'pa' at 'va' with attributes 'attr'.
+ * A page already mapped there is replaced with a break-before-make sequence.
+ *
+ * xlat_unmap_page_ctx() unmaps the page at 'va', if any.
+ *
+ * xlat_unmap_pages_ctx() unmaps the pages mapped in [base_va, base_va + size),
+ * with a single TLB invalidation. The pages are no longer accessed through
+ * these mappings once it returns, and can be freed.
+ *
+ * xlat_wrprotect_pages_ctx() makes the pages mapped in [base_va,
+ * base_va + size) read-only, with a single TLB invalidation.
+ *
+ * xlat_page_lookup_ctx() returns the PA of the page mapped at 'va' in 'pa'
+ * and whether it is writable in 'writable', which may be NULL.
+ *
+ * Returns:
+ *        0: Success.
+ *   EINVAL: The pages aren't all in the same MT_DEMAND region.
+ *   ENOENT: xlat_page_lookup_ctx() only, no page is mapped at 'va'.
+ */
+int xlat_map_page_ctx(const xlat_ctx_t *ctx, uintptr_t va,
+		      unsigned long long pa, uint32_t attr);
+int xlat_unmap_page_ctx(const xlat_ctx_t *ctx, uintptr_t va);
+int xlat_wrprotect_pages_ctx(const xlat_ctx_t *ctx, uintptr_t base_va,
+			     size_t size);
+int xlat_unmap_pages_ctx(const xlat_ctx_t *ctx, uintptr_t base_va,
+			size_t size);
+int xlat_page_lookup_ctx(const xlat_ctx_t *ctx, uintptr_t va,
+			 unsigned long long *pa, bool *writable);
+
 #endif /* PLAT_XLAT_TABLES_DYNAMIC */
 
 /*
@@ -378,6 +432,10 @@ int mmap_remove_dynamic_region_ctx(xlat_ctx_t *ctx,
  * NOTE2: The caller is responsible for making sure that the targeted
  * translation tables are not modified by any other code while this function is
  * executing.
+ *
+ * NOTE3: The whole region is unmapped while its TLB entries are invalidated,
+ * so it must not hold the code or the stack of this function, and no other PE
+ * may access it meanwhile.
  */
 int xlat_change_mem_attributes_ctx(const xlat_ctx_t *ctx, uintptr_t base_va,
 				   size_t size, uint32_t attr);
@@ -412,5 +470,32 @@ int xlat_get_mem_attributes_ctx(const xlat_ctx_t *ctx, uintptr_t base_va,
 				uint32_t *attr);
 int xlat_get_mem_attributes(uintptr_t base_va, uint32_t *attr);
 
+/*
+ * Translate a virtual address of a set of translation tables to the physical
+ * address it is mapped to, e.g. to hand memory to a DMA master page by page.
+ *
+ * Return 0 on success, a negative error code if 'va' isn't mapped.
+ * On success, the physical address is stored into *pa.
+ *
+ * If the context is the one the MMU currently uses, the address is translated
+ * by the MMU itself, otherwise by walking the tables in software. Both are
+ * preceded by a lookup in a small cache, held by the context, of the last
+ * level tables that recent software walks ended in.
+ *
+ * ctx
+ *   Translation context to work on.
+ * va
+ *   Virtual address to translate. There are no alignment restrictions.
+ * pa
+ *   Output parameter where to store the physical address.
+ *
+ * NOTE: The caller is responsible for making sure that the region holding
+ * 'va' isn't removed from the translation tables while this function is
+ * executing. Other regions may be mapped and unmapped meanwhile.
+ */
+int xlat_va_to_pa_ctx(const xlat_ctx_t *ctx, uintptr_t va,
+		      unsigned long long *pa);
+int xlat_va_to_pa(uintptr_t va, unsigned long long *pa);
+
 #endif /*__ASSEMBLER__*/
 #endif /* XLAT_TABLES_V2_H */
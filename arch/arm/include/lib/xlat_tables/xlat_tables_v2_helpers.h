@@ -31,6 +31,14 @@
 /* Forward declaration */
 struct mmap_region;
 
+/*
+ * Entries of the walk cache of xlat_va_to_pa_ctx() in every context. Must be a
+ * power of two.
+ */
+#ifndef XLAT_WALK_CACHE_ENTRIES
+#define XLAT_WALK_CACHE_ENTRIES		U(16)
+#endif
+
 /*
  * Helper macro to define an mmap_region_t.  This macro allows to specify all
  * the fields of the structure but its parameter list is not guaranteed to
@@ -80,6 +88,14 @@ struct xlat_ctx {
 	 */
 #if PLAT_XLAT_TABLES_DYNAMIC
 	int *tables_mapped_regions;
+
+	/*
+	 * Tables taken from the page allocator, which only the static ones
+	 * above are used before. Emptied ones wait in 'reclaim_tables' for the
+	 * TLB invalidation before they are given back.
+	 */
+	int pooled_tables;
+	uint64_t *reclaim_tables;
 #endif /* PLAT_XLAT_TABLES_DYNAMIC */
 
 	int next_table;
@@ -110,6 +126,13 @@ struct xlat_ctx {
 	 * the EL*_REGIME defines.
 	 */
 	int xlat_regime;
+
+	/*
+	 * Last level tables recent xlat_va_to_pa_ctx() walks ended in,
+	 * direct-mapped by virtual address. Only tables are cached, not their
+	 * entries, so it is only flushed when tables are unlinked.
+	 */
+	uint64_t walk_cache[XLAT_WALK_CACHE_ENTRIES];
 };
 
 #if PLAT_XLAT_TABLES_DYNAMIC
@@ -117,7 +140,9 @@ struct xlat_ctx {
 	static int _ctx_name##_mapped_regions[_xlat_tables_count];
 
 #define XLAT_REGISTER_DYNMAP_STRUCT(_ctx_name)				\
-	.tables_mapped_regions = _ctx_name##_mapped_regions,
+	.tables_mapped_regions = _ctx_name##_mapped_regions,		\
+	.pooled_tables = 0,						\
+	.reclaim_tables = NULL,
 #else
 #define XLAT_ALLOC_DYNMAP_STRUCT(_ctx_name, _xlat_tables_count)		\
 	/* do nothing */
@@ -172,7 +197,8 @@ struct xlat_ctx {
 		.max_va = 0U,						\
 		.base_level = GET_XLAT_TABLE_LEVEL_BASE(_virt_addr_space_size),\
 		.initialized = false,					\
-		.xlat_regime = (_xlat_regime)				\
+		.xlat_regime = (_xlat_regime),				\
+		.walk_cache = { 0U }					\
 	}
 
 #endif /*__ASSEMBLER__*/
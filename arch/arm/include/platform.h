@@ -0,0 +1,25 @@
+/*
+ * Copyright (c) 2013-2021, Arm Limited and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef PLATFORM_H
+#define PLATFORM_H
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Mandatory common functions
+ ******************************************************************************/
+unsigned int plat_my_core_pos(void);
+int plat_core_pos_by_mpidr(u_register_t mpidr);
+const char *plat_log_get_prefix(unsigned int log_level);
+unsigned int plat_get_syscnt_freq2(void);
+
+/*******************************************************************************
+ * Optional common functions
+ ******************************************************************************/
+uint64_t plat_get_ns_dram_end(void);
+
+#endif /* PLATFORM_H */
@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2013-2022, Arm Limited and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef VDSO_H
+#define VDSO_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <arch_helpers.h>
+#include <drivers/delay_timer/clocksource.h>
+#include <lib/xlat_tables/xlat_tables_v2.h>
+#include <vm.h>
+
+/*******************************************************************************
+ * User-readable clock page.
+ *
+ * The kernel keeps the clock parameters in a single page that is mapped read
+ * only into user address spaces, and lets EL0 read the counter. A timestamp
+ * is then a counter read and a multiply/shift, with no trap into the kernel.
+ *
+ * Updates are protected by a sequence count: the writer makes 'seq' odd while
+ * it changes the page and even again when done, and readers retry when they
+ * saw an odd count or the count changed under them.
+ ******************************************************************************/
+
+/*
+ * User VA of the clock page, the last page of the vm_map() window, which
+ * vm_map() keeps for it. vm_space_init() maps it there.
+ */
+#define VDSO_USER_VA		(VM_MMAP_END - PAGE_SIZE)
+
+/* Counter the clock page is based on */
+#define VDSO_CLOCK_CNTVCT	U(0)
+#define VDSO_CLOCK_CNTPCT	U(1)
+
+typedef struct vdso_data {
+	volatile uint32_t seq;
+	uint32_t clock_mode;
+	/* cycles -> ns */
+	uint32_t mult;
+	uint32_t shift;
+	uint64_t mask;
+	/* CLOCK_REALTIME minus CLOCK_MONOTONIC, in ns */
+	uint64_t realtime_offset;
+} vdso_data_t;
+
+/*
+ * Reader side, meant to be used by EL0 code on the mapped page.
+ */
+static inline uint32_t vdso_read_begin(const vdso_data_t *vd)
+{
+	uint32_t seq;
+
+	while (((seq = vd->seq) & 1U) != 0U)
+		;
+	dmbish();
+
+	return seq;
+}
+
+static inline bool vdso_read_retry(const vdso_data_t *vd, uint32_t seq)
+{
+	dmbish();
+	return vd->seq != seq;
+}
+
+static inline uint64_t vdso_read_counter(const vdso_data_t *vd)
+{
+	isb();
+	if (vd->clock_mode == VDSO_CLOCK_CNTPCT)
+		return read_cntpct_el0();
+
+	return read_cntvct_el0();
+}
+
+/* Monotonic time in nanoseconds, the same clock as the kernel hrtimer_now() */
+static inline uint64_t vdso_clock_monotonic_ns(const vdso_data_t *vd)
+{
+	uint64_t cycles;
+	uint32_t mult, shift, seq;
+
+	do {
+		seq = vdso_read_begin(vd);
+		mult = vd->mult;
+		shift = vd->shift;
+		cycles = vdso_read_counter(vd) & vd->mask;
+	} while (vdso_read_retry(vd, seq));
+
+	return mul_u64_u32_shr(cycles, mult, shift);
+}
+
+static inline uint64_t vdso_clock_realtime_ns(const vdso_data_t *vd)
+{
+	uint64_t cycles, offset;
+	uint32_t mult, shift, seq;
+
+	do {
+		seq = vdso_read_begin(vd);
+		mult = vd->mult;
+		shift = vd->shift;
+		offset = vd->realtime_offset;
+		cycles = vdso_read_counter(vd) & vd->mask;
+	} while (vdso_read_retry(vd, seq));
+
+	return mul_u64_u32_shr(cycles, mult, shift) + offset;
+}
+
+/*
+ * Kernel side.
+ */
+void vdso_setup(void);
+void vdso_cpu_setup(void);
+void vdso_set_realtime(uint64_t realtime_ns);
+const vdso_data_t *vdso_data(void);
+#if PLAT_XLAT_TABLES_DYNAMIC
+int vdso_map(xlat_ctx_t *ctx, uintptr_t base_va);
+int vdso_unmap(xlat_ctx_t *ctx, uintptr_t base_va);
+#endif
+
+#endif /* VDSO_H */
@@ -1,6 +1,24 @@
+#include <arch_helpers.h>
+#include <drivers/console/console.h>
+#include <hrtimer.h>
+#include <workqueue.h>
+
 void idle_thread(void)
 {
     while (1) {
-        wfi();
+        /* Threaded interrupt handlers and other deferred work. */
+        workqueue_run();
+        /* Push out the log records queued by all CPUs before sleeping. */
+        console_ring_drain();
+        /* Sleep until the next timer deadline, there is no periodic tick. */
+        hrtimer_idle_enter();
+        /*
+         * Work queued by an interrupt taken since the run above must not wait
+         * for the next one. A pending interrupt still ends wfi while masked.
+         */
+        disable_irq();
+        if (!workqueue_pending())
+            wfi();
+        enable_irq();
     }
 }
@@ -1,61 +1,298 @@
-
-
-/* exp type */
-
-/* 1. kernel exp - 
- *
- */
-
-/* sync */
-void kernel_data_abort_handler()
-{
-
-}
-
-void kernel_prefetch_abort_handler()
-{
-
-}
-
-/* irq */
-void kernel_interrupt_handler()
-{
-
-}
-
-/* fiq */
-
-/* serr */
-
-/* sync */
-/* handler type */
-void user_smc_handler()
-{
-
-}
-
-void user_hvc_handler()
-{
-
-}
-
-void user_svc_handler()
-{
-
-}
-
-void user_ea_handler()
-{
-
-}
-
-
-/* irq */
-void user_interrupt_handler()
-{
-
-}
-
-/* fiq */
-
-/* serr */
+/*
+ * Copyright (c) 2013-2022, Arm Limited and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <platform_def.h>
+
+#include <arch.h>
+#include <arch_helpers.h>
+#include <context.h>
+#include <debug.h>
+#include <platform.h>
+#include <traps.h>
+#include <vm.h>
+
+#ifdef CONFIG_ARM_MONITOR_SUPPORT
+#define read_esr_elx()		read_esr_el3()
+#define read_elr_elx()		read_elr_el3()
+#define read_far_elx()		read_far_el3()
+#elif CONFIG_ARM_HYPERVISOR_SUPPORT
+#define read_esr_elx()		read_esr_el2()
+#define read_elr_elx()		read_elr_el2()
+#define read_far_elx()		read_far_el2()
+#elif CONFIG_ARM_SUPERVISER_SUPPORT
+#define read_esr_elx()		read_esr_el1()
+#define read_elr_elx()		read_elr_el1()
+#define read_far_elx()		read_far_el1()
+#endif
+
+/* Per-CPU request to leave the next fast path through exit_kernel_entry */
+typedef struct trap_cpu {
+	bool full_exit;
+} __aligned(CACHE_WRITEBACK_GRANULE) trap_cpu_t;
+
+static trap_cpu_t trap_cpus[PLATFORM_CORE_COUNT];
+
+static u_register_t sys_null(u_register_t a0, u_register_t a1,
+			     u_register_t a2, u_register_t a3,
+			     u_register_t a4, u_register_t a5)
+{
+	return 0U;
+}
+
+static syscall_fn_t syscall_table[NR_SYSCALLS] = {
+	[SYSCALL_NULL] = sys_null,
+};
+
+static void user_abort_handler(gp_regs_t *ctx, u_register_t esr);
+static void user_call_handler(gp_regs_t *ctx, u_register_t esr);
+
+/* Handlers of synchronous exceptions from a lower EL, indexed by EC */
+static trap_handler_t sync_handlers[ESR_EC_MASK + 1U] = {
+	[EC_AARCH32_SVC] = user_call_handler,
+	[EC_AARCH64_SVC] = user_call_handler,
+	[EC_AARCH32_HVC] = user_call_handler,
+	[EC_AARCH64_HVC] = user_call_handler,
+	[EC_AARCH32_SMC] = user_call_handler,
+	[EC_AARCH64_SMC] = user_call_handler,
+	[EC_IABORT_LOWER_EL] = user_abort_handler,
+	[EC_DABORT_LOWER_EL] = user_abort_handler,
+};
+
+static trap_irq_handler_t irq_handler;
+
+static inline trap_cpu_t *trap_this_cpu(void)
+{
+	return &trap_cpus[plat_my_core_pos()];
+}
+
+static inline u_register_t trap_exit_verdict(void)
+{
+	trap_cpu_t *tc = trap_this_cpu();
+
+	if (!tc->full_exit)
+		return TRAP_EXIT_FAST;
+
+	tc->full_exit = false;
+	return TRAP_EXIT_FULL;
+}
+
+static void __dead2 trap_unhandled(const char *what, u_register_t esr)
+{
+	ERROR("Unhandled %s, ESR 0x%lx, ELR 0x%lx, FAR 0x%lx\n", what,
+	      esr, read_elr_elx(), read_far_elx());
+	panic();
+}
+
+/*******************************************************************************
+ * Register 'fn' as syscall number 'nr'. A number can only be taken once.
+ ******************************************************************************/
+int syscall_register(unsigned int nr, syscall_fn_t fn)
+{
+	if ((nr >= NR_SYSCALLS) || (fn == NULL))
+		return -EINVAL;
+
+	if (syscall_table[nr] != NULL)
+		return -EBUSY;
+
+	syscall_table[nr] = fn;
+	return 0;
+}
+
+/*******************************************************************************
+ * Route synchronous exceptions of class 'ec' from a lower EL to 'handler'.
+ * SVCs never reach this table, they are dispatched on the fast path.
+ ******************************************************************************/
+int trap_register_handler(unsigned int ec, trap_handler_t handler)
+{
+	if ((ec > ESR_EC_MASK) || (ec == EC_AARCH32_SVC) ||
+	    (ec == EC_AARCH64_SVC))
+		return -EINVAL;
+
+	sync_handlers[ec] = handler;
+	return 0;
+}
+
+void trap_set_irq_handler(trap_irq_handler_t handler)
+{
+	irq_handler = handler;
+}
+
+/*******************************************************************************
+ * Make the current fast path leave through exit_kernel_entry, so that the
+ * process to return to can be changed. Must be called with IRQs masked.
+ ******************************************************************************/
+void trap_request_full_exit(void)
+{
+	trap_this_cpu()->full_exit = true;
+}
+
+#if PLAT_XLAT_TABLES_DYNAMIC
+/*
+ * Resolve a translation or permission fault on a page of the address space
+ * the CPU runs. Returns true when the access can be retried.
+ */
+static bool trap_vm_fault(u_register_t esr)
+{
+	unsigned int fsc = ESR_FSC_TYPE(esr & ESR_ISS_FSC_MASK);
+	unsigned int flags = 0U;
+
+	if ((fsc != ESR_FSC_TRANSLATION) && (fsc != ESR_FSC_PERMISSION))
+		return false;
+
+	if ((EC_BITS(esr) == EC_IABORT_LOWER_EL) ||
+	    (EC_BITS(esr) == EC_IABORT_CUR_EL))
+		flags |= VM_FAULT_EXEC;
+	else if ((esr & BIT(ESR_ISS_DABORT_WNR_BIT)) != 0U)
+		flags |= VM_FAULT_WRITE;
+
+	return vm_fault(vm_current(), read_far_elx(), flags) == 0;
+}
+#endif /* PLAT_XLAT_TABLES_DYNAMIC */
+
+/* sync */
+/*******************************************************************************
+ * Data abort taken by the kernel, e.g. on a user page not mapped yet. Only the
+ * caller-saved registers are in 'ctx'.
+ ******************************************************************************/
+void kernel_data_abort_handler(gp_regs_t *ctx)
+{
+	u_register_t esr = read_esr_elx();
+
+#if PLAT_XLAT_TABLES_DYNAMIC
+	if (((esr & BIT(ESR_ISS_EABORT_EA_BIT)) == 0U) && trap_vm_fault(esr))
+		return;
+#endif
+
+	trap_unhandled("kernel data abort", esr);
+}
+
+void kernel_prefetch_abort_handler(void)
+{
+	trap_unhandled("kernel prefetch abort", read_esr_elx());
+}
+
+/* irq */
+void kernel_interrupt_handler(gp_regs_t *ctx)
+{
+	if (irq_handler == NULL)
+		trap_unhandled("kernel interrupt", 0U);
+
+	irq_handler(ctx);
+}
+
+/*******************************************************************************
+ * SVC fast path. Only x0 - x18, x30, SP_EL0 and ELR/SPSR are valid in 'ctx'.
+ ******************************************************************************/
+u_register_t user_svc_handler(gp_regs_t *ctx)
+{
+	u_register_t spsr = read_ctx_reg(ctx, CTX_SPSR_ELX);
+	u_register_t nr, ret;
+	syscall_fn_t fn;
+
+	if (GET_RW(spsr) == MODE_RW_32)
+		nr = read_ctx_reg(ctx, CTX_GPREG_X7);
+	else
+		nr = read_ctx_reg(ctx, CTX_GPREG_X8);
+
+	fn = (nr < NR_SYSCALLS) ? syscall_table[nr] : NULL;
+	if (fn == NULL) {
+		ret = SYSCALL_ENOSYS;
+	} else {
+		ret = fn(read_ctx_reg(ctx, CTX_GPREG_X0),
+			 read_ctx_reg(ctx, CTX_GPREG_X1),
+			 read_ctx_reg(ctx, CTX_GPREG_X2),
+			 read_ctx_reg(ctx, CTX_GPREG_X3),
+			 read_ctx_reg(ctx, CTX_GPREG_X4),
+			 read_ctx_reg(ctx, CTX_GPREG_X5));
+	}
+
+	write_ctx_reg(ctx, CTX_GPREG_X0, ret);
+
+	return trap_exit_verdict();
+}
+
+/*******************************************************************************
+ * Synchronous exceptions from a lower EL other than SVC. 'ctx' is complete.
+ ******************************************************************************/
+void lower_el_sync_handler(gp_regs_t *ctx)
+{
+	u_register_t esr = read_esr_elx();
+	trap_handler_t handler = sync_handlers[EC_BITS(esr)];
+
+	if (handler == NULL)
+		trap_unhandled("lower EL exception", esr);
+
+	handler(ctx, esr);
+}
+
+static void user_call_handler(gp_regs_t *ctx, u_register_t esr)
+{
+	switch (EC_BITS(esr)) {
+	case EC_AARCH32_SMC:
+	case EC_AARCH64_SMC:
+		user_smc_handler(ctx);
+		break;
+	case EC_AARCH32_HVC:
+	case EC_AARCH64_HVC:
+		user_hvc_handler(ctx);
+		break;
+	default:
+		/* An SVC routed here only if the fast path was bypassed */
+		(void)user_svc_handler(ctx);
+		break;
+	}
+}
+
+static void user_abort_handler(gp_regs_t *ctx, u_register_t esr)
+{
+	if ((esr & BIT(ESR_ISS_EABORT_EA_BIT)) != 0U) {
+		user_ea_handler(ERROR_EA_SYNC, esr, NULL, ctx, 0U);
+		return;
+	}
+
+#if PLAT_XLAT_TABLES_DYNAMIC
+	if (trap_vm_fault(esr))
+		return;
+#endif
+
+	trap_unhandled((EC_BITS(esr) == EC_DABORT_LOWER_EL) ?
+		       "user data abort" : "user prefetch abort", esr);
+}
+
+void user_smc_handler(gp_regs_t *ctx)
+{
+	/* No secure monitor calls are forwarded, fail them. */
+	write_ctx_reg(ctx, CTX_GPREG_X0, SYSCALL_ENOSYS);
+}
+
+void user_hvc_handler(gp_regs_t *ctx)
+{
+	write_ctx_reg(ctx, CTX_GPREG_X0, SYSCALL_ENOSYS);
+}
+
+void user_ea_handler(unsigned int ea_reason, u_register_t syndrome,
+		     void *cookie, void *handle, u_register_t flags)
+{
+	ERROR("External Abort from lower EL, reason %u, syndrome 0x%lx\n",
+	      ea_reason, syndrome);
+	panic();
+}
+
+/* irq */
+u_register_t user_interrupt_handler(gp_regs_t *ctx)
+{
+	if (irq_handler == NULL)
+		trap_unhandled("user interrupt", 0U);
+
+	irq_handler(ctx);
+
+	return trap_exit_verdict();
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2013-2022, Arm Limited and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include <platform_def.h>
+
+#include <arch.h>
+#include <arch_helpers.h>
+#include <context.h>
+#include <debug.h>
+#include <fpu.h>
+#include <platform.h>
+#include <traps.h>
+
+#if CTX_INCLUDE_FPREGS
+
+/*
+ * The FP/SIMD access trap of the lower ELs. The kernel itself never uses
+ * FP/SIMD outside of fpregs_context_save/restore(), which run with the trap
+ * disarmed.
+ */
+#ifdef CONFIG_ARM_MONITOR_SUPPORT
+#define fpu_trap_arm()		write_cptr_el3(read_cptr_el3() | TFP_BIT)
+#define fpu_trap_disarm()	write_cptr_el3(read_cptr_el3() & ~TFP_BIT)
+#elif CONFIG_ARM_HYPERVISOR_SUPPORT
+#define fpu_trap_arm()		write_cptr_el2(read_cptr_el2() | CPTR_EL2_TFP_BIT)
+#define fpu_trap_disarm()	write_cptr_el2(read_cptr_el2() & ~CPTR_EL2_TFP_BIT)
+#elif CONFIG_ARM_SUPERVISER_SUPPORT
+#define FPEN_MASK		CPACR_EL1_FPEN(UL(0x3))
+#define fpu_trap_arm()		write_cpacr_el1((read_cpacr_el1() & ~FPEN_MASK) | \
+					CPACR_EL1_FPEN(CPACR_EL1_FP_TRAP_EL0))
+#define fpu_trap_disarm()	write_cpacr_el1(read_cpacr_el1() | \
+					CPACR_EL1_FPEN(CPACR_EL1_FP_TRAP_NONE))
+#endif
+
+typedef struct fpu_cpu {
+	/* Process whose FP/SIMD state is live in the registers, or NULL */
+	logical_cpu_context_t *owner;
+	/* Process that last ran on this CPU, to count the real switches */
+	logical_cpu_context_t *last;
+	bool trap_armed;
+	fpu_stats_t stats;
+} __aligned(CACHE_WRITEBACK_GRANULE) fpu_cpu_t;
+
+static fpu_cpu_t fpu_cpus[PLATFORM_CORE_COUNT];
+
+static inline fpu_cpu_t *fpu_this_cpu(void)
+{
+	return &fpu_cpus[plat_my_core_pos()];
+}
+
+static inline void fpu_set_trap(fpu_cpu_t *fc, bool armed)
+{
+	if (fc->trap_armed == armed)
+		return;
+
+	if (armed)
+		fpu_trap_arm();
+	else
+		fpu_trap_disarm();
+	isb();
+
+	fc->trap_armed = armed;
+}
+
+/*******************************************************************************
+ * FP/SIMD access trap from a lower EL. 'ctx' is the frame of the current
+ * process, which is the start of its logical_cpu_context_t.
+ ******************************************************************************/
+static void fpu_trap_handler(gp_regs_t *ctx, u_register_t esr)
+{
+	logical_cpu_context_t *curr = (logical_cpu_context_t *)ctx;
+	fpu_cpu_t *fc = fpu_this_cpu();
+
+	fc->stats.nr_traps++;
+	fpu_set_trap(fc, false);
+
+	if (fc->owner == curr)
+		return;
+
+	if (fc->owner != NULL) {
+		fpregs_context_save(get_fpregs_ctx(fc->owner));
+		fc->stats.nr_saves++;
+	}
+
+	fpregs_context_restore(get_fpregs_ctx(curr));
+	fc->stats.nr_restores++;
+	fc->owner = curr;
+}
+
+/*******************************************************************************
+ * Called whenever 'next' is about to run on this CPU. It gets direct access
+ * to FP/SIMD only if its state is still the one in the registers.
+ ******************************************************************************/
+void fpu_switch_to(logical_cpu_context_t *next)
+{
+	fpu_cpu_t *fc = fpu_this_cpu();
+
+	/* Also called on every return to the same process, which isn't one */
+	if (fc->last != next) {
+		fc->stats.nr_switches++;
+		fc->last = next;
+	}
+	fpu_set_trap(fc, fc->owner != next);
+}
+
+void fpu_get_stats(unsigned int cpu, fpu_stats_t *stats)
+{
+	assert(cpu < PLATFORM_CORE_COUNT);
+
+	*stats = fpu_cpus[cpu].stats;
+}
+
+/*******************************************************************************
+ * Number of FP register saves an eager switch would have done on top of the
+ * ones actually performed, over all CPUs.
+ ******************************************************************************/
+uint64_t fpu_saves_avoided(void)
+{
+	uint64_t avoided = 0U;
+
+	for (unsigned int i = 0U; i < PLATFORM_CORE_COUNT; i++) {
+		const fpu_stats_t *st = &fpu_cpus[i].stats;
+
+		if (st->nr_switches > st->nr_saves)
+			avoided += st->nr_switches - st->nr_saves;
+	}
+
+	return avoided;
+}
+
+/*******************************************************************************
+ * Start every CPU without an FP owner and with the trap armed.
+ ******************************************************************************/
+void fpu_cpu_setup(void)
+{
+	fpu_cpu_t *fc = fpu_this_cpu();
+
+	fc->owner = NULL;
+	fc->last = NULL;
+	fpu_trap_arm();
+	isb();
+	fc->trap_armed = true;
+}
+
+void fpu_setup(void)
+{
+	int rc;
+
+	rc = trap_register_handler(EC_FP_SIMD, fpu_trap_handler);
+	assert(rc == 0);
+	(void)rc;
+
+	fpu_cpu_setup();
+
+	VERBOSE("fpu: lazy FP/SIMD switching enabled\n");
+}
+
+#endif /* CTX_INCLUDE_FPREGS */
@@ -13,6 +13,7 @@
 #include <cpu_data.h>
 #include <context.h>
 #include <drivers/gic/gicv3.h>
+#include <fpu.h>
 
 /*******************************************************************************
  * Context management library initialization routine. This library is used by
@@ -46,6 +47,20 @@ uintptr_t cm_get_curr_process(void)
 	return get_cpu_data(cpu_process);
 }
 
+/*******************************************************************************
+ * Return the process exit_kernel_entry is about to resume, after giving it
+ * direct FP/SIMD access if its FP state is still live on this CPU.
+ ******************************************************************************/
+uintptr_t cm_prepare_exit_process(void)
+{
+	uintptr_t process = get_cpu_data(cpu_process);
+
+#if CTX_INCLUDE_FPREGS
+	fpu_switch_to((logical_cpu_context_t *)process);
+#endif
+	return process;
+}
+
 
 /* Context management library setup routine */
 void cpu_arch_setup(void)
@@ -150,6 +165,11 @@ void cpu_arch_setup(void)
 	cpu_ops.setup(prev_mode, cpu_context_ptr, initserver);
 	cpu_ops.next_setup(prev_mode, cpu_context_ptr, initserver);
 
+#if CTX_INCLUDE_FPREGS
+	/* FP/SIMD state is switched lazily, on first use */
+	fpu_setup();
+#endif
+
 }
 
 /*******************************************************************************
@@ -13,12 +13,54 @@
 #include <arch_helpers.h>
 #include <common.h>
 #include <debug.h>
+#include <distributor.h>
 #include <drivers/console/console.h>
+#include <hrtimer.h>
+#include <larged.h>
+#include <mm.h>
+#include <platform.h>
 #include <utils.h>
+#include <vdso.h>
+#include <vm.h>
 
 void kernel_setup(void)
 {
+#if PLAT_XLAT_TABLES_DYNAMIC
+	uint64_t dram_end;
+#endif
 
+	/* Pages for user memory, mapped by plat_arch_setup() */
+	mm_init(PLAT_MM_POOL_BASE, PLAT_MM_POOL_SIZE);
+
+#if PLAT_XLAT_TABLES_DYNAMIC
+	/* 2MB and 1GB frames for large buffers, in the RAM there is */
+	dram_end = plat_get_ns_dram_end();
+	if (dram_end >= (PLAT_LARGED_POOL_BASE + LARGED_2M_SIZE))
+		larged_init(PLAT_LARGED_POOL_BASE,
+			    (size_t)MIN(PLAT_LARGED_POOL_SIZE,
+					dram_end - PLAT_LARGED_POOL_BASE));
+	else
+		INFO("larged: no RAM at 0x%llx, disabled\n",
+		     (unsigned long long)PLAT_LARGED_POOL_BASE);
+#endif
+
+	/*
+	 * ASIDs of the user address spaces, which only exist in the EL1&0
+	 * regime. The QEMU BL1 port runs the kernel at EL3, with the tables
+	 * of qemu_configure_mmu_el3(): there is no TTBR0_EL1 to switch and
+	 * the allocator is left unset.
+	 */
+	if (IS_IN_EL1())
+		vm_asid_init();
+
+	/* One-shot timer queue of the boot CPU */
+	hrtimer_setup();
+
+	/* Periodic SPI affinity balancing, driven from the boot CPU */
+	distributor_setup();
+
+	/* Clock page readable from user space without a trap */
+	vdso_setup();
 }
 
 void init_process_setup(void)
@@ -45,5 +87,8 @@ void bootstrap_kernel(void)
 	init_process_setup();
 	
 	console_flush();
+
+	/* From now on console output is queued and drained by the idle loop */
+	console_ring_enable();
 }
 
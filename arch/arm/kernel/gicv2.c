@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2013-2022, Arm Limited and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <errno.h>
+
+#include <platform_def.h>
+
+#include <arch_helpers.h>
+#include <drivers/gic/gic_common.h>
+#include <drivers/gic/gicv2.h>
+#include <irq.h>
+#include <platform.h>
+#ifdef __aarch64__
+#include <traps.h>
+#endif
+
+/* GICC_IAR/GICC_EOIR: interrupt ID and, for SGIs, the source CPU */
+#define GICV2_IAR_INTID_MASK	U(0x3ff)
+#define GICV2_IAR_SGI_SRC_MASK	U(0x1c00)
+
+/*
+ * The EOI of an SGI must carry the source CPU returned by the acknowledge,
+ * so the last IAR value of each CPU is kept. Interrupts do not nest.
+ */
+typedef struct gicv2_irq_cpu {
+	unsigned int iar;
+} __aligned(CACHE_WRITEBACK_GRANULE) gicv2_irq_cpu_t;
+
+static gicv2_irq_cpu_t gicv2_irq_cpus[PLATFORM_CORE_COUNT];
+
+static unsigned int gicv2_irq_ack(void)
+{
+	unsigned int iar = gicv2_acknowledge_interrupt();
+
+	gicv2_irq_cpus[plat_my_core_pos()].iar = iar;
+
+	return iar & GICV2_IAR_INTID_MASK;
+}
+
+static void gicv2_irq_eoi(unsigned int intid)
+{
+	unsigned int iar = gicv2_irq_cpus[plat_my_core_pos()].iar;
+
+	if (intid < MIN_PPI_ID)
+		intid |= iar & GICV2_IAR_SGI_SRC_MASK;
+
+	gicv2_end_of_interrupt(intid);
+}
+
+/* SGI and PPI registers are banked, 'cpu' is always the calling one. */
+static void gicv2_irq_mask(unsigned int intid, unsigned int cpu)
+{
+	gicv2_disable_interrupt(intid);
+}
+
+static void gicv2_irq_unmask(unsigned int intid, unsigned int cpu)
+{
+	gicv2_enable_interrupt(intid);
+}
+
+static void gicv2_irq_set_type(unsigned int intid, unsigned int cpu,
+			       irq_flow_type_t type)
+{
+	if (type == IRQ_FLOW_PERCPU)
+		return;
+
+	gicv2_interrupt_set_cfg(intid, (type == IRQ_FLOW_LEVEL) ?
+				GIC_INTR_CFG_LEVEL : GIC_INTR_CFG_EDGE);
+}
+
+static void gicv2_irq_set_pending(unsigned int intid, unsigned int cpu)
+{
+	/* SGIs can only be made pending by sending them */
+	if (intid < MIN_PPI_ID)
+		gicv2_raise_sgi((int)intid, (int)cpu);
+	else
+		gicv2_set_interrupt_pending(intid);
+}
+
+static void gicv2_irq_send_sgi(unsigned int intid, const unsigned long *cpus)
+{
+	gicv2_raise_sgi_many((int)intid, cpus, PLATFORM_CORE_COUNT);
+}
+
+static int gicv2_irq_set_affinity(unsigned int intid, unsigned int cpu)
+{
+	if ((intid < MIN_SPI_ID) || (intid > MAX_SPI_ID))
+		return -EINVAL;
+
+	gicv2_set_spi_routing(intid, (int)cpu);
+
+	return 0;
+}
+
+/* Priorities of SGIs and PPIs are banked, those of the calling CPU are set */
+static void gicv2_irq_set_priority(unsigned int intid, unsigned int cpu,
+				   unsigned int priority)
+{
+	gicv2_set_interrupt_priority(intid, priority);
+}
+
+static const irq_chip_t gicv2_irq_chip = {
+	.name = "GICv2",
+	.ack = gicv2_irq_ack,
+	.eoi = gicv2_irq_eoi,
+	.mask = gicv2_irq_mask,
+	.unmask = gicv2_irq_unmask,
+	.set_type = gicv2_irq_set_type,
+	.set_pending = gicv2_irq_set_pending,
+	.send_sgi = gicv2_irq_send_sgi,
+	.set_affinity = gicv2_irq_set_affinity,
+	.set_priority = gicv2_irq_set_priority,
+	.set_pmr = gicv2_set_pmr,
+	.get_running_priority = gicv2_get_running_priority,
+};
+
+#ifdef __aarch64__
+static void gicv2_irq_trap(gp_regs_t *ctx)
+{
+	irq_handle_entry();
+}
+#endif
+
+/*******************************************************************************
+ * Hand the GICv2 CPU interface to the interrupt descriptor layer. The driver
+ * must have been initialised with gicv2_driver_init().
+ ******************************************************************************/
+void gicv2_irq_chip_init(void)
+{
+	irq_chip_register(&gicv2_irq_chip);
+#ifdef __aarch64__
+	trap_set_irq_handler(gicv2_irq_trap);
+#endif
+}
@@ -0,0 +1,209 @@
+/*
+ * Copyright (c) 2013-2022, Arm Limited and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <errno.h>
+
+#include <platform_def.h>
+
+#include <arch.h>
+#include <arch_helpers.h>
+#include <drivers/gic/gic_common.h>
+#include <drivers/gic/gicv3.h>
+#include <drivers/gic/gicv3_its.h>
+#include <irq.h>
+#include <linux/bitmap.h>
+#include <platform.h>
+#ifdef __aarch64__
+#include <traps.h>
+#endif
+
+/* Affinity of every CPU, read from the Redistributors once */
+static u_register_t gicv3_cpu_mpidr[PLATFORM_CORE_COUNT];
+
+/*
+ * The kernel takes Group 1 interrupts of its own security state through the
+ * ICC_*1 registers, except when it is the EL3 monitor.
+ */
+static unsigned int gicv3_irq_ack(void)
+{
+#ifdef CONFIG_ARM_MONITOR_SUPPORT
+	return gicv3_acknowledge_interrupt();
+#else
+	return gicv3_acknowledge_interrupt_sel1();
+#endif
+}
+
+static void gicv3_irq_eoi(unsigned int intid)
+{
+#ifdef CONFIG_ARM_MONITOR_SUPPORT
+	gicv3_end_of_interrupt(intid);
+#else
+	gicv3_end_of_interrupt_sel1(intid);
+#endif
+}
+
+static void gicv3_irq_mask(unsigned int intid, unsigned int cpu)
+{
+#if GICV3_ITS_SUPPORT
+	if (intid >= MIN_LPI_ID) {
+		gicv3_its_lpi_disable(intid);
+		return;
+	}
+#endif
+	gicv3_disable_interrupt(intid, cpu);
+}
+
+static void gicv3_irq_unmask(unsigned int intid, unsigned int cpu)
+{
+#if GICV3_ITS_SUPPORT
+	if (intid >= MIN_LPI_ID) {
+		gicv3_its_lpi_enable(intid);
+		return;
+	}
+#endif
+	gicv3_enable_interrupt(intid, cpu);
+}
+
+static void gicv3_irq_set_type(unsigned int intid, unsigned int cpu,
+			       irq_flow_type_t type)
+{
+	/*
+	 * SGIs and LPIs are always edge triggered, PPIs are left as firmware
+	 * set them.
+	 */
+	if ((type == IRQ_FLOW_PERCPU) || (intid >= MIN_LPI_ID))
+		return;
+
+	gicv3_interrupt_set_cfg(intid, cpu, (type == IRQ_FLOW_LEVEL) ?
+				GIC_INTR_CFG_LEVEL : GIC_INTR_CFG_EDGE);
+}
+
+static void gicv3_irq_set_pending(unsigned int intid, unsigned int cpu)
+{
+#if GICV3_ITS_SUPPORT
+	if (intid >= MIN_LPI_ID) {
+		(void)gicv3_its_lpi_inject(intid);
+		return;
+	}
+#endif
+	gicv3_set_interrupt_pending(intid, cpu);
+}
+
+static inline void gicv3_write_sgir(uint64_t sgir)
+{
+#ifdef CONFIG_ARM_MONITOR_SUPPORT
+	write_icc_sgi0r_el1(sgir);
+#else
+	write_icc_sgi1r(sgir);
+#endif
+}
+
+/*
+ * CPUs are grouped by Aff3.Aff2.Aff1 and by range of 16 Aff0 values; each
+ * group is reached with a single ICC_SGI*R write using its target list.
+ */
+static void gicv3_irq_send_sgi(unsigned int intid, const unsigned long *cpus)
+{
+	DECLARE_BITMAP(left, PLATFORM_CORE_COUNT);
+	unsigned int cpu, other, tgt;
+	u_register_t mpidr, group;
+	uint64_t sgir;
+
+	bitmap_copy(left, cpus, PLATFORM_CORE_COUNT);
+
+	/* Updates the target CPUs act upon must be visible first */
+	dsbishst();
+
+	for_each_set_bit(cpu, left, PLATFORM_CORE_COUNT) {
+		mpidr = gicv3_cpu_mpidr[cpu];
+		group = mpidr & ~(u_register_t)(GICV3_MAX_SGI_TARGETS - 1U);
+		tgt = 0U;
+
+		for (other = cpu; other < PLATFORM_CORE_COUNT; other++) {
+			if (!test_bit(other, left) ||
+			    ((gicv3_cpu_mpidr[other] & ~(u_register_t)
+			      (GICV3_MAX_SGI_TARGETS - 1U)) != group))
+				continue;
+
+			tgt |= BIT_32(MPIDR_AFFLVL0_VAL(gicv3_cpu_mpidr[other]) %
+				      GICV3_MAX_SGI_TARGETS);
+			__clear_bit(other, left);
+		}
+
+		sgir = GICV3_SGIR_VALUE(MPIDR_AFFLVL3_VAL(mpidr),
+					MPIDR_AFFLVL2_VAL(mpidr),
+					MPIDR_AFFLVL1_VAL(mpidr), intid,
+					SGIR_IRM_TO_AFF, tgt) |
+		       (((uint64_t)MPIDR_AFFLVL0_VAL(mpidr) /
+			 GICV3_MAX_SGI_TARGETS) << SGIR_RS_SHIFT);
+		gicv3_write_sgir(sgir);
+	}
+
+	isb();
+}
+
+static int gicv3_irq_set_affinity(unsigned int intid, unsigned int cpu)
+{
+#if GICV3_ITS_SUPPORT
+	if (intid >= MIN_LPI_ID)
+		return gicv3_its_lpi_set_affinity(intid, cpu);
+#endif
+	if (!IS_SPI(intid))
+		return -EINVAL;
+
+	gicv3_set_spi_routing(intid, GICV3_IRM_PE, gicv3_cpu_mpidr[cpu]);
+
+	return 0;
+}
+
+static void gicv3_irq_set_priority(unsigned int intid, unsigned int cpu,
+				   unsigned int priority)
+{
+#if GICV3_ITS_SUPPORT
+	if (intid >= MIN_LPI_ID) {
+		gicv3_its_lpi_set_priority(intid, priority);
+		return;
+	}
+#endif
+	gicv3_set_interrupt_priority(intid, cpu, priority);
+}
+
+static const irq_chip_t gicv3_irq_chip = {
+	.name = "GICv3",
+	.ack = gicv3_irq_ack,
+	.eoi = gicv3_irq_eoi,
+	.mask = gicv3_irq_mask,
+	.unmask = gicv3_irq_unmask,
+	.set_type = gicv3_irq_set_type,
+	.set_pending = gicv3_irq_set_pending,
+	.send_sgi = gicv3_irq_send_sgi,
+	.set_affinity = gicv3_irq_set_affinity,
+	.set_priority = gicv3_irq_set_priority,
+	.set_pmr = gicv3_set_pmr,
+	.get_running_priority = gicv3_get_running_priority,
+};
+
+#ifdef __aarch64__
+static void gicv3_irq_trap(gp_regs_t *ctx)
+{
+	irq_handle_entry();
+}
+#endif
+
+/*******************************************************************************
+ * Hand the GICv3 CPU interface to the interrupt descriptor layer. The driver
+ * must have been initialised with gicv3_driver_init().
+ ******************************************************************************/
+void gicv3_irq_chip_init(void)
+{
+	for (unsigned int cpu = 0U; cpu < PLATFORM_CORE_COUNT; cpu++)
+		gicv3_cpu_mpidr[cpu] = gicv3_rdistif_get_mpidr(cpu);
+
+	irq_chip_register(&gicv3_irq_chip);
+#ifdef __aarch64__
+	trap_set_irq_handler(gicv3_irq_trap);
+#endif
+}
@@ -0,0 +1,495 @@
+/*
+ * Copyright (c) 2013-2022, Arm Limited and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+
+#include <platform_def.h>
+
+#include <arch.h>
+#include <arch_features.h>
+#include <arch_helpers.h>
+#include <debug.h>
+#include <drivers/delay_timer/clocksource.h>
+#include <hrtimer.h>
+#include <irq.h>
+#include <irqflags.h>
+#include <platform.h>
+#include <spinlock.h>
+
+/*
+ * Per-CPU timer base. The lock is needed because a timer may be cancelled
+ * from another CPU than the one it is queued on; interrupts are masked on
+ * the owning CPU whenever the lock is held.
+ */
+typedef struct hrtimer_cpu_base {
+	spinlock_t lock;
+	struct rb_root_cached active;
+	/* Expiry currently programmed into the compare register */
+	uint64_t next_event;
+	/* Timer whose callback is running, so that cancel can wait for it */
+	hrtimer_t *volatile running;
+	bool in_interrupt;
+	unsigned int nr_events;
+	unsigned int nr_batched;
+} __aligned(CACHE_WRITEBACK_GRANULE) hrtimer_cpu_base_t;
+
+static hrtimer_cpu_base_t hrtimer_bases[PLATFORM_CORE_COUNT];
+
+/*
+ * The timer's own counter, with the cycle <-> nanosecond factors precomputed so
+ * that the clock read and the deadline programming only multiply and shift.
+ */
+static clocksource_t hrtimer_cs;
+
+#if HRTIMER_USE_CNTP
+#define hrtimer_read_counter()		read_cntpct_el0()
+#define hrtimer_write_cval(_v)		write_cntp_cval_el0(_v)
+#define hrtimer_write_ctl(_v)		write_cntp_ctl_el0(_v)
+#else
+#define hrtimer_read_counter()		read_cntvct_el0()
+#define hrtimer_write_cval(_v)		write_cntv_cval_el0(_v)
+#define hrtimer_write_ctl(_v)		write_cntv_ctl_el0(_v)
+#endif
+
+#define HRTIMER_CTL_ENABLE		(U(1) << CNTP_CTL_ENABLE_SHIFT)
+#define HRTIMER_CTL_IMASK		(U(1) << CNTP_CTL_IMASK_SHIFT)
+
+static uint64_t hrtimer_counter_read(void)
+{
+	/* Keep the counter read from being speculated ahead of the caller. */
+	isb();
+	return hrtimer_read_counter();
+}
+
+/*******************************************************************************
+ * Return the current time in nanoseconds.
+ ******************************************************************************/
+uint64_t hrtimer_now(void)
+{
+	return clocksource_cyc2ns(&hrtimer_cs, clocksource_read(&hrtimer_cs));
+}
+
+/*******************************************************************************
+ * Return the counter and conversion factors behind hrtimer_now().
+ ******************************************************************************/
+const clocksource_t *hrtimer_clocksource(void)
+{
+	return &hrtimer_cs;
+}
+
+static inline hrtimer_cpu_base_t *hrtimer_this_base(void)
+{
+	return &hrtimer_bases[plat_my_core_pos()];
+}
+
+static u_register_t hrtimer_base_lock(hrtimer_cpu_base_t *base)
+{
+	u_register_t flags = local_irq_save();
+
+	spin_lock(&base->lock);
+
+	return flags;
+}
+
+static void hrtimer_base_unlock(hrtimer_cpu_base_t *base, u_register_t flags)
+{
+	spin_unlock(&base->lock);
+	local_irq_restore(flags);
+}
+
+static bool hrtimer_less(struct rb_node *a, const struct rb_node *b)
+{
+	return rb_entry(a, hrtimer_t, node)->expires <
+		rb_entry(b, hrtimer_t, node)->expires;
+}
+
+static void hrtimer_enqueue(hrtimer_cpu_base_t *base, hrtimer_t *timer)
+{
+	rb_add_cached(&timer->node, &base->active, hrtimer_less);
+	timer->base = base;
+}
+
+static void hrtimer_dequeue(hrtimer_cpu_base_t *base, hrtimer_t *timer)
+{
+	rb_erase_cached(&timer->node, &base->active);
+	RB_CLEAR_NODE(&timer->node);
+	timer->base = NULL;
+}
+
+static uint64_t hrtimer_first_expiry(hrtimer_cpu_base_t *base)
+{
+	struct rb_node *first = rb_first_cached(&base->active);
+
+	if (first == NULL)
+		return HRTIMER_EXPIRES_NEVER;
+
+	return rb_entry(first, hrtimer_t, node)->expires;
+}
+
+/*
+ * Expiry the compare register is programmed with: the last one within
+ * HRTIMER_BATCH_NS of the earliest, so that the timers in between are all due
+ * when the interrupt fires, and run from it.
+ */
+static uint64_t hrtimer_batch_expiry(hrtimer_cpu_base_t *base)
+{
+	struct rb_node *node = rb_first_cached(&base->active);
+	uint64_t first, expires;
+
+	if (node == NULL)
+		return HRTIMER_EXPIRES_NEVER;
+
+	first = rb_entry(node, hrtimer_t, node)->expires;
+	expires = first;
+	while ((node = rb_next(node)) != NULL) {
+		uint64_t next = rb_entry(node, hrtimer_t, node)->expires;
+
+		if ((next - first) > HRTIMER_BATCH_NS)
+			break;
+		expires = next;
+	}
+
+	return expires;
+}
+
+/*
+ * Program the compare register for the pending timers, or mask the timer when
+ * nothing is queued. Must be called on the CPU owning 'base'.
+ */
+static void hrtimer_reprogram(hrtimer_cpu_base_t *base)
+{
+	uint64_t expires = hrtimer_batch_expiry(base);
+
+	if (expires == base->next_event)
+		return;
+
+	base->next_event = expires;
+
+	if (expires == HRTIMER_EXPIRES_NEVER) {
+		hrtimer_write_ctl(HRTIMER_CTL_IMASK);
+		return;
+	}
+
+	/* Round up so that the interrupt never fires before the deadline. */
+	hrtimer_write_cval(clocksource_ns2cyc(&hrtimer_cs, expires) + 1U);
+	hrtimer_write_ctl(HRTIMER_CTL_ENABLE);
+	isb();
+}
+
+/*******************************************************************************
+ * Initialise a timer before its first use.
+ ******************************************************************************/
+void hrtimer_init(hrtimer_t *timer,
+		  hrtimer_restart_t (*function)(hrtimer_t *timer))
+{
+	assert(function != NULL);
+
+	RB_CLEAR_NODE(&timer->node);
+	timer->expires = 0U;
+	timer->function = function;
+	timer->base = NULL;
+}
+
+/*******************************************************************************
+ * Arm (or re-arm) a timer on the calling CPU to expire at the absolute time
+ * 'expires' in nanoseconds.
+ ******************************************************************************/
+void hrtimer_start(hrtimer_t *timer, uint64_t expires)
+{
+	hrtimer_cpu_base_t *base;
+	u_register_t flags;
+
+	(void)hrtimer_cancel(timer);
+
+	base = hrtimer_this_base();
+	flags = hrtimer_base_lock(base);
+
+	timer->expires = expires;
+	hrtimer_enqueue(base, timer);
+
+	/* The interrupt handler reprograms once it is done with the batch. */
+	if (!base->in_interrupt)
+		hrtimer_reprogram(base);
+
+	hrtimer_base_unlock(base, flags);
+}
+
+void hrtimer_start_rel(hrtimer_t *timer, uint64_t delta)
+{
+	hrtimer_start(timer, hrtimer_now() + delta);
+}
+
+/*******************************************************************************
+ * Remove a timer from its queue. If its callback is running on another CPU,
+ * wait for it to complete. Returns true if the timer was pending.
+ ******************************************************************************/
+bool hrtimer_cancel(hrtimer_t *timer)
+{
+	hrtimer_cpu_base_t *base;
+	u_register_t flags;
+	bool queued;
+
+	for (;;) {
+		base = timer->base;
+		if (base == NULL) {
+			queued = false;
+			break;
+		}
+
+		flags = hrtimer_base_lock(base);
+		/* The timer may have expired or moved while we took the lock. */
+		if (timer->base != base) {
+			hrtimer_base_unlock(base, flags);
+			continue;
+		}
+
+		hrtimer_dequeue(base, timer);
+		/*
+		 * A stale compare value on a remote CPU only costs a spurious
+		 * interrupt there, which will reprogram it.
+		 */
+		if ((base == hrtimer_this_base()) && !base->in_interrupt)
+			hrtimer_reprogram(base);
+		hrtimer_base_unlock(base, flags);
+		queued = true;
+		break;
+	}
+
+	/* Wait for a callback running elsewhere, but not for our own caller. */
+	for (unsigned int i = 0U; i < PLATFORM_CORE_COUNT; i++) {
+		if (&hrtimer_bases[i] == hrtimer_this_base())
+			continue;
+		while (hrtimer_bases[i].running == timer)
+			;
+	}
+
+	return queued;
+}
+
+/*******************************************************************************
+ * Move the expiry of a periodic timer forward by whole 'interval's until it is
+ * after 'now'. Returns the number of intervals skipped, so callers can account
+ * for overruns. Meant to be called from the timer callback.
+ ******************************************************************************/
+uint64_t hrtimer_forward(hrtimer_t *timer, uint64_t now, uint64_t interval)
+{
+	uint64_t delta, overruns;
+
+	assert(interval != 0U);
+
+	if (now < timer->expires)
+		return 0U;
+
+	delta = now - timer->expires;
+	overruns = 1U;
+	/* The divide is only paid when we are more than one period late. */
+	if (delta >= interval)
+		overruns += delta / interval;
+
+	timer->expires += overruns * interval;
+
+	return overruns;
+}
+
+/*******************************************************************************
+ * Return the earliest expiry queued on the calling CPU.
+ ******************************************************************************/
+uint64_t hrtimer_next_event(void)
+{
+	hrtimer_cpu_base_t *base = hrtimer_this_base();
+	u_register_t flags;
+	uint64_t expires;
+
+	flags = hrtimer_base_lock(base);
+	expires = hrtimer_first_expiry(base);
+	hrtimer_base_unlock(base, flags);
+
+	return expires;
+}
+
+/*******************************************************************************
+ * Timer interrupt handler, called for the generic timer PPI. All the timers
+ * due are run, which thanks to the batching of hrtimer_reprogram() are often
+ * several. The clock is read again after each batch in case the callbacks
+ * took long enough for more timers to become due.
+ ******************************************************************************/
+void hrtimer_interrupt(void)
+{
+	hrtimer_cpu_base_t *base = hrtimer_this_base();
+	hrtimer_restart_t restart;
+	struct rb_node *first;
+	hrtimer_t *timer;
+	u_register_t flags;
+	unsigned int nr = 0U;
+	uint64_t now;
+
+	/* Callbacks run with interrupts masked, the lock is dropped for them. */
+	flags = hrtimer_base_lock(base);
+	if (base->in_interrupt) {
+		hrtimer_base_unlock(base, flags);
+		return;
+	}
+	base->in_interrupt = true;
+	base->nr_events++;
+
+	/* Silence the current compare until the batch has been processed. */
+	hrtimer_write_ctl(HRTIMER_CTL_IMASK);
+	base->next_event = HRTIMER_EXPIRES_NEVER;
+
+	do {
+		now = hrtimer_now();
+
+		while ((first = rb_first_cached(&base->active)) != NULL) {
+			timer = rb_entry(first, hrtimer_t, node);
+			if (timer->expires > now)
+				break;
+
+			/* Would have taken an interrupt of its own */
+			if (nr++ != 0U)
+				base->nr_batched++;
+
+			hrtimer_dequeue(base, timer);
+			base->running = timer;
+			spin_unlock(&base->lock);
+
+			restart = timer->function(timer);
+
+			spin_lock(&base->lock);
+			/* The callback may have re-armed the timer itself. */
+			if ((restart != HRTIMER_NORESTART) && (timer->base == NULL))
+				hrtimer_enqueue(base, timer);
+			base->running = NULL;
+		}
+	} while (hrtimer_first_expiry(base) <= hrtimer_now());
+
+	base->in_interrupt = false;
+	hrtimer_reprogram(base);
+	hrtimer_base_unlock(base, flags);
+}
+
+/*******************************************************************************
+ * Called by the idle loop before sleeping. Runs anything that became due while
+ * the CPU was busy and leaves the compare register holding the next deadline,
+ * so that the CPU sleeps until then without any periodic tick.
+ ******************************************************************************/
+void hrtimer_idle_enter(void)
+{
+	if (hrtimer_next_event() <= hrtimer_now())
+		hrtimer_interrupt();
+}
+
+static irq_return_t hrtimer_irq_handler(unsigned int intid, void *data)
+{
+	hrtimer_interrupt();
+
+	return IRQ_HANDLED;
+}
+
+/*******************************************************************************
+ * Set up the calling CPU's timer: masked, with an empty queue, and its PPI
+ * handled by hrtimer_interrupt(). Called by every CPU once its interrupt
+ * controller interface is up.
+ ******************************************************************************/
+void hrtimer_cpu_setup(void)
+{
+	hrtimer_cpu_base_t *base = hrtimer_this_base();
+	int rc;
+
+	base->active = RB_ROOT_CACHED;
+	base->next_event = HRTIMER_EXPIRES_NEVER;
+	base->running = NULL;
+	base->in_interrupt = false;
+
+	hrtimer_write_ctl(HRTIMER_CTL_IMASK);
+	isb();
+
+	rc = irq_request(HRTIMER_PPI, IRQ_FLOW_PERCPU, hrtimer_irq_handler,
+			 NULL, "hrtimer");
+	assert(rc == 0);
+	(void)rc;
+}
+
+/*******************************************************************************
+ * Compute the clock conversion factors and set up the boot CPU's timer. Must
+ * run on the boot CPU before any other hrtimer call, once the interrupt
+ * controller is registered.
+ ******************************************************************************/
+void hrtimer_setup(void)
+{
+	uint32_t freq;
+
+	assert(is_armv7_gentimer_present());
+
+	freq = (uint32_t)read_cntfrq_el0();
+	assert(freq != 0U);
+
+	clocksource_init(&hrtimer_cs, hrtimer_counter_read, 64U, freq);
+
+	VERBOSE("hrtimer: %u Hz counter, mult=%u shift=%u\n",
+		freq, hrtimer_cs.mult, hrtimer_cs.shift);
+
+	hrtimer_cpu_setup();
+}
+
+#if HRTIMER_JITTER_BENCH
+/*******************************************************************************
+ * Jitter benchmark, meant to be run on QEMU: a periodic timer records how late
+ * each expiry is handled relative to its deadline.
+ ******************************************************************************/
+static struct hrtimer_bench {
+	hrtimer_t timer;
+	uint64_t period;
+	uint64_t min, max, sum;
+	unsigned int left, samples;
+} hrtimer_bench;
+
+static hrtimer_restart_t hrtimer_bench_fn(hrtimer_t *timer)
+{
+	uint64_t now = hrtimer_now();
+	uint64_t late = (now > timer->expires) ? (now - timer->expires) : 0U;
+
+	hrtimer_bench.min = MIN(hrtimer_bench.min, late);
+	hrtimer_bench.max = MAX(hrtimer_bench.max, late);
+	hrtimer_bench.sum += late;
+	hrtimer_bench.samples++;
+
+	if (--hrtimer_bench.left == 0U)
+		return HRTIMER_NORESTART;
+
+	(void)hrtimer_forward(timer, now, hrtimer_bench.period);
+	return HRTIMER_RESTART;
+}
+
+void hrtimer_jitter_bench(uint64_t period, unsigned int loops)
+{
+	assert((period != 0U) && (loops != 0U));
+
+	hrtimer_bench.period = period;
+	hrtimer_bench.min = UINT64_MAX;
+	hrtimer_bench.max = 0U;
+	hrtimer_bench.sum = 0U;
+	hrtimer_bench.left = loops;
+	hrtimer_bench.samples = 0U;
+
+	hrtimer_init(&hrtimer_bench.timer, hrtimer_bench_fn);
+	hrtimer_start_rel(&hrtimer_bench.timer, period);
+
+	while (hrtimer_is_queued(&hrtimer_bench.timer) ||
+	       (hrtimer_bench.left != 0U)) {
+		hrtimer_idle_enter();
+		wfi();
+		hrtimer_interrupt();
+	}
+
+	INFO("hrtimer jitter: period %llu ns, %u samples, "
+	     "min %llu max %llu avg %llu ns\n",
+	     (unsigned long long)period, hrtimer_bench.samples,
+	     (unsigned long long)hrtimer_bench.min,
+	     (unsigned long long)hrtimer_bench.max,
+	     (unsigned long long)(hrtimer_bench.sum / hrtimer_bench.samples));
+}
+#endif /* HRTIMER_JITTER_BENCH */
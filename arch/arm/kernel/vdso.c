@@ -0,0 +1,131 @@
+/*
+ * Copyright (c) 2013-2022, Arm Limited and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <assert.h>
+
+#include <arch.h>
+#include <arch_helpers.h>
+#include <cassert.h>
+#include <debug.h>
+#include <hrtimer.h>
+#include <irqflags.h>
+#include <lib/xlat_tables/xlat_tables_defs.h>
+#include <lib/xlat_tables/xlat_tables_v2.h>
+#include <vdso.h>
+
+#ifndef __aarch64__
+#define EL0VCTEN_BIT		PL0VCTEN_BIT
+#define EL0PCTEN_BIT		PL0PCTEN_BIT
+#endif
+
+/*
+ * The clock page. It is page sized and aligned so that mapping it into a user
+ * address space exposes nothing else of the kernel image.
+ */
+static union {
+	vdso_data_t data;
+	uint8_t page[PAGE_SIZE];
+} vdso_page __aligned(PAGE_SIZE);
+
+CASSERT(sizeof(vdso_page) == PAGE_SIZE, assert_vdso_page_size);
+
+static inline void vdso_write_begin(vdso_data_t *vd)
+{
+	vd->seq++;
+	/* Readers must see the odd count before any of the new values. */
+	dmbishst();
+}
+
+static inline void vdso_write_end(vdso_data_t *vd)
+{
+	/* Readers must see the new values before the even count. */
+	dmbishst();
+	vd->seq++;
+}
+
+/*******************************************************************************
+ * Let EL0 read the counter the clock page is based on. Must be called on every
+ * CPU that runs user code.
+ ******************************************************************************/
+void vdso_cpu_setup(void)
+{
+	u_register_t cntkctl = read_cntkctl_el1();
+
+	if (vdso_page.data.clock_mode == VDSO_CLOCK_CNTPCT)
+		cntkctl |= EL0PCTEN_BIT;
+	else
+		cntkctl |= EL0VCTEN_BIT;
+
+	write_cntkctl_el1(cntkctl);
+	isb();
+}
+
+/*******************************************************************************
+ * Publish the hrtimer clock in the clock page. hrtimer_setup() must have run.
+ ******************************************************************************/
+void vdso_setup(void)
+{
+	const clocksource_t *cs = hrtimer_clocksource();
+	vdso_data_t *vd = &vdso_page.data;
+
+	assert(cs->mult != 0U);
+
+	vdso_write_begin(vd);
+	vd->clock_mode = (HRTIMER_USE_CNTP != 0) ?
+		VDSO_CLOCK_CNTPCT : VDSO_CLOCK_CNTVCT;
+	vd->mult = cs->mult;
+	vd->shift = cs->shift;
+	vd->mask = cs->mask;
+	vd->realtime_offset = 0U;
+	vdso_write_end(vd);
+
+	vdso_cpu_setup();
+
+	VERBOSE("vdso: clock page at %p, mult=%u shift=%u\n",
+		(void *)vd, vd->mult, vd->shift);
+}
+
+/*******************************************************************************
+ * Set the wall clock time, e.g. from an RTC.
+ ******************************************************************************/
+void vdso_set_realtime(uint64_t realtime_ns)
+{
+	vdso_data_t *vd = &vdso_page.data;
+	u_register_t flags;
+
+	/* A writer preempted with an odd count would stall all readers. */
+	flags = local_irq_save();
+	vdso_write_begin(vd);
+	vd->realtime_offset = realtime_ns - hrtimer_now();
+	vdso_write_end(vd);
+	local_irq_restore(flags);
+}
+
+const vdso_data_t *vdso_data(void)
+{
+	return &vdso_page.data;
+}
+
+#if PLAT_XLAT_TABLES_DYNAMIC
+/*******************************************************************************
+ * Map the clock page read-only for EL0 at 'base_va' of a user context.
+ ******************************************************************************/
+int vdso_map(xlat_ctx_t *ctx, uintptr_t base_va)
+{
+	mmap_region_t mm = MAP_REGION((uintptr_t)&vdso_page, base_va,
+				      PAGE_SIZE,
+				      MT_RO_DATA | MT_USER | MT_NS);
+
+	assert((base_va & PAGE_SIZE_MASK) == 0U);
+
+	return mmap_add_dynamic_region_ctx(ctx, &mm);
+}
+
+int vdso_unmap(xlat_ctx_t *ctx, uintptr_t base_va)
+{
+	return mmap_remove_dynamic_region_ctx(ctx, base_va, PAGE_SIZE);
+}
+#endif /* PLAT_XLAT_TABLES_DYNAMIC */
@@ -119,6 +119,32 @@ void xlat_arch_tlbi_va(uintptr_t va, int xlat_regime)
 	}
 }
 
+void xlat_arch_tlbi_va_range(uintptr_t va, size_t size, int xlat_regime)
+{
+	size_t pages = ((va + size - 1U) >> PAGE_SIZE_SHIFT) -
+			(va >> PAGE_SIZE_SHIFT) + 1U;
+
+	assert(size > 0U);
+	va &= ~(uintptr_t)PAGE_SIZE_MASK;
+	dsbishst();
+
+	/* There are no range instructions in AArch32 */
+	if ((xlat_regime == EL1_EL0_REGIME) &&
+	    (pages > XLAT_TLBI_FULL_THRESHOLD)) {
+		tlbiallis();
+		return;
+	}
+
+	for (; pages > 0U; pages--, va += PAGE_SIZE) {
+		if (xlat_regime == EL1_EL0_REGIME) {
+			tlbimvaais(TLBI_ADDR(va));
+		} else {
+			assert(xlat_regime == EL2_REGIME);
+			tlbimvahis(TLBI_ADDR(va));
+		}
+	}
+}
+
 void xlat_arch_tlbi_va_sync(void)
 {
 	/* Invalidate all entries from branch predictors. */
@@ -145,6 +171,51 @@ void xlat_arch_tlbi_va_sync(void)
 	isb();
 }
 
+/*
+ * Translates 'va' with the MMU when 'ctx' is the context the PE currently
+ * translates with, i.e. the MMU is on and TTBR0 (HTTBR at PL2) points to its
+ * base table. Returns false otherwise, or if the walk faulted.
+ */
+bool xlat_arch_va_to_pa(const xlat_ctx_t *ctx, uintptr_t va,
+			unsigned long long *pa)
+{
+	bool hyp = (xlat_arch_current_el() == 2U);
+	u_register_t cpsr;
+	uint64_t ttbr, par;
+
+	if ((ctx->xlat_regime == EL2_REGIME) != hyp)
+		return false;
+
+	/* Base address only, without the ASID and the CnP bit */
+	ttbr = hyp ? read64_httbr() : read64_ttbr0();
+	ttbr &= ULL(0x0000fffffffffffe);
+	if ((ttbr != (uintptr_t)ctx->base_table) || !is_mmu_enabled_ctx(ctx))
+		return false;
+
+	/* PAR would be overwritten by an ATS1 in an interrupt handler */
+	cpsr = read_daif();
+	disable_irq();
+	disable_fiq();
+
+	if (hyp) {
+		write_ats1hr(va);
+	} else {
+		write_ats1cpr(va);
+	}
+	isb();
+	par = read64_par();
+
+	write_daif(cpsr);
+
+	if ((par & PAR_F_MASK) != 0U)
+		return false;
+
+	*pa = (par & (PAR_ADDR_MASK << PAR_ADDR_SHIFT)) |
+	      (va & PAGE_SIZE_MASK);
+
+	return true;
+}
+
 unsigned int xlat_arch_current_el(void)
 {
 	if (IS_IN_HYP()) {
@@ -212,6 +212,87 @@ void xlat_arch_tlbi_va(uintptr_t va, int xlat_regime)
 	}
 }
 
+static void xlat_arch_tlbi_all(int xlat_regime)
+{
+	if (xlat_regime == EL1_EL0_REGIME) {
+		assert(xlat_arch_current_el() >= 1U);
+		tlbivmalle1is();
+	} else if (xlat_regime == EL2_REGIME) {
+		assert(xlat_arch_current_el() >= 2U);
+		tlbialle2is();
+	} else {
+		assert(xlat_regime == EL3_REGIME);
+		assert(xlat_arch_current_el() >= 3U);
+		tlbialle3is();
+	}
+}
+
+static void xlat_arch_tlbi_range_op(uint64_t op, int xlat_regime)
+{
+	if (xlat_regime == EL1_EL0_REGIME) {
+		tlbirvaae1is(op);
+	} else if (xlat_regime == EL2_REGIME) {
+		tlbirvae2is(op);
+	} else {
+		tlbirvae3is(op);
+	}
+}
+
+void xlat_arch_tlbi_va_range(uintptr_t va, size_t size, int xlat_regime)
+{
+	uint64_t pages = ((va + size - 1U) >> PAGE_SIZE_SHIFT) -
+			(va >> PAGE_SIZE_SHIFT) + 1U;
+	unsigned int scale = 0U;
+	bool range = is_armv8_4_tlbi_range_present();
+
+	assert(size > 0U);
+	va &= ~(uintptr_t)PAGE_SIZE_MASK;
+
+	assert((xlat_regime == EL1_EL0_REGIME) ||
+	       (xlat_regime == EL2_REGIME) || (xlat_regime == EL3_REGIME));
+
+	if ((!range && (pages > XLAT_TLBI_FULL_THRESHOLD)) ||
+	    (pages >= TLBI_RANGE_MAX_PAGES)) {
+		dsbishst();
+		xlat_arch_tlbi_all(xlat_regime);
+		return;
+	}
+
+	if (!range) {
+		for (; pages > 0U; pages--, va += PAGE_SIZE)
+			xlat_arch_tlbi_va(va, xlat_regime);
+		return;
+	}
+
+	dsbishst();
+
+	/*
+	 * An odd page count starts with a single page. The rest is covered by
+	 * one range per SCALE, from the smallest one: bits [5 * SCALE + 5 :
+	 * 5 * SCALE + 1] of the page count are NUM + 1 of that range.
+	 */
+	while (pages > 0U) {
+		unsigned int num;
+
+		if ((pages % 2U) != 0U) {
+			xlat_arch_tlbi_va(va, xlat_regime);
+			va += PAGE_SIZE;
+			pages--;
+			continue;
+		}
+
+		num = (unsigned int)(pages >> ((5U * scale) + 1U)) &
+		      TLBI_RANGE_NUM_MASK;
+		if (num != 0U) {
+			xlat_arch_tlbi_range_op(TLBI_RANGE(va, scale, num - 1U),
+						xlat_regime);
+			va += TLBI_RANGE_PAGES(num - 1U, scale) << PAGE_SIZE_SHIFT;
+			pages -= TLBI_RANGE_PAGES(num - 1U, scale);
+		}
+		scale++;
+	}
+}
+
 void xlat_arch_tlbi_va_sync(void)
 {
 	/*
@@ -235,6 +316,57 @@ void xlat_arch_tlbi_va_sync(void)
 	isb();
 }
 
+/*
+ * Translates 'va' with the MMU when 'ctx' is the context the PE currently
+ * translates with, i.e. the MMU is on and TTBR0 of its regime points to its
+ * base table. Returns false otherwise, or if the walk faulted.
+ */
+bool xlat_arch_va_to_pa(const xlat_ctx_t *ctx, uintptr_t va,
+			unsigned long long *pa)
+{
+	unsigned int el = xlat_arch_current_el();
+	u_register_t ttbr, daif;
+	uint64_t par;
+
+	if (ctx->xlat_regime == EL1_EL0_REGIME) {
+		ttbr = read_ttbr0_el1();
+	} else if ((ctx->xlat_regime == EL2_REGIME) && (el >= 2U)) {
+		ttbr = read_ttbr0_el2();
+	} else if ((ctx->xlat_regime == EL3_REGIME) && (el == 3U)) {
+		ttbr = read_ttbr0_el3();
+	} else {
+		return false;
+	}
+
+	ttbr &= ~(TTBR_CNP_BIT | (TTBR_ASID_MASK << TTBR_ASID_SHIFT));
+	if ((ttbr != (uintptr_t)ctx->base_table) || !is_mmu_enabled_ctx(ctx))
+		return false;
+
+	/* PAR_EL1 would be overwritten by an AT in an interrupt handler */
+	daif = read_daif();
+	write_daifset(DAIF_FIQ_BIT | DAIF_IRQ_BIT);
+
+	if (ctx->xlat_regime == EL1_EL0_REGIME) {
+		AT(ats1e1r, va);
+	} else if (ctx->xlat_regime == EL2_REGIME) {
+		ats1e2r(va);
+	} else {
+		ats1e3r(va);
+	}
+	isb();
+	par = read_par_el1();
+
+	write_daif(daif);
+
+	if ((par & PAR_F_MASK) != 0U)
+		return false;
+
+	*pa = (par & (PAR_ADDR_MASK << PAR_ADDR_SHIFT)) |
+	      (va & PAGE_SIZE_MASK);
+
+	return true;
+}
+
 unsigned int xlat_arch_current_el(void)
 {
 	unsigned int el = (unsigned int)GET_EL(read_CurrentEl());
@@ -303,6 +435,14 @@ void setup_mmu_cfg(uint64_t *params, unsigned int flags,
 		 * that are translated using TTBR1_EL1.
 		 */
 		tcr |= TCR_EPD1_BIT | (tcr_ps_bits << TCR_EL1_IPS_SHIFT);
+
+		/* Use 16-bit ASIDs where implemented, see kernel/vm.c */
+		u_register_t asid_bits = (read_id_aa64mmfr0_el1() >>
+					  ID_AA64MMFR0_EL1_ASIDBITS_SHIFT) &
+					 ID_AA64MMFR0_EL1_ASIDBITS_MASK;
+
+		if (asid_bits == ID_AA64MMFR0_EL1_ASIDBITS_16)
+			tcr |= TCR_AS_BIT;
 	} else if (xlat_regime == EL2_REGIME) {
 		tcr |= TCR_EL2_RES1 | (tcr_ps_bits << TCR_EL2_PS_SHIFT);
 	} else {
@@ -70,6 +70,16 @@ int mmap_add_dynamic_region(unsigned long long base_pa, uintptr_t base_va,
 	return mmap_add_dynamic_region_ctx(&xxx_xlat_ctx, &mm);
 }
 
+int mmap_add_dynamic_region2(unsigned long long base_pa, uintptr_t base_va,
+			     size_t size, unsigned int attr,
+			     size_t granularity)
+{
+	mmap_region_t mm = MAP_REGION2(base_pa, base_va, size, attr,
+				       granularity);
+
+	return mmap_add_dynamic_region_ctx(&xxx_xlat_ctx, &mm);
+}
+
 int mmap_add_dynamic_region_alloc_va(unsigned long long base_pa,
 				     uintptr_t *base_va, size_t size,
 				     unsigned int attr)
@@ -120,6 +130,11 @@ int xlat_change_mem_attributes(uintptr_t base_va, size_t size, uint32_t attr)
 	return xlat_change_mem_attributes_ctx(&xxx_xlat_ctx, base_va, size, attr);
 }
 
+int xlat_va_to_pa(uintptr_t va, unsigned long long *pa)
+{
+	return xlat_va_to_pa_ctx(&xxx_xlat_ctx, va, pa);
+}
+
 #if PLAT_RO_XLAT_TABLES
 /* Change the memory attributes of the descriptors which resolve the address
  * range that belongs to the translation tables themselves, which are by default
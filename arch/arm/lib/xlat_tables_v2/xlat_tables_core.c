@@ -14,10 +14,12 @@
 
 #include <arch_features.h>
 #include <arch_helpers.h>
+#include <cassert.h>
 #include <debug.h>
 #include <utils.h>
 #include <lib/xlat_tables/xlat_tables_defs.h>
 #include <lib/xlat_tables/xlat_tables_v2.h>
+#include <mm.h>
 
 #include "xlat_tables_private.h"
 
@@ -34,8 +36,18 @@ static inline __attribute__((unused)) void xlat_clean_dcache_range(uintptr_t add
  * The following functions assume that they will be called using subtables only.
  * The base table can't be unmapped, so it is not needed to do any special
  * handling for it.
+ *
+ * Subtables of EL1&0 contexts come from the page allocator when it is
+ * available, and from the static tables of the context otherwise, e.g. before
+ * it is set up. The page allocator hands out non-secure memory: contexts of
+ * the other regimes, e.g. the EL3 one of the secure firmware, always use their
+ * static tables, which live in their own image. The reference count of a page
+ * allocator table is one, held by the context, plus the number of regions
+ * mapped in it. The static tables keep that number in tables_mapped_regions[].
  */
 
+CASSERT(XLAT_TABLE_SIZE == PAGE_SIZE, assert_xlat_table_size_is_page_size);
+
 /*
  * Returns the index of the array corresponding to the specified translation
  * table.
@@ -56,8 +68,19 @@ static int xlat_table_get_index(const xlat_ctx_t *ctx, const uint64_t *table)
 }
 
 /* Returns a pointer to an empty translation table. */
-static uint64_t *xlat_table_get_empty(const xlat_ctx_t *ctx)
+static uint64_t *xlat_table_get_empty(xlat_ctx_t *ctx)
 {
+	uint64_t *table = NULL;
+
+	/* Zeroed, i.e. all entries are INVALID_DESC */
+	if (ctx->xlat_regime == EL1_EL0_REGIME)
+		table = mm_page_alloc(MM_ZERO);
+
+	if (table != NULL) {
+		ctx->pooled_tables++;
+		return table;
+	}
+
 	for (int i = 0; i < ctx->tables_num; i++)
 		if (ctx->tables_mapped_regions[i] == 0)
 			return ctx->tables[i];
@@ -69,6 +92,11 @@ static uint64_t *xlat_table_get_empty(const xlat_ctx_t *ctx)
 static void xlat_table_inc_regions_count(const xlat_ctx_t *ctx,
 					 const uint64_t *table)
 {
+	if (mm_page_in_pool(table)) {
+		mm_page_get((void *)(uintptr_t)table);
+		return;
+	}
+
 	int idx = xlat_table_get_index(ctx, table);
 
 	ctx->tables_mapped_regions[idx]++;
@@ -78,6 +106,12 @@ static void xlat_table_inc_regions_count(const xlat_ctx_t *ctx,
 static void xlat_table_dec_regions_count(const xlat_ctx_t *ctx,
 					 const uint64_t *table)
 {
+	if (mm_page_in_pool(table)) {
+		/* The reference of the context keeps it allocated */
+		mm_page_put((void *)(uintptr_t)table);
+		return;
+	}
+
 	int idx = xlat_table_get_index(ctx, table);
 
 	ctx->tables_mapped_regions[idx]--;
@@ -86,9 +120,44 @@ static void xlat_table_dec_regions_count(const xlat_ctx_t *ctx,
 /* Returns 0 if the specified table isn't empty, otherwise 1. */
 static bool xlat_table_is_empty(const xlat_ctx_t *ctx, const uint64_t *table)
 {
+	if (mm_page_in_pool(table))
+		return mm_page_count(table) == 1U;
+
 	return ctx->tables_mapped_regions[xlat_table_get_index(ctx, table)] == 0;
 }
 
+/*
+ * Queues an empty table just unlinked from its parent. Walks started before
+ * the TLB invalidation may still read it, so it is only given back to the
+ * page allocator by xlat_tables_reclaim(). The queue is linked through the
+ * first entry of the tables: a table address reads as an invalid descriptor.
+ * Static tables are reused as soon as they are empty, as they always were.
+ */
+static void xlat_table_release(xlat_ctx_t *ctx, uint64_t *table)
+{
+	if (!mm_page_in_pool(table))
+		return;
+
+	table[0] = (uint64_t)(uintptr_t)ctx->reclaim_tables;
+	ctx->reclaim_tables = table;
+}
+
+/*
+ * Gives the tables queued by xlat_table_release() back to the page allocator.
+ * Must be called after the TLB invalidation of the regions they mapped has
+ * completed.
+ */
+static void xlat_tables_reclaim(xlat_ctx_t *ctx)
+{
+	while (ctx->reclaim_tables != NULL) {
+		uint64_t *table = ctx->reclaim_tables;
+
+		ctx->reclaim_tables = (uint64_t *)(uintptr_t)table[0];
+		ctx->pooled_tables--;
+		mm_page_put(table);
+	}
+}
+
 #else /* PLAT_XLAT_TABLES_DYNAMIC */
 
 /* Returns a pointer to the first empty translation table. */
@@ -142,8 +211,12 @@ uint64_t xlat_desc(const xlat_ctx_t *ctx, uint32_t attr,
 	 */
 	if (ctx->xlat_regime == EL1_EL0_REGIME) {
 		if ((attr & MT_USER) != 0U) {
-			/* EL0 mapping requested, so we give User access */
-			desc |= LOWER_ATTRS(AP_ACCESS_UNPRIVILEGED);
+			/*
+			 * EL0 mapping requested, so we give User access. It
+			 * belongs to one address space: make it non-global, so
+			 * that the TLBs tag it with the ASID of that space.
+			 */
+			desc |= LOWER_ATTRS(AP_ACCESS_UNPRIVILEGED | NON_GLOBAL);
 		} else {
 			/* EL1 mapping requested, no User access granted */
 			desc |= LOWER_ATTRS(AP_NO_ACCESS_UNPRIVILEGED);
@@ -307,9 +380,11 @@ static action_t xlat_tables_unmap_region_action(const mmap_region_t *mm,
 		if (level == 3U) {
 			/*
 			 * Last level, only page descriptors allowed,
-			 * erase it.
+			 * erase it. Pages of demand-mapped regions may not
+			 * have been mapped.
 			 */
-			assert(desc_type == PAGE_DESC);
+			assert((desc_type == PAGE_DESC) ||
+			       ((mm->attr & MT_DEMAND) != 0U));
 
 			action = ACTION_WRITE_BLOCK_ENTRY;
 		} else {
@@ -352,7 +427,9 @@ static action_t xlat_tables_unmap_region_action(const mmap_region_t *mm,
 }
 /*
  * Recursive function that writes to the translation tables and unmaps the
- * specified region.
+ * specified region. The TLBs are left alone: the caller invalidates the whole
+ * region at once with xlat_arch_tlbi_va_range(), which also covers the
+ * entries of the subtables removed here.
  */
 static void xlat_tables_unmap_region(xlat_ctx_t *ctx, mmap_region_t *mm,
 				     const uintptr_t table_base_va,
@@ -389,7 +466,6 @@ static void xlat_tables_unmap_region(xlat_ctx_t *ctx, mmap_region_t *mm,
 		if (action == ACTION_WRITE_BLOCK_ENTRY) {
 
 			table_base[table_idx] = INVALID_DESC;
-			xlat_arch_tlbi_va(table_idx_va, ctx->xlat_regime);
 
 		} else if (action == ACTION_RECURSE_INTO_TABLE) {
 
@@ -408,8 +484,7 @@ static void xlat_tables_unmap_region(xlat_ctx_t *ctx, mmap_region_t *mm,
 			 */
 			if (xlat_table_is_empty(ctx, subtable)) {
 				table_base[table_idx] = INVALID_DESC;
-				xlat_arch_tlbi_va(table_idx_va,
-						  ctx->xlat_regime);
+				xlat_table_release(ctx, subtable);
 			}
 
 		} else {
@@ -561,6 +636,42 @@ static action_t xlat_tables_map_region_action(const mmap_region_t *mm,
 	}
 }
 
+#if XLAT_TABLES_CONTIG_HINT
+/*
+ * Returns true if the XLAT_CONT_ENTRIES entries from 'table_idx', the first of
+ * which is about to get a block descriptor of the region, will all get one, so
+ * that they can be written with the Contiguous hint right away. Setting it
+ * later on live entries would need a break-before-make.
+ */
+static bool xlat_tables_run_is_contiguous(const mmap_region_t *mm,
+					  const uint64_t *table_base,
+					  unsigned int table_idx,
+					  unsigned int table_entries,
+					  uintptr_t run_va,
+					  unsigned long long run_pa,
+					  unsigned int level)
+{
+	uintptr_t mm_end_va = mm->base_va + mm->size - 1U;
+
+	if ((level < XLAT_CONT_MIN_LEVEL) ||
+	    ((table_idx + XLAT_CONT_ENTRIES) > table_entries))
+		return false;
+
+	if ((run_va + XLAT_CONT_SIZE(level) - 1U) > mm_end_va)
+		return false;
+
+	if ((run_pa & (XLAT_CONT_SIZE(level) - 1U)) != 0U)
+		return false;
+
+	for (unsigned int i = 0U; i < XLAT_CONT_ENTRIES; i++) {
+		if ((table_base[table_idx + i] & DESC_MASK) != INVALID_DESC)
+			return false;
+	}
+
+	return true;
+}
+#endif /* XLAT_TABLES_CONTIG_HINT */
+
 /*
  * Recursive function that writes to the translation tables and maps the
  * specified region. On success, it returns the VA of the last byte that was
@@ -585,6 +696,9 @@ static uintptr_t xlat_tables_map_region(xlat_ctx_t *ctx, mmap_region_t *mm,
 
 	unsigned int table_idx;
 
+	/* Contiguous hint of the entries of the current run */
+	uint64_t cont_hint = 0ULL;
+
 	table_idx_va = xlat_tables_find_start_va(mm, table_base_va, level);
 	table_idx = xlat_tables_va_to_index(table_base_va, table_idx_va, level);
 
@@ -603,11 +717,27 @@ static uintptr_t xlat_tables_map_region(xlat_ctx_t *ctx, mmap_region_t *mm,
 			(uint32_t)(desc & DESC_MASK), table_idx_pa,
 			table_idx_va, level);
 
-		if (action == ACTION_WRITE_BLOCK_ENTRY) {
+#if XLAT_TABLES_CONTIG_HINT
+		if ((table_idx % XLAT_CONT_ENTRIES) == 0U) {
+			cont_hint = ((action == ACTION_WRITE_BLOCK_ENTRY) &&
+				     xlat_tables_run_is_contiguous(mm,
+					table_base, table_idx, table_entries,
+					table_idx_va, table_idx_pa, level)) ?
+				    UPPER_ATTRS(CONT_HINT) : 0ULL;
+		}
+#endif
+
+		if ((action == ACTION_WRITE_BLOCK_ENTRY) &&
+		    ((mm->attr & MT_DEMAND) != 0U)) {
+
+			/* Its owner maps the page later on */
+			assert(level == XLAT_TABLE_LEVEL_MAX);
+
+		} else if (action == ACTION_WRITE_BLOCK_ENTRY) {
 
 			table_base[table_idx] =
 				xlat_desc(ctx, (uint32_t)mm->attr, table_idx_pa,
-					  level);
+					  level) | cont_hint;
 
 		} else if (action == ACTION_CREATE_NEW_TABLE) {
 			uintptr_t end_va;
@@ -706,6 +836,16 @@ static int mmap_add_region_check(const xlat_ctx_t *ctx, const mmap_region_t *mm)
 	if (end_pa > ctx->pa_max_address)
 		return -ERANGE;
 
+#if PLAT_XLAT_TABLES_DYNAMIC
+	/* Only dynamic regions can be demand-mapped, with page granularity */
+	if (((mm->attr & MT_DEMAND) != 0U) &&
+	    (((mm->attr & MT_DYNAMIC) == 0U) || (granularity != PAGE_SIZE)))
+		return -EINVAL;
+#else
+	if ((mm->attr & MT_DEMAND) != 0U)
+		return -EINVAL;
+#endif
+
 	/* Check that there is space in the ctx->mmap array */
 	if (ctx->mmap[ctx->mmap_num - 1].size != 0U)
 		return -ENOMEM;
@@ -758,8 +898,10 @@ static int mmap_add_region_check(const xlat_ctx_t *ctx, const mmap_region_t *mm)
 			unsigned long long mm_cursor_end_pa =
 				     mm_cursor->base_pa + mm_cursor->size - 1U;
 
+			/* Demand-mapped regions have no PA range of their own */
 			bool separated_pa = (end_pa < mm_cursor->base_pa) ||
-				(base_pa > mm_cursor_end_pa);
+				(base_pa > mm_cursor_end_pa) ||
+				(((mm->attr | mm_cursor->attr) & MT_DEMAND) != 0U);
 			bool separated_va = (end_va < mm_cursor->base_va) ||
 				(base_va > mm_cursor_end_va);
 
@@ -1028,7 +1170,7 @@ int mmap_add_dynamic_region_ctx(xlat_ctx_t *ctx, mmap_region_t *mm)
 					.base_pa = 0U,
 					.base_va = mm->base_va,
 					.size = end_va - mm->base_va,
-					.attr = 0U
+					.attr = mm->attr & MT_DEMAND
 			};
 			xlat_tables_unmap_region(ctx, &unmap_mm, 0U,
 				ctx->base_table, ctx->base_table_entries,
@@ -1037,6 +1179,13 @@ int mmap_add_dynamic_region_ctx(xlat_ctx_t *ctx, mmap_region_t *mm)
 			xlat_clean_dcache_range((uintptr_t)ctx->base_table,
 				ctx->base_table_entries * sizeof(uint64_t));
 #endif
+			/* Up to and including the page of end_va */
+			xlat_arch_tlbi_va_range(unmap_mm.base_va,
+						unmap_mm.size + 1U,
+						ctx->xlat_regime);
+			xlat_arch_tlbi_va_sync();
+			xlat_walk_cache_flush(ctx);
+			xlat_tables_reclaim(ctx);
 			return -ENOMEM;
 		}
 
@@ -1123,7 +1272,13 @@ int mmap_remove_dynamic_region_ctx(xlat_ctx_t *ctx, uintptr_t base_va,
 		xlat_clean_dcache_range((uintptr_t)ctx->base_table,
 			ctx->base_table_entries * sizeof(uint64_t));
 #endif
+		xlat_arch_tlbi_va_range(mm->base_va, mm->size,
+					ctx->xlat_regime);
 		xlat_arch_tlbi_va_sync();
+
+		/* The tables left empty are unreachable now */
+		xlat_walk_cache_flush(ctx);
+		xlat_tables_reclaim(ctx);
 	}
 
 	/* Remove this region by moving the rest down by one place. */
@@ -1177,6 +1332,9 @@ void xlat_setup_dynamic_ctx(xlat_ctx_t *ctx, unsigned long long pa_max,
 	ctx->base_table_entries = GET_NUM_BASE_LEVEL_ENTRIES(va_space_size);
 
 	ctx->tables_mapped_regions = mapped_regions;
+	ctx->pooled_tables = 0;
+	ctx->reclaim_tables = NULL;
+	memset(ctx->walk_cache, 0, sizeof(ctx->walk_cache));
 
 	ctx->max_pa = 0;
 	ctx->max_va = 0;
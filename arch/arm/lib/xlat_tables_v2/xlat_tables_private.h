@@ -36,8 +36,32 @@
 #define MT_STATIC	(U(0) << MT_DYN_SHIFT)
 #define MT_DYNAMIC	(U(1) << MT_DYN_SHIFT)
 
+/* Drops the tables cached for xlat_va_to_pa_ctx(), before tables are reused */
+void xlat_walk_cache_flush(xlat_ctx_t *ctx);
+
 #endif /* PLAT_XLAT_TABLES_DYNAMIC */
 
+/*
+ * Above this number of pages, invalidating the TLBs page by page costs more
+ * than refilling them after invalidating the whole translation regime.
+ */
+#ifndef XLAT_TLBI_FULL_THRESHOLD
+#define XLAT_TLBI_FULL_THRESHOLD	U(512)
+#endif
+
+/*
+ * Give runs of XLAT_CONT_ENTRIES aligned entries mapping contiguous memory with
+ * the same attributes the Contiguous hint, so that each run takes a single TLB
+ * entry: 64KB of pages or 32MB of level 2 blocks.
+ */
+#ifndef XLAT_TABLES_CONTIG_HINT
+#define XLAT_TABLES_CONTIG_HINT		1
+#endif
+
+#define XLAT_CONT_ENTRIES		U(16)
+#define XLAT_CONT_MIN_LEVEL		U(2)
+#define XLAT_CONT_SIZE(level)		(XLAT_CONT_ENTRIES * XLAT_BLOCK_SIZE(level))
+
 extern uint64_t mmu_cfg_params[MMU_CFG_PARAM_MAX];
 
 /* Determine the physical address space encoded in the 'attr' parameter. */
@@ -63,8 +87,18 @@ uint64_t xlat_arch_regime_get_xn_desc(int xlat_regime);
 void xlat_arch_tlbi_va(uintptr_t va, int xlat_regime);
 
 /*
- * This function has to be called at the end of any code that uses the function
- * xlat_arch_tlbi_va().
+ * Invalidate the TLB entries of all the pages overlapping [va, va + size), with
+ * the same scope as xlat_arch_tlbi_va(). Range instructions (FEAT_TLBIRANGE)
+ * are used where present; ranges of more than XLAT_TLBI_FULL_THRESHOLD pages
+ * which cannot be covered that way invalidate the whole translation regime
+ * instead. Only the write barrier before the invalidation is issued:
+ * xlat_arch_tlbi_va_sync() must follow.
+ */
+void xlat_arch_tlbi_va_range(uintptr_t va, size_t size, int xlat_regime);
+
+/*
+ * This function has to be called at the end of any code that uses the
+ * functions xlat_arch_tlbi_va() or xlat_arch_tlbi_va_range().
  */
 void xlat_arch_tlbi_va_sync(void);
 
@@ -102,6 +136,13 @@ unsigned long long xlat_arch_get_max_supported_pa(void);
  */
 bool is_mmu_enabled_ctx(const xlat_ctx_t *ctx);
 
+/*
+ * Translate 'va' with the MMU, if 'ctx' is the context it currently uses.
+ * Returns false if it isn't or if the address isn't mapped.
+ */
+bool xlat_arch_va_to_pa(const xlat_ctx_t *ctx, uintptr_t va,
+			unsigned long long *pa);
+
 /*
  * Returns minimum virtual address space size supported by the architecture
  */
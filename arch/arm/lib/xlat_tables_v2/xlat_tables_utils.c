@@ -14,6 +14,7 @@
 #include <platform_def.h>
 
 #include <arch_helpers.h>
+#include <cassert.h>
 #include <debug.h>
 #include <utils.h>
 #include <lib/xlat_tables/xlat_tables_defs.h>
@@ -114,6 +115,10 @@ static void xlat_desc_print(const xlat_ctx_t *ctx, uint64_t desc)
 	printf(((LOWER_ATTRS(NS) & desc) != 0ULL) ? "-NS" : "-S");
 #endif
 
+	if ((desc & UPPER_ATTRS(CONT_HINT)) != 0ULL) {
+		printf("-CONT");
+	}
+
 #ifdef __aarch64__
 	/* Check Guarded Page bit */
 	if ((desc & GP) != 0ULL) {
@@ -255,6 +260,10 @@ void xlat_tables_print(xlat_ctx_t *ctx)
 	VERBOSE("  Used %d sub-tables out of %d (spare: %d)\n",
 		used_page_tables, ctx->tables_num,
 		ctx->tables_num - used_page_tables);
+#if PLAT_XLAT_TABLES_DYNAMIC
+	VERBOSE("  Sub-tables from the page allocator: %d\n",
+		ctx->pooled_tables);
+#endif
 
 	xlat_tables_print_internal(ctx, 0U, ctx->base_table,
 				   ctx->base_table_entries, ctx->base_level);
@@ -342,6 +351,69 @@ static uint64_t *find_xlat_table_entry(uintptr_t virtual_addr,
 }
 
 
+/*
+ * Returns the entry of the page at 'virtual_addr' in the last level table
+ * mapping it, whether the entry is valid or not, or NULL if the address isn't
+ * mapped through a last level table.
+ */
+static uint64_t *find_xlat_page_entry(const xlat_ctx_t *ctx,
+				      uintptr_t virtual_addr)
+{
+	unsigned long long virt_addr_space_size =
+		(unsigned long long)ctx->va_max_address + 1ULL;
+	uint64_t *table = ctx->base_table;
+
+	for (unsigned int level = GET_XLAT_TABLE_LEVEL_BASE(virt_addr_space_size);
+	     level < XLAT_TABLE_LEVEL_MAX;
+	     ++level) {
+		uint64_t desc = table[XLAT_TABLE_IDX(virtual_addr, level)];
+
+		if ((desc & DESC_MASK) != TABLE_DESC)
+			return NULL;
+
+		table = (uint64_t *)(uintptr_t)(desc & TABLE_ADDR_MASK);
+	}
+
+	return &table[XLAT_TABLE_IDX(virtual_addr, XLAT_TABLE_LEVEL_MAX)];
+}
+
+#if XLAT_TABLES_CONTIG_HINT
+/* Returns true if the page at 'virtual_addr' is part of a contiguous run. */
+static bool xlat_page_is_cont(const xlat_ctx_t *ctx, uintptr_t virtual_addr)
+{
+	const uint64_t *entry = find_xlat_page_entry(ctx, virtual_addr);
+
+	return (entry != NULL) && ((*entry & UPPER_ATTRS(CONT_HINT)) != 0ULL);
+}
+
+/*
+ * Returns true if the XLAT_CONT_ENTRIES invalid descriptors from 'entry', of
+ * the pages from 'virtual_addr', can be made valid as a contiguous run: the
+ * run is aligned, within 'end_va', and maps contiguous memory with the same
+ * attributes.
+ */
+static bool xlat_pages_can_coalesce(const uint64_t *entry,
+				    uintptr_t virtual_addr, uintptr_t end_va)
+{
+	const uintptr_t run_size = XLAT_CONT_SIZE(XLAT_TABLE_LEVEL_MAX);
+	uint64_t pa = entry[0] & TABLE_ADDR_MASK;
+
+	if (((virtual_addr & (run_size - 1U)) != 0U) ||
+	    ((end_va - virtual_addr) < run_size) ||
+	    ((pa & (run_size - 1U)) != 0U))
+		return false;
+
+	for (unsigned int i = 1U; i < XLAT_CONT_ENTRIES; ++i) {
+		if (((entry[i] & ~TABLE_ADDR_MASK) !=
+		     (entry[0] & ~TABLE_ADDR_MASK)) ||
+		    ((entry[i] & TABLE_ADDR_MASK) != (pa + (i * PAGE_SIZE))))
+			return false;
+	}
+
+	return true;
+}
+#endif /* XLAT_TABLES_CONTIG_HINT */
+
 static int xlat_get_mem_attributes_internal(const xlat_ctx_t *ctx,
 		uintptr_t base_va, uint32_t *attributes, uint64_t **table_entry,
 		unsigned long long *addr_pa, unsigned int *table_level)
@@ -443,12 +515,146 @@ int xlat_get_mem_attributes_ctx(const xlat_ctx_t *ctx, uintptr_t base_va,
 				NULL, NULL, NULL);
 }
 
+/*
+ * The walk cache of a context has an entry per XLAT_WALK_CACHE_SHIFT aligned
+ * range of VAs, which all end their walk in the same table. An entry packs the
+ * table and a tag in one word, so that it is read and written without a lock:
+ *   [1:0]   level of the table, 0 if the entry is empty
+ *   [37:2]  address of the table >> XLAT_TABLE_SIZE_SHIFT
+ *   [63:38] VA >> XLAT_WALK_CACHE_SHIFT, without the bits of the index
+ * The base table may not be aligned to XLAT_TABLE_SIZE and is never cached;
+ * walks ending in it are short anyway.
+ */
+#define XLAT_WALK_CACHE_SHIFT	XLAT_ADDR_SHIFT(2U)
+#define XLAT_WALK_LEVEL_MASK	ULL(0x3)
+#define XLAT_WALK_TABLE_SHIFT	U(2)
+#define XLAT_WALK_TABLE_MASK	((ULL(1) << 36) - ULL(1))
+#define XLAT_WALK_TAG_SHIFT	U(38)
+
+CASSERT((XLAT_WALK_CACHE_ENTRIES >= 2U) &&
+	((XLAT_WALK_CACHE_ENTRIES & (XLAT_WALK_CACHE_ENTRIES - 1U)) == 0U),
+	assert_xlat_walk_cache_entries_power_of_two);
+
+static inline uint64_t xlat_walk_cache_tag(uintptr_t va)
+{
+	return ((uint64_t)(va >> XLAT_WALK_CACHE_SHIFT) /
+		XLAT_WALK_CACHE_ENTRIES) << XLAT_WALK_TAG_SHIFT;
+}
+
+/*
+ * Stores in 'pa' the output address of 'va' if 'desc', an entry of a table of
+ * the given level, is a page or block descriptor.
+ */
+static bool xlat_leaf_to_pa(uint64_t desc, unsigned int level, uintptr_t va,
+			    unsigned long long *pa)
+{
+	uint64_t leaf = (level == XLAT_TABLE_LEVEL_MAX) ? PAGE_DESC : BLOCK_DESC;
+	unsigned long long offset = va & XLAT_BLOCK_MASK(level);
+
+	if ((desc & DESC_MASK) != leaf)
+		return false;
+
+	*pa = (desc & TABLE_ADDR_MASK & ~offset) | offset;
+
+	return true;
+}
+
+/*
+ * Walks the tables of 'ctx' down to the page or block descriptor of 'va'.
+ * Returns the table it is in, its level in 'out_level' and the output
+ * address in 'pa', or NULL if 'va' isn't mapped.
+ */
+static const uint64_t *xlat_walk(const xlat_ctx_t *ctx, uintptr_t va,
+				 unsigned int *out_level,
+				 unsigned long long *pa)
+{
+	const uint64_t *table = ctx->base_table;
+	unsigned int entries = ctx->base_table_entries;
+
+	for (unsigned int level = ctx->base_level;
+	     level <= XLAT_TABLE_LEVEL_MAX;
+	     ++level) {
+		uint64_t idx = XLAT_TABLE_IDX(va, level);
+		uint64_t desc;
+
+		if (idx >= entries)
+			return NULL;
+
+		desc = table[idx];
+		if (xlat_leaf_to_pa(desc, level, va, pa)) {
+			*out_level = level;
+			return table;
+		}
+
+		if ((level == XLAT_TABLE_LEVEL_MAX) ||
+		    ((desc & DESC_MASK) != TABLE_DESC))
+			return NULL;
+
+		table = (const uint64_t *)(uintptr_t)(desc & TABLE_ADDR_MASK);
+		entries = XLAT_TABLE_ENTRIES;
+	}
+
+	return NULL;
+}
+
+int xlat_va_to_pa_ctx(const xlat_ctx_t *ctx, uintptr_t va,
+		      unsigned long long *pa)
+{
+	uint64_t tag = xlat_walk_cache_tag(va);
+	const uint64_t *table;
+	unsigned int level;
+	uint64_t *slot;
+	uint64_t cached;
+
+	assert(ctx != NULL);
+	assert(pa != NULL);
+
+	if (!ctx->initialized || (va > ctx->va_max_address))
+		return -EINVAL;
+
+	/* The cache isn't part of what the context describes */
+	slot = (uint64_t *)&ctx->walk_cache[(va >> XLAT_WALK_CACHE_SHIFT) &
+					    (XLAT_WALK_CACHE_ENTRIES - 1U)];
+	cached = __atomic_load_n(slot, __ATOMIC_RELAXED);
+
+	if (((cached >> XLAT_WALK_TAG_SHIFT) << XLAT_WALK_TAG_SHIFT) == tag) {
+		level = (unsigned int)(cached & XLAT_WALK_LEVEL_MASK);
+		table = (const uint64_t *)(uintptr_t)
+			(((cached >> XLAT_WALK_TABLE_SHIFT) &
+			  XLAT_WALK_TABLE_MASK) << XLAT_TABLE_SIZE_SHIFT);
+
+		/* Otherwise the entry was unmapped or replaced since */
+		if ((level != 0U) &&
+		    xlat_leaf_to_pa(table[XLAT_TABLE_IDX(va, level)], level,
+				    va, pa))
+			return 0;
+	}
+
+	/* The MMU walks the context it is using itself, hitting the TLBs */
+	if (xlat_arch_va_to_pa(ctx, va, pa))
+		return 0;
+
+	table = xlat_walk(ctx, va, &level, pa);
+	if (table == NULL)
+		return -EINVAL;
+
+	if (table != ctx->base_table) {
+		assert(((uintptr_t)table >> XLAT_TABLE_SIZE_SHIFT) <=
+		       XLAT_WALK_TABLE_MASK);
+		__atomic_store_n(slot, tag |
+				 (((uint64_t)(uintptr_t)table >>
+				   XLAT_TABLE_SIZE_SHIFT) <<
+				  XLAT_WALK_TABLE_SHIFT) | level,
+				 __ATOMIC_RELAXED);
+	}
+
+	return 0;
+}
+
 
 int xlat_change_mem_attributes_ctx(const xlat_ctx_t *ctx, uintptr_t base_va,
 				   size_t size, uint32_t attr)
 {
-	/* Note: This implementation isn't optimized. */
-
 	assert(ctx != NULL);
 	assert(ctx->initialized);
 
@@ -537,7 +743,32 @@ int xlat_change_mem_attributes_ctx(const xlat_ctx_t *ctx, uintptr_t base_va,
 	/* Restore original value. */
 	base_va = base_va_original;
 
-	for (unsigned int i = 0U; i < pages_count; ++i) {
+	uintptr_t end_va = base_va_original + size;
+
+#if XLAT_TABLES_CONTIG_HINT
+	/*
+	 * A contiguous run only partly covered by the region is split: all of
+	 * it goes through break-before-make, and its pages outside of the
+	 * region keep their attributes but lose the hint.
+	 */
+	if (xlat_page_is_cont(ctx, base_va))
+		base_va &= ~(XLAT_CONT_SIZE(XLAT_TABLE_LEVEL_MAX) - 1U);
+	if (xlat_page_is_cont(ctx, end_va - PAGE_SIZE))
+		end_va = (end_va + XLAT_CONT_SIZE(XLAT_TABLE_LEVEL_MAX) - 1U) &
+			 ~(XLAT_CONT_SIZE(XLAT_TABLE_LEVEL_MAX) - 1U);
+#endif
+
+	uintptr_t start_va = base_va;
+
+	/*
+	 * Break-before-make over the whole region at once: every descriptor
+	 * is replaced with an invalid one, the TLBs are invalidated with as
+	 * few operations as the range allows and a single synchronisation, and
+	 * only then are the new descriptors made valid. The invalid descriptor
+	 * written is the new one with its type cleared, so that the last step
+	 * does not need to rebuild it.
+	 */
+	for (; base_va < end_va; base_va += PAGE_SIZE) {
 
 		uint32_t old_attr = 0U, new_attr;
 		uint64_t *entry = NULL;
@@ -547,6 +778,16 @@ int xlat_change_mem_attributes_ctx(const xlat_ctx_t *ctx, uintptr_t base_va,
 		(void) xlat_get_mem_attributes_internal(ctx, base_va, &old_attr,
 					    &entry, &addr_pa, &level);
 
+		if ((base_va < base_va_original) ||
+		    (base_va >= (base_va_original + size))) {
+			/* Rest of a split contiguous run */
+			*entry &= ~(UPPER_ATTRS(CONT_HINT) | DESC_MASK);
+#if !HW_ASSISTED_COHERENCY
+			dccvac((uintptr_t)entry);
+#endif
+			continue;
+		}
+
 		/*
 		 * From attr, only MT_RO/MT_RW, MT_EXECUTE/MT_EXECUTE_NEVER and
 		 * MT_USER/MT_PRIVILEGED are taken into account. Any other
@@ -562,31 +803,256 @@ int xlat_change_mem_attributes_ctx(const xlat_ctx_t *ctx, uintptr_t base_va,
 		 */
 		new_attr |= attr & (MT_RW | MT_EXECUTE_NEVER | MT_USER);
 
+		*entry = xlat_desc(ctx, new_attr, addr_pa, level) & ~DESC_MASK;
+#if !HW_ASSISTED_COHERENCY
+		dccvac((uintptr_t)entry);
+#endif
+	}
+
+	/* Invalidate any cached copy of these mappings in the TLBs. */
+	xlat_arch_tlbi_va_range(start_va, end_va - start_va, ctx->xlat_regime);
+
+	/* Ensure completion of the invalidation. */
+	xlat_arch_tlbi_va_sync();
+
+	/*
+	 * Write the new descriptors, with the Contiguous hint on the runs
+	 * which now qualify for it.
+	 */
+	uint64_t *entry = NULL;
+
+	for (base_va = start_va; base_va < end_va; ) {
+		unsigned int count = 1U;
+		uint64_t cont_hint = 0ULL;
+
+		/* Pages of the same last level table have consecutive entries */
+		if ((entry == NULL) ||
+		    (XLAT_TABLE_IDX(base_va, XLAT_TABLE_LEVEL_MAX) == 0U))
+			entry = find_xlat_page_entry(ctx, base_va);
+
+		assert(entry != NULL);
+
+#if XLAT_TABLES_CONTIG_HINT
+		if (xlat_pages_can_coalesce(entry, base_va, end_va)) {
+			count = XLAT_CONT_ENTRIES;
+			cont_hint = UPPER_ATTRS(CONT_HINT);
+		}
+#endif
+
+		for (unsigned int i = 0U; i < count; ++i) {
+			entry[i] |= PAGE_DESC | cont_hint;
+#if !HW_ASSISTED_COHERENCY
+			dccvac((uintptr_t)&entry[i]);
+#endif
+		}
+
+		entry += count;
+		base_va += count * PAGE_SIZE;
+	}
+
+	/* Ensure that the last descriptor writen is seen by the system. */
+	dsbish();
+
+	return 0;
+}
+
+#if PLAT_XLAT_TABLES_DYNAMIC
+
+void xlat_walk_cache_flush(xlat_ctx_t *ctx)
+{
+	for (unsigned int i = 0U; i < XLAT_WALK_CACHE_ENTRIES; i++)
+		__atomic_store_n(&ctx->walk_cache[i], 0ULL, __ATOMIC_RELAXED);
+}
+
+/*
+ * Returns true if [base_va, base_va + size) is inside a single MT_DEMAND
+ * region. Pages of any other region are managed with the region as a whole.
+ */
+static bool xlat_in_demand_region(const xlat_ctx_t *ctx, uintptr_t base_va,
+				  size_t size)
+{
+	const mmap_region_t *mm = ctx->mmap;
+	const mmap_region_t *mm_end = ctx->mmap + ctx->mmap_num;
+	uintptr_t end_va = base_va + size - 1U;
+
+	for (; (mm < mm_end) && (mm->size != 0U); ++mm) {
+		if ((base_va >= mm->base_va) &&
+		    (end_va <= (mm->base_va + mm->size - 1U)))
+			return (mm->attr & MT_DEMAND) != 0U;
+	}
+
+	return false;
+}
+
+int xlat_map_page_ctx(const xlat_ctx_t *ctx, uintptr_t va,
+		      unsigned long long pa, uint32_t attr)
+{
+	uint64_t *entry;
+
+	assert(ctx != NULL);
+	assert(ctx->initialized);
+	assert(IS_PAGE_ALIGNED(va) && IS_PAGE_ALIGNED(pa));
+
+	if (!xlat_in_demand_region(ctx, va, PAGE_SIZE))
+		return -EINVAL;
+
+	entry = find_xlat_page_entry(ctx, va);
+	if (entry == NULL)
+		return -EINVAL;
+
+	if ((*entry & DESC_MASK) == PAGE_DESC) {
+		/* Break-before-make, the old page may be cached in the TLBs */
+		*entry = INVALID_DESC;
+#if !HW_ASSISTED_COHERENCY
+		dccvac((uintptr_t)entry);
+#endif
+		xlat_arch_tlbi_va(va, ctx->xlat_regime);
+		xlat_arch_tlbi_va_sync();
+	}
+
+	*entry = xlat_desc(ctx, attr, pa, XLAT_TABLE_LEVEL_MAX);
+#if !HW_ASSISTED_COHERENCY
+	dccvac((uintptr_t)entry);
+#endif
+	/* An invalid entry isn't cached, no invalidation is needed */
+	dsbishst();
+
+	return 0;
+}
+
+int xlat_unmap_page_ctx(const xlat_ctx_t *ctx, uintptr_t va)
+{
+	uint64_t *entry;
+
+	assert(ctx != NULL);
+	assert(ctx->initialized);
+
+	if (!xlat_in_demand_region(ctx, va, PAGE_SIZE))
+		return -EINVAL;
+
+	entry = find_xlat_page_entry(ctx, va);
+	if (entry == NULL)
+		return -EINVAL;
+
+	if ((*entry & DESC_MASK) != PAGE_DESC)
+		return 0;
+
+	*entry = INVALID_DESC;
+#if !HW_ASSISTED_COHERENCY
+	dccvac((uintptr_t)entry);
+#endif
+	xlat_arch_tlbi_va(va, ctx->xlat_regime);
+	xlat_arch_tlbi_va_sync();
+
+	return 0;
+}
+
+int xlat_wrprotect_pages_ctx(const xlat_ctx_t *ctx, uintptr_t base_va,
+			     size_t size)
+{
+	uintptr_t end_va = base_va + size;
+	uint64_t *entry = NULL;
+	bool changed = false;
+
+	assert(ctx != NULL);
+	assert(ctx->initialized);
+	assert(IS_PAGE_ALIGNED(base_va) && IS_PAGE_ALIGNED(size));
+
+	if (!xlat_in_demand_region(ctx, base_va, size))
+		return -EINVAL;
+
+	for (uintptr_t va = base_va; va < end_va; va += PAGE_SIZE, ++entry) {
+		/* Pages of the same last level table have consecutive entries */
+		if ((entry == NULL) ||
+		    (XLAT_TABLE_IDX(va, XLAT_TABLE_LEVEL_MAX) == 0U)) {
+			entry = find_xlat_page_entry(ctx, va);
+			if (entry == NULL)
+				return -EINVAL;
+		}
+
+		if (((*entry & DESC_MASK) != PAGE_DESC) ||
+		    ((*entry & LOWER_ATTRS(AP_RO)) != 0ULL))
+			continue;
+
 		/*
-		 * The break-before-make sequence requires writing an invalid
-		 * descriptor and making sure that the system sees the change
-		 * before writing the new descriptor.
+		 * Only the permission changes, which needs no break-before-make.
 		 */
-		*entry = INVALID_DESC;
+		*entry |= LOWER_ATTRS(AP_RO);
 #if !HW_ASSISTED_COHERENCY
 		dccvac((uintptr_t)entry);
 #endif
-		/* Invalidate any cached copy of this mapping in the TLBs. */
-		xlat_arch_tlbi_va(base_va, ctx->xlat_regime);
+		changed = true;
+	}
 
-		/* Ensure completion of the invalidation. */
+	if (changed) {
+		xlat_arch_tlbi_va_range(base_va, size, ctx->xlat_regime);
 		xlat_arch_tlbi_va_sync();
+	}
+
+	return 0;
+}
+
+int xlat_unmap_pages_ctx(const xlat_ctx_t *ctx, uintptr_t base_va,
+			size_t size)
+{
+	uintptr_t end_va = base_va + size;
+	uint64_t *entry = NULL;
+	bool changed = false;
 
-		/* Write new descriptor */
-		*entry = xlat_desc(ctx, new_attr, addr_pa, level);
+	assert(ctx != NULL);
+	assert(ctx->initialized);
+	assert(IS_PAGE_ALIGNED(base_va) && IS_PAGE_ALIGNED(size));
+
+	if (!xlat_in_demand_region(ctx, base_va, size))
+		return -EINVAL;
+
+	for (uintptr_t va = base_va; va < end_va; va += PAGE_SIZE, ++entry) {
+		/* Pages of the same last level table have consecutive entries */
+		if ((entry == NULL) ||
+		    (XLAT_TABLE_IDX(va, XLAT_TABLE_LEVEL_MAX) == 0U)) {
+			entry = find_xlat_page_entry(ctx, va);
+			if (entry == NULL)
+				return -EINVAL;
+		}
+
+		if ((*entry & DESC_MASK) != PAGE_DESC)
+			continue;
+
+		*entry = INVALID_DESC;
 #if !HW_ASSISTED_COHERENCY
 		dccvac((uintptr_t)entry);
 #endif
-		base_va += PAGE_SIZE;
+		changed = true;
 	}
 
-	/* Ensure that the last descriptor writen is seen by the system. */
-	dsbish();
+	if (changed) {
+		xlat_arch_tlbi_va_range(base_va, size, ctx->xlat_regime);
+		xlat_arch_tlbi_va_sync();
+	}
 
 	return 0;
 }
+
+int xlat_page_lookup_ctx(const xlat_ctx_t *ctx, uintptr_t va,
+			 unsigned long long *pa, bool *writable)
+{
+	const uint64_t *entry;
+
+	assert(ctx != NULL);
+	assert(pa != NULL);
+
+	entry = find_xlat_page_entry(ctx, va);
+	if (entry == NULL)
+		return -EINVAL;
+
+	if ((*entry & DESC_MASK) != PAGE_DESC)
+		return -ENOENT;
+
+	*pa = *entry & TABLE_ADDR_MASK;
+	if (writable != NULL)
+		*writable = (*entry & LOWER_ATTRS(AP_RO)) == 0ULL;
+
+	return 0;
+}
+
+#endif /* PLAT_XLAT_TABLES_DYNAMIC */
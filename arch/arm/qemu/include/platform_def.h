@@ -123,10 +123,34 @@
 #define NS_IMAGE_OFFSET			(NS_DRAM0_BASE + 0x20000000)
 #define NS_IMAGE_MAX_SIZE		(NS_DRAM0_SIZE - 0x20000000)
 
+/*
+ * Non-secure DRAM given to the page allocator, between the DT and the image.
+ * The kernel maps it as a static region of its own.
+ */
+#define PLAT_MM_POOL_BASE		(NS_DRAM0_BASE + 0x10000000)
+#define PLAT_MM_POOL_SIZE		0x10000000
+
+/*
+ * Non-secure DRAM given to larged for large pages, the last 1GB of it with
+ * -m 3G, less with a smaller RAM as the DT gives it. It must stay out of the
+ * static regions, larged maps it itself.
+ */
+#define PLAT_LARGED_POOL_BASE		(NS_DRAM0_BASE + 0x80000000)
+#define PLAT_LARGED_POOL_SIZE		0x40000000
+
 #define PLAT_PHY_ADDR_SPACE_SIZE	(1ULL << 32)
 #define PLAT_VIRT_ADDR_SPACE_SIZE	(1ULL << 32)
-#define MAX_MMAP_REGIONS		11
-#define MAX_XLAT_TABLES			6
+#define MAX_MMAP_REGIONS		16
+#if defined(LARGED_TLB_BENCH) && LARGED_TLB_BENCH
+/*
+ * larged_tlb_bench() remaps its buffer with 4KB pages: a level 3 table per 2MB
+ * and a level 2 table, on top of the static ones as EL3 has no others.
+ */
+#define LARGED_BENCH_SIZE		0x1000000
+#define MAX_XLAT_TABLES			(8 + (LARGED_BENCH_SIZE >> 21) + 1)
+#else
+#define MAX_XLAT_TABLES			8
+#endif
 #define MAX_IO_DEVICES			4
 #define MAX_IO_HANDLES			4
 
@@ -146,6 +170,14 @@
 
 #define PLAT_QEMU_CONSOLE_BAUDRATE	115200
 
+/* UART0 is SPI 1 on the virt machine. */
+#define QEMU_IRQ_UART0			33
+
+/* Drive the boot UART from its interrupt instead of polling. */
+#ifndef QEMU_CONSOLE_PL011_IRQ
+#define QEMU_CONSOLE_PL011_IRQ		0
+#endif
+
 #define QEMU_FLASH0_BASE		0x00000000
 #define QEMU_FLASH0_SIZE		0x04000000
 #define QEMU_FLASH1_BASE		0x04000000
@@ -166,6 +198,8 @@
 #define GICD_BASE			0x8000000
 #define GICC_BASE			0x8010000
 #define GICR_BASE			0x80A0000
+/* Only present with -machine virt,its=on */
+#define GITS_BASE			0x8080000
 
 
 #define QEMU_IRQ_SEC_SGI_0		8
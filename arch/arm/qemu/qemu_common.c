@@ -10,6 +10,8 @@
 #include <arch_helpers.h>
 #include <common.h>
 #include <lib/xlat_tables/xlat_tables_v2.h>
+#include <libfdt.h>
+#include <platform.h>
 
 
 #include "qemu_private.h"
@@ -40,6 +42,17 @@
 #define MAP_NS_DRAM0	MAP_REGION_FLAT(NS_DRAM0_BASE, NS_DRAM0_SIZE,	\
 					MT_MEMORY | MT_RW | MT_NS)
 
+/* Pages of the kernel's page allocator, see mm_init() */
+#define MAP_MM_POOL	MAP_REGION_FLAT(PLAT_MM_POOL_BASE, PLAT_MM_POOL_SIZE, \
+					MT_MEMORY | MT_RW | MT_NS |	\
+					MT_EXECUTE_NEVER)
+
+/* The DT QEMU places at the start of the RAM, see plat_get_ns_dram_end() */
+#define MAP_DT		MAP_REGION_FLAT(PLAT_QEMU_DT_BASE,		\
+					PLAT_QEMU_DT_MAX_SIZE,		\
+					MT_MEMORY | MT_RO | MT_NS |	\
+					MT_EXECUTE_NEVER)
+
 #define MAP_FLASH0	MAP_REGION_FLAT(QEMU_FLASH0_BASE, QEMU_FLASH0_SIZE, \
 					MT_MEMORY | MT_RO | MT_SECURE)
 
@@ -63,6 +76,8 @@ static const mmap_region_t plat_qemu_mmap[] = {
 #ifdef MAP_DEVICE2
 	MAP_DEVICE2,
 #endif
+	MAP_MM_POOL,
+	MAP_DT,
 	{0}
 };
 #endif
@@ -167,3 +182,39 @@ int plat_get_mbedtls_heap(void **heap_addr, size_t *heap_size)
 	return get_mbedtls_heap_helper(heap_addr, heap_size);
 }
 #endif
+
+/*******************************************************************************
+ * End of the RAM starting at NS_DRAM0_BASE, as the /memory node of the DT
+ * describes it: its size depends on the -m option of QEMU. Returns
+ * NS_DRAM0_BASE if the DT can't be read.
+ ******************************************************************************/
+uint64_t plat_get_ns_dram_end(void)
+{
+	const void *fdt = (const void *)PLAT_QEMU_DT_BASE;
+	const fdt32_t *reg;
+	uint64_t base = 0U, size = 0U;
+	int node, ac, sc, len;
+
+	if (fdt_check_header(fdt) != 0)
+		return NS_DRAM0_BASE;
+
+	node = fdt_path_offset(fdt, "/memory");
+	ac = fdt_address_cells(fdt, 0);
+	sc = fdt_size_cells(fdt, 0);
+	if ((node < 0) || (ac < 1) || (ac > 2) || (sc < 1) || (sc > 2))
+		return NS_DRAM0_BASE;
+
+	reg = fdt_getprop(fdt, node, "reg", &len);
+	if ((reg == NULL) || (len < (int)((ac + sc) * sizeof(*reg))))
+		return NS_DRAM0_BASE;
+
+	for (int i = 0; i < ac; i++)
+		base = (base << 32) | fdt32_to_cpu(reg[i]);
+	for (int i = 0; i < sc; i++)
+		size = (size << 32) | fdt32_to_cpu(reg[ac + i]);
+
+	if (base != NS_DRAM0_BASE)
+		return NS_DRAM0_BASE;
+
+	return base + size;
+}
@@ -4,11 +4,47 @@
  * SPDX-License-Identifier: BSD-3-Clause
  */
 
+#include <assert.h>
+
 #include <platform_def.h>
 
 #include <drivers/console/console.h>
 #include <drivers/pl011/pl011.h>
+#include <irq.h>
+
+#include "qemu_private.h"
+
+#if QEMU_CONSOLE_PL011_IRQ
+static console_pl011_irq_t console;
+
+void qemu_console_init(void)
+{
+	(void)console_pl011_irq_register(PLAT_QEMU_BOOT_UART_BASE,
+				   PLAT_QEMU_BOOT_UART_CLK_IN_HZ,
+				   PLAT_QEMU_CONSOLE_BAUDRATE, &console);
 
+	console_set_scope(&console.console, CONSOLE_FLAG_BOOT |
+			  CONSOLE_FLAG_RUNTIME);
+}
+
+static irq_return_t qemu_console_irq_handler(unsigned int intid, void *data)
+{
+	console_pl011_irq_handler(&console);
+
+	return IRQ_HANDLED;
+}
+
+/* Route QEMU_IRQ_UART0 to the console, once the interrupt controller is up */
+void qemu_console_irq_init(void)
+{
+	int rc;
+
+	rc = irq_request(QEMU_IRQ_UART0, IRQ_FLOW_LEVEL,
+			 qemu_console_irq_handler, NULL, "uart0");
+	assert(rc == 0);
+	(void)rc;
+}
+#else
 static console_t console;
 
 void qemu_console_init(void)
@@ -21,3 +57,8 @@ void qemu_console_init(void)
 			  CONSOLE_FLAG_RUNTIME);
 }
 
+void qemu_console_irq_init(void)
+{
+}
+#endif /* QEMU_CONSOLE_PL011_IRQ */
+
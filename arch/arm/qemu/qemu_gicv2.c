@@ -6,18 +6,31 @@
 
 #include <drivers/gic/gicv2.h>
 #include <drivers/gic/gic_common.h>
+#include <hrtimer.h>
 #include <platform_def.h>
+#include <smp.h>
+#include <vdso.h>
+#ifdef __aarch64__
+#include <fpu.h>
+#endif
+
+#include "qemu_private.h"
 
 static const interrupt_prop_t qemu_interrupt_props[] = {
 	PLATFORM_G1S_PROPS(GICV2_INTR_GROUP0),
 	PLATFORM_G0_PROPS(GICV2_INTR_GROUP0)
 };
 
+/* GICD_ITARGETSR value of each CPU, needed to raise SGIs */
+static unsigned int qemu_target_masks[PLATFORM_CORE_COUNT];
+
 static const struct gicv2_driver_data plat_gicv2_driver_data = {
 	.gicd_base = GICD_BASE,
 	.gicc_base = GICC_BASE,
 	.interrupt_props = qemu_interrupt_props,
 	.interrupt_props_num = ARRAY_SIZE(qemu_interrupt_props),
+	.target_masks = qemu_target_masks,
+	.target_masks_num = ARRAY_SIZE(qemu_target_masks),
 };
 
 void plat_qemu_gic_init(void)
@@ -26,16 +39,27 @@ void plat_qemu_gic_init(void)
 	gicv2_driver_init(&plat_gicv2_driver_data);
 	gicv2_distif_init();
 	gicv2_pcpu_distif_init();
+	gicv2_set_pe_target_mask(plat_my_core_pos());
 	gicv2_cpuif_enable();
+	gicv2_irq_chip_init();
+	qemu_console_irq_init();
+	smp_cpu_init();
 }
 
 void qemu_pwr_gic_on_finish(void)
 {
 	/* TODO: This setup is needed only after a cold boot */
 	gicv2_pcpu_distif_init();
+	gicv2_set_pe_target_mask(plat_my_core_pos());
 
 	/* Enable the gic cpu interface */
 	gicv2_cpuif_enable();
+	smp_cpu_init();
+	hrtimer_cpu_setup();
+	vdso_cpu_setup();
+#if defined(__aarch64__) && CTX_INCLUDE_FPREGS
+	fpu_cpu_setup();
+#endif
 }
 
 void qemu_pwr_gic_off(void)
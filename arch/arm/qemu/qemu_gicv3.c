@@ -5,9 +5,18 @@
  */
 
 #include <drivers/gic/gicv3.h>
+#include <drivers/gic/gicv3_its.h>
 #include <drivers/gic/gic_common.h>
+#include <hrtimer.h>
 #include <platform_def.h>
+#include <smp.h>
+#include <vdso.h>
+#include <vgic.h>
+#ifdef __aarch64__
+#include <fpu.h>
+#endif
 
+#include "qemu_private.h"
 
 static const interrupt_prop_t qemu_interrupt_props[] = {
 	PLATFORM_G1S_PROPS(INTR_GROUP1S),
@@ -37,12 +46,34 @@ void plat_qemu_gic_init(void)
 	gicv3_distif_init();
 	gicv3_rdistif_init(plat_my_core_pos());
 	gicv3_cpuif_enable(plat_my_core_pos());
+	gicv3_irq_chip_init();
+	qemu_console_irq_init();
+	smp_cpu_init();
+#if VGIC_SUPPORT
+	(void)vgic_cpu_init();
+#endif
+#if GICV3_ITS_SUPPORT
+	(void)gicv3_its_init(GITS_BASE);
+	gicv3_its_cpu_init(plat_my_core_pos());
+#endif
 }
 
 void qemu_pwr_gic_on_finish(void)
 {
 	gicv3_rdistif_init(plat_my_core_pos());
 	gicv3_cpuif_enable(plat_my_core_pos());
+#if GICV3_ITS_SUPPORT
+	gicv3_its_cpu_init(plat_my_core_pos());
+#endif
+	smp_cpu_init();
+	hrtimer_cpu_setup();
+	vdso_cpu_setup();
+#if defined(__aarch64__) && CTX_INCLUDE_FPREGS
+	fpu_cpu_setup();
+#endif
+#if VGIC_SUPPORT
+	(void)vgic_cpu_init();
+#endif
 }
 
 void qemu_pwr_gic_off(void)
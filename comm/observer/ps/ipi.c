@@ -0,0 +1,115 @@
+/*
+ * Copyright (c) 2013-2022, Arm Limited and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+
+#include <platform_def.h>
+
+#include <ipi.h>
+#include <irq.h>
+#include <linux/bitmap.h>
+#include <platform.h>
+#include <smp.h>
+
+typedef struct ipi_cpu {
+	/* IPI types sent to this CPU and not handled yet */
+	unsigned long pending;
+	ipi_stats_t stats;
+} __aligned(CACHE_WRITEBACK_GRANULE) ipi_cpu_t;
+
+static ipi_cpu_t ipi_cpus[PLATFORM_CORE_COUNT];
+
+/* Returns true if the SGI has to be raised on 'cpu' */
+static inline bool ipi_mark(unsigned int cpu, ipi_type_t type)
+{
+	return __atomic_fetch_or(&ipi_cpus[cpu].pending, 1UL << type,
+				 __ATOMIC_SEQ_CST) == 0UL;
+}
+
+/*******************************************************************************
+ * Send IPI 'type' to every CPU set in 'cpus'. CPUs which already have an IPI
+ * pending are not interrupted again, the others all get their SGI from the
+ * same irq_send_sgi() call.
+ ******************************************************************************/
+void ipi_send_many(const unsigned long *cpus, ipi_type_t type)
+{
+	DECLARE_BITMAP(kick, PLATFORM_CORE_COUNT);
+	ipi_stats_t *st = &ipi_cpus[plat_my_core_pos()].stats;
+	unsigned int cpu;
+
+	assert(type < IPI_NR);
+
+	bitmap_zero(kick, PLATFORM_CORE_COUNT);
+
+	for_each_set_bit(cpu, cpus, PLATFORM_CORE_COUNT) {
+		st->nr_sent++;
+		if (ipi_mark(cpu, type)) {
+			__set_bit(cpu, kick);
+			st->nr_sgis++;
+		}
+	}
+
+	if (!bitmap_empty(kick, PLATFORM_CORE_COUNT))
+		irq_send_sgi(IPI_SGI, kick);
+}
+
+void ipi_send(unsigned int cpu, ipi_type_t type)
+{
+	DECLARE_BITMAP(cpus, PLATFORM_CORE_COUNT);
+
+	assert(cpu < PLATFORM_CORE_COUNT);
+
+	bitmap_zero(cpus, PLATFORM_CORE_COUNT);
+	__set_bit(cpu, cpus);
+
+	ipi_send_many(cpus, type);
+}
+
+/*******************************************************************************
+ * The pending word is emptied before anything runs: a type sent while its
+ * handler runs raises a new SGI rather than being lost.
+ ******************************************************************************/
+static irq_return_t ipi_handler(unsigned int intid, void *data)
+{
+	ipi_cpu_t *ic = &ipi_cpus[plat_my_core_pos()];
+	unsigned long pending;
+
+	/*
+	 * An SGI may find the work it was sent for already done, e.g. the
+	 * calls run by smp_call_queue() while waiting. That is no stray
+	 * interrupt, whose IRQ_NONE would eventually get the SGI masked.
+	 */
+	pending = __atomic_exchange_n(&ic->pending, 0UL, __ATOMIC_SEQ_CST);
+	if (pending == 0UL)
+		return IRQ_HANDLED;
+
+	ic->stats.nr_received++;
+
+	if ((pending & (1UL << IPI_CALL_FUNC)) != 0UL)
+		smp_call_function_interrupt();
+
+	/* IPI_WAKEUP: taking the interrupt was all it takes */
+
+	return IRQ_HANDLED;
+}
+
+void ipi_get_stats(unsigned int cpu, ipi_stats_t *stats)
+{
+	assert(cpu < PLATFORM_CORE_COUNT);
+
+	*stats = ipi_cpus[cpu].stats;
+}
+
+/* Called by every CPU once its interrupt controller interface is up */
+void ipi_cpu_init(void)
+{
+	int rc;
+
+	rc = irq_request(IPI_SGI, IRQ_FLOW_PERCPU, ipi_handler, NULL, "ipi");
+	assert(rc == 0);
+	(void)rc;
+}
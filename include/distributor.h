@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2013-2022, Arm Limited and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef DISTRIBUTOR_H
+#define DISTRIBUTOR_H
+
+#include <utils.h>
+
+/*******************************************************************************
+ * SPI affinity balancing.
+ *
+ * Every period the balancer compares the interrupts each online CPU took
+ * since the previous one, using the per-CPU counters of the interrupt layer.
+ * While the busiest and the idlest CPUs differ by more than a threshold it
+ * moves the hottest SPI of the busiest CPU that narrows the gap to the idlest
+ * one. Pinned SPIs are never moved.
+ ******************************************************************************/
+
+/* Balancing period, in nanoseconds */
+#ifndef DISTRIBUTOR_PERIOD_NS
+#define DISTRIBUTOR_PERIOD_NS		ULL(100000000)
+#endif
+
+/* Smallest per-period difference between two CPUs worth a move */
+#ifndef DISTRIBUTOR_MIN_IMBALANCE
+#define DISTRIBUTOR_MIN_IMBALANCE	U(64)
+#endif
+
+/* Most SPIs moved per period */
+#ifndef DISTRIBUTOR_MAX_MOVES
+#define DISTRIBUTOR_MAX_MOVES		U(4)
+#endif
+
+void distributor_setup(void);
+void distributor_balance(void);
+int distributor_pin(unsigned int intid, unsigned int cpu);
+void distributor_unpin(unsigned int intid);
+
+#endif /* DISTRIBUTOR_H */
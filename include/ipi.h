@@ -0,0 +1,49 @@
+/*
+ * Copyright (c) 2013-2022, Arm Limited and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef IPI_H
+#define IPI_H
+
+#include <stdint.h>
+
+#include <utils.h>
+
+/*******************************************************************************
+ * Inter-processor interrupts.
+ *
+ * All IPI types share one SGI. Sending sets the type in a pending word of the
+ * target CPU and only raises the SGI if that word was empty, i.e. if no SGI
+ * is already on its way; the handler then runs every type found pending.
+ * Sending to a set of CPUs raises the SGI on all of those that need it at
+ * once, see irq_send_sgi().
+ ******************************************************************************/
+
+/* SGI carrying the IPIs */
+#ifndef IPI_SGI
+#define IPI_SGI			U(0)
+#endif
+
+typedef enum ipi_type {
+	/* Run the calls queued by smp_call_function_*() */
+	IPI_CALL_FUNC = 0,
+	/* Only leave WFI */
+	IPI_WAKEUP,
+	IPI_NR
+} ipi_type_t;
+
+typedef struct ipi_stats {
+	/* Requests, and SGIs actually raised for them */
+	uint64_t nr_sent;
+	uint64_t nr_sgis;
+	uint64_t nr_received;
+} ipi_stats_t;
+
+void ipi_cpu_init(void);
+void ipi_send(unsigned int cpu, ipi_type_t type);
+void ipi_send_many(const unsigned long *cpus, ipi_type_t type);
+void ipi_get_stats(unsigned int cpu, ipi_stats_t *stats);
+
+#endif /* IPI_H */
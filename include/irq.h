@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2013-2022, Arm Limited and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef IRQ_H
+#define IRQ_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <platform_def.h>
+
+#include <utils.h>
+#include <workqueue.h>
+
+/*******************************************************************************
+ * Interrupt descriptors.
+ *
+ * Every interrupt ID the kernel handles has a descriptor holding its handler
+ * and its flow, i.e. the order in which the handler and the end of interrupt
+ * happen. SGIs and PPIs have one descriptor per CPU, SPIs one shared
+ * descriptor; both live in dense arrays indexed by the interrupt ID. LPIs
+ * are sparse and their descriptors, provided by the caller, are kept in an
+ * xarray.
+ *
+ * The root interrupt controller is described by an irq_chip_t. The entry
+ * path acknowledges, indexes the descriptor and calls its flow handler,
+ * which also signals the end of interrupt; it keeps doing so while
+ * interrupts are pending.
+ *
+ * A threaded interrupt is split in two. The hard half runs in the entry path:
+ * it masks the line, acknowledges it and optionally runs a quick handler.
+ * The thread half runs later on the same CPU from the workqueue, with
+ * interrupts unmasked, and the line is unmasked when it returns. Threaded
+ * lines get a lower priority than the hard ones, and the priority mask is
+ * raised while a thread half runs, so that only hard lines preempt it.
+ ******************************************************************************/
+
+/* Interrupt ID ranges, those of the GIC architecture */
+#define IRQ_NR_SGI		U(16)
+#define IRQ_NR_PERCPU		U(32)
+#define IRQ_NR_DENSE		U(1020)
+#define IRQ_MIN_LPI		U(8192)
+
+/* Build irq_dispatch_bench(), an interrupt latency benchmark for QEMU */
+#ifndef IRQ_DISPATCH_BENCH
+#define IRQ_DISPATCH_BENCH	0
+#endif
+
+/*
+ * Priorities of the lines: hard ones preempt threaded ones. Pseudo-NMIs are
+ * above IRQ_PRIO_HARD and stay deliverable when interrupts are masked with
+ * local_irq_save() (see irqflags.h).
+ */
+#define IRQ_PRIO_NMI		U(0x80)
+#define IRQ_PRIO_HARD		U(0xa0)
+#define IRQ_PRIO_THREADED	U(0xc0)
+
+#if IRQ_DISPATCH_BENCH && !defined(IRQ_BENCH_INTID)
+/* Software generated interrupt used by the benchmark */
+#define IRQ_BENCH_INTID		U(7)
+#endif
+
+typedef enum irq_flow_type {
+	IRQ_FLOW_NONE = 0,
+	/* End of interrupt before the handler, a new edge is not lost */
+	IRQ_FLOW_EDGE,
+	/* End of interrupt after the handler has quiesced the source */
+	IRQ_FLOW_LEVEL,
+	/* SGI or PPI with a handler and data of its own on every CPU */
+	IRQ_FLOW_PERCPU
+} irq_flow_type_t;
+
+typedef enum irq_return {
+	IRQ_NONE = 0,
+	IRQ_HANDLED,
+	/* Handled in the hard half, run the thread half */
+	IRQ_WAKE_THREAD
+} irq_return_t;
+
+typedef irq_return_t (*irq_handler_t)(unsigned int intid, void *data);
+
+struct irq_desc;
+
+typedef void (*irq_flow_handler_t)(struct irq_desc *desc, unsigned int intid);
+
+typedef struct irq_desc {
+	/* Flow, handler and data are what the entry path touches */
+	irq_flow_handler_t flow;
+	irq_handler_t handler;
+	void *data;
+	irq_flow_type_t type;
+	const char *name;
+	/* Consecutive IRQ_NONE returns, the line is masked when it gets high */
+	unsigned int unhandled;
+	/* CPUs running the flow of a shared line, see irq_free() */
+	unsigned int active;
+	/* Threaded interrupts only */
+	irq_handler_t thread_fn;
+	unsigned int intid;
+	work_t work;
+} irq_desc_t;
+
+/* Controller operations, 'cpu' is the linear index of the calling CPU */
+typedef struct irq_chip {
+	const char *name;
+	/* Returns the ID of the highest priority pending interrupt */
+	unsigned int (*ack)(void);
+	void (*eoi)(unsigned int intid);
+	void (*mask)(unsigned int intid, unsigned int cpu);
+	void (*unmask)(unsigned int intid, unsigned int cpu);
+	void (*set_type)(unsigned int intid, unsigned int cpu,
+			 irq_flow_type_t type);
+	void (*set_pending)(unsigned int intid, unsigned int cpu);
+	/* Raise SGI 'intid' on every CPU set in the 'cpus' bitmap */
+	void (*send_sgi)(unsigned int intid, const unsigned long *cpus);
+	/* Route SPI or LPI 'intid' to 'cpu' only */
+	int (*set_affinity)(unsigned int intid, unsigned int cpu);
+	void (*set_priority)(unsigned int intid, unsigned int cpu,
+			     unsigned int priority);
+	/* Set the priority mask of the calling CPU, returns the previous one */
+	unsigned int (*set_pmr)(unsigned int mask);
+	/* Priority of the interrupt being handled, idle priority if none */
+	unsigned int (*get_running_priority)(void);
+} irq_chip_t;
+
+void irq_chip_register(const irq_chip_t *chip);
+
+int irq_request(unsigned int intid, irq_flow_type_t type,
+		irq_handler_t handler, void *data, const char *name);
+int irq_request_threaded(unsigned int intid, irq_flow_type_t type,
+			 irq_handler_t handler, irq_handler_t thread_fn,
+			 void *data, const char *name);
+int irq_request_nmi(unsigned int intid, irq_handler_t handler, void *data,
+		    const char *name);
+int irq_request_lpi(unsigned int intid, irq_desc_t *desc,
+		    irq_handler_t handler, void *data, const char *name);
+void irq_free(unsigned int intid);
+void irq_enable(unsigned int intid);
+void irq_disable(unsigned int intid);
+void irq_send_sgi(unsigned int intid, const unsigned long *cpus);
+int irq_set_affinity(unsigned int intid, unsigned int cpu);
+bool irq_in_nmi(void);
+
+/*
+ * Interrupts taken by 'cpu': of ID 'intid' (SGIs, PPIs and SPIs only) and in
+ * total. Counters are only written by their own CPU and wrap around.
+ */
+uint32_t irq_stat(unsigned int intid, unsigned int cpu);
+uint64_t irq_stat_cpu(unsigned int cpu);
+
+irq_desc_t *irq_to_desc(unsigned int intid);
+void irq_handle_entry(void);
+
+#if IRQ_DISPATCH_BENCH
+void irq_dispatch_bench(unsigned int loops);
+#endif
+
+#endif /* IRQ_H */
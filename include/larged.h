@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2013-2022, Arm Limited and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LARGED_H
+#define LARGED_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <lib/xlat_tables/xlat_tables_v2.h>
+#include <utils.h>
+
+/*******************************************************************************
+ * Large pages.
+ *
+ * Buffers that are streamed through, e.g. ring buffers, DMA pools or file
+ * caches, span far more 4KB pages than the TLBs hold. larged backs them with
+ * 2MB and 1GB pages instead: physically contiguous frames, mapped with level 2
+ * and level 1 block descriptors, so that one TLB entry covers a whole frame.
+ *
+ * The frames come from a pool of their own, split in 2MB frames tracked in a
+ * bitmap. A buffer is a run of them, aligned to 1GB when it is that large so
+ * that its 1GB aligned part is mapped with level 1 blocks. A buffer is mapped
+ * in the kernel's tables at its physical address (VA == PA) when it is
+ * allocated, as a dynamic region of its own, and unmapped when it is freed.
+ * The pool must therefore not be part of any static region.
+ ******************************************************************************/
+
+/* Build larged_tlb_bench(), a TLB miss benchmark for QEMU */
+#ifndef LARGED_TLB_BENCH
+#define LARGED_TLB_BENCH	0
+#endif
+
+/*
+ * Size of the buffer larged_tlb_bench() streams through, a multiple of 2MB.
+ * Mapped with 4KB pages, it takes a level 3 table per 2MB and maybe a level 2
+ * table, which a platform with static tables only must count in
+ * MAX_XLAT_TABLES.
+ */
+#ifndef LARGED_BENCH_SIZE
+#define LARGED_BENCH_SIZE	(U(16) << 20)
+#endif
+
+/* Most 2MB frames a pool can have, 4GB */
+#ifndef LARGED_MAX_FRAMES
+#define LARGED_MAX_FRAMES	U(2048)
+#endif
+
+#define LARGED_2M_SHIFT		U(21)
+#define LARGED_2M_SIZE		(UL(1) << LARGED_2M_SHIFT)
+#define LARGED_1G_SHIFT		U(30)
+#define LARGED_1G_SIZE		(UL(1) << LARGED_1G_SHIFT)
+
+/* Flags of larged_alloc() */
+#define LARGED_ZERO		U(1)
+/* 1GB pages only, the size is rounded up to a multiple of 1GB */
+#define LARGED_1G		U(2)
+/* Mapped non-cacheable, e.g. a DMA pool for a master that doesn't snoop */
+#define LARGED_NC		U(4)
+
+#if PLAT_XLAT_TABLES_DYNAMIC
+void larged_init(uintptr_t base, size_t size);
+void *larged_alloc(size_t size, unsigned int flags);
+void larged_free(void *buf);
+size_t larged_size(const void *buf);
+size_t larged_nr_free_frames(void);
+
+#if LARGED_TLB_BENCH
+void larged_tlb_bench(unsigned int loops);
+#endif
+#endif /* PLAT_XLAT_TABLES_DYNAMIC */
+
+#endif /* LARGED_H */
@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2013-2022, Arm Limited and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef MM_H
+#define MM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include <utils.h>
+
+/*******************************************************************************
+ * Page allocator.
+ *
+ * The kernel hands out the pages of a single pool of memory, mapped flat
+ * (VA == PA) in its own tables. Free pages are kept on a list, so allocating
+ * and freeing are O(1). Every page has a reference count: a page is allocated
+ * with one reference and goes back to the pool when the last one is dropped,
+ * which lets address spaces share pages, e.g. after a fork.
+ *
+ * The descriptors of the pages are taken from the start of the pool.
+ ******************************************************************************/
+
+/* Flags of mm_page_alloc() */
+#define MM_ZERO			U(1)
+
+void mm_init(uintptr_t base, size_t size);
+void *mm_page_alloc(unsigned int flags);
+void mm_page_get(void *page);
+void mm_page_put(void *page);
+unsigned int mm_page_count(const void *page);
+bool mm_page_in_pool(const void *page);
+size_t mm_nr_free_pages(void);
+
+#endif /* MM_H */
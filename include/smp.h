@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2013-2022, Arm Limited and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef SMP_H
+#define SMP_H
+
+#include <stdbool.h>
+
+#include <linux/llist.h>
+
+/*******************************************************************************
+ * Cross-CPU function calls.
+ *
+ * Every CPU has a lock-less queue of calls to run. A caller adds one entry
+ * per target and sends the IPI only to the targets whose queue was empty, so
+ * any number of calls queued before the target gets to run costs it a single
+ * interrupt. CPU sets are bitmaps of PLATFORM_CORE_COUNT linear indices.
+ ******************************************************************************/
+
+typedef void (*smp_call_func_t)(void *info);
+
+typedef struct smp_call {
+	struct llist_node node;
+	smp_call_func_t func;
+	void *info;
+	/* Set while queued or running, the entry cannot be reused until clear */
+	volatile unsigned int locked;
+	bool wait;
+} smp_call_t;
+
+int smp_call_function_single(unsigned int cpu, smp_call_func_t func,
+			     void *info, bool wait);
+void smp_call_function_many(const unsigned long *cpus, smp_call_func_t func,
+			    void *info, bool wait);
+void smp_call_function(smp_call_func_t func, void *info, bool wait);
+void smp_call_function_interrupt(void);
+void smp_cpu_init(void);
+bool smp_cpu_online(unsigned int cpu);
+
+#endif /* SMP_H */
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2013-2022, Arm Limited and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef VGIC_H
+#define VGIC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <linux/bitmap.h>
+#include <spinlock.h>
+#include <utils.h>
+
+/*******************************************************************************
+ * Virtual GICv3 CPU interface for the worlds run at EL1 under an EL2 kernel.
+ *
+ * Each virtual CPU has a vgic_cpu_t. Virtual interrupts are delivered
+ * through the ICH_LR<n>_EL2 list registers of the physical CPU the virtual
+ * CPU is loaded on, so the guest acknowledges and EOIs them without
+ * trapping. Interrupts which find no free list register wait in a pending
+ * set. A list register holding a lower priority interrupt which is only
+ * pending is given to a higher priority one. While interrupts wait, the
+ * underflow maintenance interrupt is enabled: it fires when at most one list
+ * register is still in use, and all free list registers are refilled at
+ * once.
+ ******************************************************************************/
+
+/* Build the virtual GIC, needs an AArch64 kernel running at EL2 and GICv3 */
+#ifndef VGIC_SUPPORT
+#define VGIC_SUPPORT		0
+#endif
+
+/* Virtual interrupt IDs 0 to VGIC_NR_IRQS - 1 can be injected */
+#ifndef VGIC_NR_IRQS
+#define VGIC_NR_IRQS		U(256)
+#endif
+
+/* Build vgic_selftest(), which exercises the list registers on QEMU */
+#ifndef VGIC_SELFTEST
+#define VGIC_SELFTEST		0
+#endif
+
+/* Architectural maximum of list registers */
+#define VGIC_MAX_LRS		U(16)
+
+#if VGIC_SUPPORT
+
+#ifndef __aarch64__
+#error "VGIC_SUPPORT is only supported on AArch64"
+#endif
+
+typedef struct vgic_stats {
+	uint64_t injected;
+	/* Injections which found no list register */
+	uint64_t overflows;
+	/* List registers taken back from a lower priority interrupt */
+	uint64_t evictions;
+	uint64_t maintenance;
+} vgic_stats_t;
+
+typedef struct vgic_cpu {
+	spinlock_t lock;
+	/* Physical CPU it is loaded on, VGIC_NOT_LOADED if none */
+	unsigned int cpu;
+	/* Pending interrupts not held by a list register */
+	DECLARE_BITMAP(pending, VGIC_NR_IRQS);
+	uint8_t priority[VGIC_NR_IRQS];
+	/* Interrupt held by each list register, VGIC_LR_FREE if none */
+	uint16_t lr_intid[VGIC_MAX_LRS];
+	/* Virtual CPU interface state while not loaded */
+	uint64_t lr[VGIC_MAX_LRS];
+	uint64_t ap1r[4];
+	uint64_t vmcr;
+	vgic_stats_t stats;
+} vgic_cpu_t;
+
+#define VGIC_NOT_LOADED		U(0xffffffff)
+#define VGIC_LR_FREE		U(0xffff)
+
+int vgic_cpu_init(void);
+void vgic_vcpu_init(vgic_cpu_t *vcpu);
+void vgic_load(vgic_cpu_t *vcpu);
+void vgic_put(vgic_cpu_t *vcpu);
+int vgic_inject(vgic_cpu_t *vcpu, unsigned int intid, unsigned int priority);
+unsigned int vgic_nr_lrs(void);
+
+#if VGIC_SELFTEST
+int vgic_selftest(void);
+#endif
+
+#endif /* VGIC_SUPPORT */
+
+#endif /* VGIC_H */
@@ -0,0 +1,125 @@
+/*
+ * Copyright (c) 2013-2022, Arm Limited and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef VM_H
+#define VM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <lib/xlat_tables/xlat_tables_v2.h>
+#include <linux/rbtree.h>
+#include <spinlock.h>
+
+/*******************************************************************************
+ * Address spaces.
+ *
+ * An address space is a translation context of the EL1&0 regime, entered by
+ * writing its base table to TTBR0_EL1. Kernel mappings are global, user ones
+ * (MT_USER) are not and the TLBs tag them with the ASID of their space, so
+ * switching spaces needs no TLB invalidation.
+ *
+ * ASIDs are given out when a space is switched to. When they run out, a new
+ * generation starts: the spaces running on a CPU keep their ASID, all others
+ * get a new one the next time they are switched to, and each CPU invalidates
+ * its TLBs once before running with an ASID of the new generation.
+ ******************************************************************************/
+
+/*******************************************************************************
+ * Virtual memory areas.
+ *
+ * The user memory of an address space is a set of areas. Each one is a
+ * MT_DEMAND region of the space's translation context: its tables exist from
+ * the start, but a page is only mapped when it is first touched, by
+ * vm_fault():
+ * - A read fault maps the shared zero page read-only, and does the same for
+ *   the unmapped pages around it, up to VM_FAULT_AROUND_PAGES, so that a
+ *   sequential reader takes one fault per window instead of one per page.
+ * - A write fault maps a new zero-filled page.
+ * - A write fault on a read-only page of a writable area, i.e. the zero page
+ *   or a page shared by vm_space_fork(), maps a copy of it. The last space
+ *   holding a shared page gets write access to it without a copy.
+ *
+ * The areas of a space are kept in an rbtree sorted by address. Each area
+ * also records the free gap below it, and each node the largest gap of its
+ * subtree, so that vm_map() finds the lowest free range in O(log n).
+ ******************************************************************************/
+
+/* Build vm_switch_bench(), a context switch benchmark for QEMU */
+#ifndef VM_SWITCH_BENCH
+#define VM_SWITCH_BENCH		0
+#endif
+
+/*
+ * Range vm_map() places areas in when no address is given. The spaces share
+ * TTBR0_EL1 with the kernel's flat mappings, so it must not overlap any of
+ * them. The default is the hole of the QEMU virt memory map between the
+ * secure memory and the NS DRAM. Its last page holds the vDSO clock page, see
+ * VDSO_USER_VA, and is never given to an area.
+ */
+#ifndef VM_MMAP_BASE
+#define VM_MMAP_BASE		ULL(0x10000000)
+#endif
+#ifndef VM_MMAP_END
+#define VM_MMAP_END		ULL(0x40000000)
+#endif
+
+/* Window of the zero page mappings a read fault makes, a power of two */
+#ifndef VM_FAULT_AROUND_PAGES
+#define VM_FAULT_AROUND_PAGES	U(16)
+#endif
+
+/* Attributes of an area the caller chooses, the others are implied */
+#define VM_AREA_ATTR_MASK	(MT_RW | MT_EXECUTE_NEVER)
+
+/* Access that caused a fault */
+#define VM_FAULT_WRITE		U(1)
+#define VM_FAULT_EXEC		U(2)
+
+typedef struct vm_area {
+	struct rb_node node;
+	/* [start, end) */
+	uintptr_t start;
+	uintptr_t end;
+	/* Attributes its pages are mapped with when writable */
+	uint32_t attr;
+	/* Free space between the previous area, or VM_MMAP_BASE, and this one */
+	uintptr_t gap;
+	/* Largest gap of the subtree */
+	uintptr_t subtree_gap;
+	/* Next unused area, only while not in a tree */
+	struct vm_area *next;
+} vm_area_t;
+
+typedef struct vm_space {
+	const uint64_t *base_table;
+	/* ASID in the low bits, generation it belongs to above them */
+	uint64_t asid;
+	xlat_ctx_t *ctx;
+	struct rb_root areas;
+	/* Serialises changes to the areas and their pages */
+	spinlock_t lock;
+} vm_space_t;
+
+void vm_asid_init(void);
+int vm_space_init(vm_space_t *vm, xlat_ctx_t *ctx);
+void vm_switch(vm_space_t *vm);
+unsigned int vm_space_asid(const vm_space_t *vm);
+vm_space_t *vm_current(void);
+
+#if PLAT_XLAT_TABLES_DYNAMIC
+int vm_map(vm_space_t *vm, uintptr_t *addr, size_t size, uint32_t attr);
+int vm_unmap(vm_space_t *vm, uintptr_t addr, size_t size);
+int vm_space_fork(vm_space_t *child, vm_space_t *parent);
+void vm_space_destroy(vm_space_t *vm);
+int vm_fault(vm_space_t *vm, uintptr_t addr, unsigned int flags);
+#endif
+
+#if VM_SWITCH_BENCH
+void vm_switch_bench(unsigned int loops);
+#endif
+
+#endif /* VM_H */
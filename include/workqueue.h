@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2013-2022, Arm Limited and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef WORKQUEUE_H
+#define WORKQUEUE_H
+
+#include <stdbool.h>
+
+#include <linux/llist.h>
+
+/*******************************************************************************
+ * Per-CPU deferred work.
+ *
+ * Work queued from any context, interrupts included, runs later on the same
+ * CPU in thread context: with interrupts unmasked, from the idle loop. There
+ * is one lock-less list per priority; everything of a higher priority runs
+ * before the next item of a lower one.
+ ******************************************************************************/
+
+typedef enum wq_prio {
+	/* Interrupt handler threads */
+	WQ_HIGHPRI = 0,
+	WQ_NORMAL,
+	WQ_NR
+} wq_prio_t;
+
+struct work;
+
+typedef void (*work_fn_t)(struct work *work);
+
+typedef struct work {
+	struct llist_node node;
+	work_fn_t func;
+	/* Queued and not started yet */
+	unsigned int pending;
+} work_t;
+
+void work_init(work_t *work, work_fn_t func);
+bool queue_work(work_t *work, wq_prio_t prio);
+bool workqueue_pending(void);
+void workqueue_run(void);
+
+/* True if 'work' is queued and has not started yet */
+static inline bool work_pending(const work_t *work)
+{
+	return __atomic_load_n(&work->pending, __ATOMIC_ACQUIRE) != 0U;
+}
+
+#endif /* WORKQUEUE_H */
@@ -1 +1,224 @@
-// 为每一个PROCESS分配工作量
\ No newline at end of file
+/*
+ * Copyright (c) 2013-2022, Arm Limited and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+// 为每一个PROCESS分配工作量
+
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <platform_def.h>
+
+#include <debug.h>
+#include <distributor.h>
+#include <hrtimer.h>
+#include <irq.h>
+#include <irqflags.h>
+#include <linux/bitmap.h>
+#include <smp.h>
+#include <spinlock.h>
+
+#define DIST_NR_SPI		(IRQ_NR_DENSE - IRQ_NR_PERCPU)
+/* Not routed by us yet: the CPU it fires on is learnt from the counters */
+#define DIST_CPU_UNKNOWN	UINT16_MAX
+
+static struct {
+	hrtimer_t timer;
+	/* Counter values at the previous period */
+	uint64_t prev_total[PLATFORM_CORE_COUNT];
+	uint32_t prev[PLATFORM_CORE_COUNT][DIST_NR_SPI];
+	/* Interrupts of each SPI over the last period, all CPUs together */
+	uint32_t load[DIST_NR_SPI];
+	uint16_t route[DIST_NR_SPI];
+	DECLARE_BITMAP(pinned, DIST_NR_SPI);
+} dist;
+
+/* Serialises the balancer against pinning */
+static spinlock_t dist_lock;
+
+static inline bool dist_is_spi(unsigned int intid)
+{
+	return (intid >= IRQ_NR_PERCPU) && (intid < IRQ_NR_DENSE);
+}
+
+/*******************************************************************************
+ * Fold the counters of the last period into the per-CPU and per-SPI loads.
+ ******************************************************************************/
+static void dist_sample(uint64_t *cpu_load)
+{
+	unsigned int cpu, i;
+
+	for (cpu = 0U; cpu < PLATFORM_CORE_COUNT; cpu++) {
+		uint64_t total = irq_stat_cpu(cpu);
+
+		cpu_load[cpu] = total - dist.prev_total[cpu];
+		dist.prev_total[cpu] = total;
+	}
+
+	for (i = 0U; i < DIST_NR_SPI; i++) {
+		const irq_desc_t *desc = irq_to_desc(IRQ_NR_PERCPU + i);
+		uint32_t sum = 0U, hottest = 0U;
+		unsigned int where = dist.route[i];
+
+		for (cpu = 0U; cpu < PLATFORM_CORE_COUNT; cpu++) {
+			uint32_t count = irq_stat(IRQ_NR_PERCPU + i, cpu);
+			uint32_t delta = count - dist.prev[cpu][i];
+
+			dist.prev[cpu][i] = count;
+			sum += delta;
+			if (delta > hottest) {
+				hottest = delta;
+				if (dist.route[i] == DIST_CPU_UNKNOWN)
+					where = cpu;
+			}
+		}
+
+		/* Free lines are left where they are */
+		dist.load[i] = (desc->handler != NULL) ? sum : 0U;
+		if (sum != 0U)
+			dist.route[i] = (uint16_t)where;
+	}
+}
+
+/* Hottest movable SPI on 'cpu' carrying less than 'limit' interrupts */
+static int dist_pick(unsigned int cpu, uint64_t limit)
+{
+	uint32_t best = 0U;
+	int pick = -1;
+
+	for (unsigned int i = 0U; i < DIST_NR_SPI; i++) {
+		if ((dist.route[i] != cpu) || (dist.load[i] <= best) ||
+		    (dist.load[i] >= limit) || test_bit(i, dist.pinned))
+			continue;
+
+		best = dist.load[i];
+		pick = (int)i;
+	}
+
+	return pick;
+}
+
+/*******************************************************************************
+ * One balancing pass. Moving an SPI carrying less than the gap between the
+ * busiest and the idlest CPU always lowers the busiest load, so the passes
+ * converge instead of bouncing lines around.
+ ******************************************************************************/
+void distributor_balance(void)
+{
+	uint64_t cpu_load[PLATFORM_CORE_COUNT];
+	unsigned int moves, cpu, busiest, idlest;
+	u_register_t flags;
+	int i;
+
+	/* Also taken from the timer interrupt, which must not find it held */
+	flags = local_irq_save();
+	spin_lock(&dist_lock);
+
+	dist_sample(cpu_load);
+
+	for (moves = 0U; moves < DISTRIBUTOR_MAX_MOVES; moves++) {
+		busiest = PLATFORM_CORE_COUNT;
+		idlest = PLATFORM_CORE_COUNT;
+
+		for (cpu = 0U; cpu < PLATFORM_CORE_COUNT; cpu++) {
+			if (!smp_cpu_online(cpu))
+				continue;
+			if ((busiest == PLATFORM_CORE_COUNT) ||
+			    (cpu_load[cpu] > cpu_load[busiest]))
+				busiest = cpu;
+			if ((idlest == PLATFORM_CORE_COUNT) ||
+			    (cpu_load[cpu] < cpu_load[idlest]))
+				idlest = cpu;
+		}
+
+		if ((busiest == idlest) ||
+		    ((cpu_load[busiest] - cpu_load[idlest]) <
+		     DISTRIBUTOR_MIN_IMBALANCE))
+			break;
+
+		i = dist_pick(busiest, cpu_load[busiest] - cpu_load[idlest]);
+		if (i < 0)
+			break;
+
+		if (irq_set_affinity(IRQ_NR_PERCPU + (unsigned int)i,
+				     idlest) != 0) {
+			/* The controller cannot move it, stop trying */
+			__set_bit((unsigned int)i, dist.pinned);
+			continue;
+		}
+
+		VERBOSE("distributor: irq %u (%u/period) cpu %u -> %u\n",
+			IRQ_NR_PERCPU + (unsigned int)i, dist.load[i], busiest,
+			idlest);
+
+		dist.route[i] = (uint16_t)idlest;
+		cpu_load[busiest] -= dist.load[i];
+		cpu_load[idlest] += dist.load[i];
+	}
+
+	spin_unlock(&dist_lock);
+	local_irq_restore(flags);
+}
+
+/*******************************************************************************
+ * Route SPI 'intid' to 'cpu' for good, e.g. for a latency-critical line.
+ ******************************************************************************/
+int distributor_pin(unsigned int intid, unsigned int cpu)
+{
+	u_register_t flags;
+	int rc;
+
+	if (!dist_is_spi(intid) || (cpu >= PLATFORM_CORE_COUNT))
+		return -EINVAL;
+
+	flags = local_irq_save();
+	spin_lock(&dist_lock);
+	rc = irq_set_affinity(intid, cpu);
+	if (rc == 0) {
+		__set_bit(intid - IRQ_NR_PERCPU, dist.pinned);
+		dist.route[intid - IRQ_NR_PERCPU] = (uint16_t)cpu;
+	}
+	spin_unlock(&dist_lock);
+	local_irq_restore(flags);
+
+	return rc;
+}
+
+void distributor_unpin(unsigned int intid)
+{
+	u_register_t flags;
+
+	if (!dist_is_spi(intid))
+		return;
+
+	flags = local_irq_save();
+	spin_lock(&dist_lock);
+	__clear_bit(intid - IRQ_NR_PERCPU, dist.pinned);
+	spin_unlock(&dist_lock);
+	local_irq_restore(flags);
+}
+
+static hrtimer_restart_t distributor_timer(hrtimer_t *timer)
+{
+	distributor_balance();
+
+	(void)hrtimer_forward(timer, hrtimer_now(), DISTRIBUTOR_PERIOD_NS);
+	return HRTIMER_RESTART;
+}
+
+/*******************************************************************************
+ * Start balancing from the calling CPU. The hrtimer queue of the CPU must be
+ * set up.
+ ******************************************************************************/
+void distributor_setup(void)
+{
+	for (unsigned int i = 0U; i < DIST_NR_SPI; i++)
+		dist.route[i] = DIST_CPU_UNKNOWN;
+
+	hrtimer_init(&dist.timer, distributor_timer);
+	hrtimer_start_rel(&dist.timer, DISTRIBUTOR_PERIOD_NS);
+}
@@ -1 +1,540 @@
-// function
\ No newline at end of file
+/*
+ * Copyright (c) 2013-2022, Arm Limited and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <stddef.h>
+
+#include <platform_def.h>
+
+#include <arch_helpers.h>
+#include <debug.h>
+#include <hrtimer.h>
+#include <irq.h>
+#include <linux/xarray.h>
+#include <platform.h>
+#include <spinlock.h>
+#include <workqueue.h>
+
+/* A line returning IRQ_NONE this many times in a row is masked */
+#define IRQ_UNHANDLED_MAX	U(100)
+
+typedef struct irq_percpu_descs {
+	irq_desc_t desc[IRQ_NR_PERCPU];
+} __aligned(CACHE_WRITEBACK_GRANULE) irq_percpu_descs_t;
+
+/*
+ * Counters of one CPU. 32-bit so that other CPUs read them with single
+ * loads; users look at differences, which survive the wrap.
+ */
+typedef struct irq_cpu_stats {
+	uint64_t total;
+	uint32_t count[IRQ_NR_DENSE];
+} __aligned(CACHE_WRITEBACK_GRANULE) irq_cpu_stats_t;
+
+/* SGIs and PPIs of every CPU */
+static irq_percpu_descs_t percpu_descs[PLATFORM_CORE_COUNT];
+/* SPIs */
+static irq_desc_t spi_descs[IRQ_NR_DENSE - IRQ_NR_PERCPU];
+/* LPIs, sparse */
+static DEFINE_XARRAY(lpi_descs);
+
+static irq_cpu_stats_t irq_stats[PLATFORM_CORE_COUNT];
+
+static const irq_chip_t *irq_chip;
+/* Serialises descriptor updates, never taken on the entry path */
+static spinlock_t irq_lock;
+
+static void irq_flow_bad(irq_desc_t *desc, unsigned int intid);
+
+static inline irq_desc_t *__irq_to_desc(unsigned int intid, unsigned int cpu)
+{
+	if (intid < IRQ_NR_PERCPU)
+		return &percpu_descs[cpu].desc[intid];
+
+	if (intid < IRQ_NR_DENSE)
+		return &spi_descs[intid - IRQ_NR_PERCPU];
+
+	if (intid >= IRQ_MIN_LPI)
+		return xa_load(&lpi_descs, intid);
+
+	return NULL;
+}
+
+irq_desc_t *irq_to_desc(unsigned int intid)
+{
+	return __irq_to_desc(intid, plat_my_core_pos());
+}
+
+static void irq_desc_reset(irq_desc_t *desc)
+{
+	desc->flow = irq_flow_bad;
+	desc->handler = NULL;
+	desc->data = NULL;
+	desc->type = IRQ_FLOW_NONE;
+	desc->name = NULL;
+	desc->unhandled = 0U;
+	/* A queued thread half finds no thread_fn and returns */
+	desc->thread_fn = NULL;
+}
+
+/*******************************************************************************
+ * Book-keeping after the handler ran. A line that keeps firing without
+ * anybody claiming it would otherwise lock the CPU up.
+ ******************************************************************************/
+static inline void irq_note(irq_desc_t *desc, unsigned int intid,
+			    irq_return_t ret)
+{
+	if (ret == IRQ_HANDLED) {
+		if (desc->unhandled != 0U)
+			desc->unhandled = 0U;
+		return;
+	}
+
+	if (++desc->unhandled == IRQ_UNHANDLED_MAX) {
+		ERROR("irq: %u (%s) not handled, disabling it\n", intid,
+		      (desc->name != NULL) ? desc->name : "?");
+		irq_chip->mask(intid, plat_my_core_pos());
+	}
+}
+
+static void irq_flow_edge(irq_desc_t *desc, unsigned int intid)
+{
+	irq_chip->eoi(intid);
+	irq_note(desc, intid, desc->handler(intid, desc->data));
+}
+
+/* Also used for per-CPU interrupts, whose descriptor is the CPU's own one */
+static void irq_flow_level(irq_desc_t *desc, unsigned int intid)
+{
+	irq_return_t ret = desc->handler(intid, desc->data);
+
+	irq_chip->eoi(intid);
+	irq_note(desc, intid, ret);
+}
+
+static void irq_flow_bad(irq_desc_t *desc, unsigned int intid)
+{
+	ERROR("irq: spurious interrupt %u, disabling it\n", intid);
+	irq_chip->mask(intid, plat_my_core_pos());
+	irq_chip->eoi(intid);
+}
+
+/*******************************************************************************
+ * Hard half of a threaded interrupt. The line stays masked until its thread
+ * half has run, so that a level interrupt does not fire again meanwhile.
+ ******************************************************************************/
+static void irq_flow_threaded(irq_desc_t *desc, unsigned int intid)
+{
+	irq_return_t ret = IRQ_WAKE_THREAD;
+
+	irq_chip->mask(intid, plat_my_core_pos());
+	if (desc->handler != NULL)
+		ret = desc->handler(intid, desc->data);
+	irq_chip->eoi(intid);
+
+	if (ret == IRQ_WAKE_THREAD) {
+		(void)queue_work(&desc->work, WQ_HIGHPRI);
+		return;
+	}
+
+	irq_note(desc, intid, ret);
+	if (desc->unhandled < IRQ_UNHANDLED_MAX)
+		irq_chip->unmask(intid, plat_my_core_pos());
+}
+
+/*******************************************************************************
+ * Thread half, run from the workqueue of the CPU which took the interrupt.
+ * Only hard lines may preempt it.
+ ******************************************************************************/
+static void irq_thread_work(work_t *work)
+{
+	irq_desc_t *desc = container_of(work, irq_desc_t, work);
+	irq_handler_t thread_fn = desc->thread_fn;
+	unsigned int intid = desc->intid;
+	unsigned int pmr = 0U;
+	irq_return_t ret;
+
+	/* Freed since the hard half ran */
+	if (thread_fn == NULL)
+		return;
+
+	if (irq_chip->set_pmr != NULL)
+		pmr = irq_chip->set_pmr(IRQ_PRIO_THREADED);
+
+	ret = thread_fn(intid, desc->data);
+
+	if (irq_chip->set_pmr != NULL)
+		(void)irq_chip->set_pmr(pmr);
+
+	irq_note(desc, intid, ret);
+	if ((desc->thread_fn != NULL) &&
+	    (desc->unhandled < IRQ_UNHANDLED_MAX))
+		irq_chip->unmask(intid, plat_my_core_pos());
+}
+
+static const irq_flow_handler_t irq_flows[] = {
+	[IRQ_FLOW_NONE] = irq_flow_bad,
+	[IRQ_FLOW_EDGE] = irq_flow_edge,
+	[IRQ_FLOW_LEVEL] = irq_flow_level,
+	[IRQ_FLOW_PERCPU] = irq_flow_level,
+};
+
+/*******************************************************************************
+ * Interrupt entry. Everything pending is handled before returning, so that a
+ * burst costs a single exception entry and exit.
+ ******************************************************************************/
+void irq_handle_entry(void)
+{
+	const irq_chip_t *chip = irq_chip;
+	unsigned int cpu = plat_my_core_pos();
+	irq_cpu_stats_t *stats = &irq_stats[cpu];
+	irq_flow_handler_t flow;
+	unsigned int intid;
+	irq_desc_t *desc;
+
+	for (;;) {
+		intid = chip->ack();
+		/* Spurious or special interrupt ID: nothing (left) to do */
+		if ((intid >= IRQ_NR_DENSE) && (intid < IRQ_MIN_LPI))
+			break;
+
+		/* Only this CPU writes its counters, no atomics needed */
+		stats->total++;
+		if (intid < IRQ_NR_DENSE)
+			stats->count[intid]++;
+
+		desc = __irq_to_desc(intid, cpu);
+		if (desc == NULL) {
+			/* An LPI nobody registered */
+			irq_flow_bad(NULL, intid);
+			continue;
+		}
+
+		/* Only this CPU frees its SGIs and PPIs, between interrupts */
+		if (intid < IRQ_NR_PERCPU) {
+			desc->flow(desc, intid);
+			continue;
+		}
+
+		/* The flow is read after irq_free() can see it counted */
+		(void)__atomic_fetch_add(&desc->active, 1U, __ATOMIC_SEQ_CST);
+		flow = __atomic_load_n(&desc->flow, __ATOMIC_SEQ_CST);
+		flow(desc, intid);
+		(void)__atomic_fetch_sub(&desc->active, 1U, __ATOMIC_RELEASE);
+	}
+}
+
+/*******************************************************************************
+ * Set up the descriptors and make 'chip' the interrupt controller of the
+ * kernel. Called once, before any interrupt is requested.
+ ******************************************************************************/
+void irq_chip_register(const irq_chip_t *chip)
+{
+	assert((chip != NULL) && (chip->ack != NULL) && (chip->eoi != NULL) &&
+	       (chip->mask != NULL) && (chip->unmask != NULL));
+	assert(irq_chip == NULL);
+
+	for (unsigned int cpu = 0U; cpu < PLATFORM_CORE_COUNT; cpu++) {
+		for (unsigned int i = 0U; i < IRQ_NR_PERCPU; i++)
+			irq_desc_reset(&percpu_descs[cpu].desc[i]);
+	}
+
+	for (unsigned int i = 0U; i < ARRAY_SIZE(spi_descs); i++)
+		irq_desc_reset(&spi_descs[i]);
+
+	irq_chip = chip;
+
+	INFO("irq: %s interrupt controller\n", chip->name);
+}
+
+static int irq_desc_install(irq_desc_t *desc, unsigned int intid,
+			    unsigned int cpu, irq_flow_type_t type,
+			    unsigned int priority, irq_handler_t handler,
+			    irq_handler_t thread_fn, void *data,
+			    const char *name)
+{
+	spin_lock(&irq_lock);
+	/*
+	 * The thread half of a freed handler may still be queued, its node
+	 * linked in the workqueue: it must run before the work is set up
+	 * again.
+	 */
+	if ((desc->handler != NULL) || (desc->thread_fn != NULL) ||
+	    ((thread_fn != NULL) && work_pending(&desc->work))) {
+		spin_unlock(&irq_lock);
+		return -EBUSY;
+	}
+
+	desc->handler = handler;
+	desc->data = data;
+	desc->type = type;
+	desc->name = name;
+	desc->unhandled = 0U;
+	desc->thread_fn = thread_fn;
+	desc->intid = intid;
+	if (thread_fn != NULL) {
+		work_init(&desc->work, irq_thread_work);
+		desc->flow = irq_flow_threaded;
+	} else {
+		desc->flow = irq_flows[type];
+	}
+	spin_unlock(&irq_lock);
+
+	if (irq_chip->set_type != NULL)
+		irq_chip->set_type(intid, cpu, type);
+
+	if (irq_chip->set_priority != NULL)
+		irq_chip->set_priority(intid, cpu, priority);
+
+	/* The descriptor is complete before the line can fire. */
+	irq_chip->unmask(intid, cpu);
+
+	return 0;
+}
+
+/*******************************************************************************
+ * Install 'handler' for an SGI, PPI or SPI and enable it. SGIs and PPIs must
+ * use IRQ_FLOW_PERCPU and are requested on the calling CPU only; SPIs must
+ * use the edge or level flow.
+ ******************************************************************************/
+int irq_request(unsigned int intid, irq_flow_type_t type,
+		irq_handler_t handler, void *data, const char *name)
+{
+	if (handler == NULL)
+		return -EINVAL;
+
+	return irq_request_threaded(intid, type, handler, NULL, data, name);
+}
+
+/*******************************************************************************
+ * Same as irq_request() with a thread half 'thread_fn'. The hard half
+ * 'handler' may be NULL, in which case the thread half runs on every
+ * interrupt; otherwise it runs when 'handler' returns IRQ_WAKE_THREAD. A
+ * request without a thread half gets a hard line. Returns -EBUSY while the
+ * thread half of a handler freed on the line is still queued.
+ ******************************************************************************/
+int irq_request_threaded(unsigned int intid, irq_flow_type_t type,
+			 irq_handler_t handler, irq_handler_t thread_fn,
+			 void *data, const char *name)
+{
+	unsigned int cpu = plat_my_core_pos();
+
+	assert(irq_chip != NULL);
+
+	if (((handler == NULL) && (thread_fn == NULL)) ||
+	    (type == IRQ_FLOW_NONE) || (intid >= IRQ_NR_DENSE))
+		return -EINVAL;
+
+	if ((type == IRQ_FLOW_PERCPU) != (intid < IRQ_NR_PERCPU))
+		return -EINVAL;
+
+	return irq_desc_install(__irq_to_desc(intid, cpu), intid, cpu, type,
+				(thread_fn != NULL) ? IRQ_PRIO_THREADED :
+				IRQ_PRIO_HARD, handler, thread_fn, data, name);
+}
+
+/*******************************************************************************
+ * Install 'handler' for an SGI or PPI of the calling CPU at IRQ_PRIO_NMI, e.g.
+ * the PMU overflow or a watchdog timer. With IRQ_PSEUDO_NMI it is taken even
+ * where the kernel masks interrupts with local_irq_save(), so the handler
+ * must not take locks nor call into code that does; it can only rely on
+ * per-CPU state and lock-less structures.
+ ******************************************************************************/
+int irq_request_nmi(unsigned int intid, irq_handler_t handler, void *data,
+		    const char *name)
+{
+	unsigned int cpu = plat_my_core_pos();
+
+	assert(irq_chip != NULL);
+
+	if ((handler == NULL) || (intid >= IRQ_NR_PERCPU))
+		return -EINVAL;
+
+	return irq_desc_install(__irq_to_desc(intid, cpu), intid, cpu,
+				IRQ_FLOW_PERCPU, IRQ_PRIO_NMI, handler, NULL,
+				data, name);
+}
+
+/*******************************************************************************
+ * Same as irq_request() for an LPI, which is always edge triggered. The
+ * caller provides the descriptor, which must stay valid until irq_free().
+ ******************************************************************************/
+int irq_request_lpi(unsigned int intid, irq_desc_t *desc,
+		    irq_handler_t handler, void *data, const char *name)
+{
+	int rc;
+
+	assert(irq_chip != NULL);
+
+	if ((intid < IRQ_MIN_LPI) || (desc == NULL) || (handler == NULL))
+		return -EINVAL;
+
+	irq_desc_reset(desc);
+	desc->active = 0U;
+
+	/* The entry path never sees another descriptor replaced, even briefly */
+	rc = xa_insert(&lpi_descs, intid, desc, GFP_KERNEL);
+	if (rc != 0)
+		return rc;
+
+	return irq_desc_install(desc, intid, plat_my_core_pos(),
+				IRQ_FLOW_EDGE, IRQ_PRIO_HARD, handler, NULL,
+				data, name);
+}
+
+/*******************************************************************************
+ * Disable an interrupt and remove its handler. For SGIs and PPIs this only
+ * affects the calling CPU. For SPIs and LPIs it waits for the handler to
+ * return on the other CPUs, so it must not be called from the handler itself.
+ ******************************************************************************/
+void irq_free(unsigned int intid)
+{
+	unsigned int cpu = plat_my_core_pos();
+	irq_desc_t *desc = __irq_to_desc(intid, cpu);
+
+	if (desc == NULL)
+		return;
+
+	irq_chip->mask(intid, cpu);
+
+	if (intid >= IRQ_NR_PERCPU) {
+		/*
+		 * An interrupt taken before the mask may still be entering its
+		 * flow. Those starting from now find one that doesn't use the
+		 * handler, the others are waited for before it goes.
+		 */
+		__atomic_store_n(&desc->flow, irq_flow_bad, __ATOMIC_SEQ_CST);
+		while (__atomic_load_n(&desc->active, __ATOMIC_SEQ_CST) != 0U)
+			;
+	}
+
+	spin_lock(&irq_lock);
+	irq_desc_reset(desc);
+	spin_unlock(&irq_lock);
+
+	if (intid >= IRQ_MIN_LPI)
+		(void)xa_erase(&lpi_descs, intid);
+}
+
+void irq_enable(unsigned int intid)
+{
+	irq_chip->unmask(intid, plat_my_core_pos());
+}
+
+void irq_disable(unsigned int intid)
+{
+	irq_chip->mask(intid, plat_my_core_pos());
+}
+
+/*******************************************************************************
+ * Raise an SGI on a set of CPUs, 'cpus' being a bitmap of PLATFORM_CORE_COUNT
+ * linear indices. The controller reaches as many of them as it can with each
+ * register write.
+ ******************************************************************************/
+void irq_send_sgi(unsigned int intid, const unsigned long *cpus)
+{
+	assert((irq_chip != NULL) && (irq_chip->send_sgi != NULL));
+	assert(intid < IRQ_NR_SGI);
+
+	irq_chip->send_sgi(intid, cpus);
+}
+
+/*******************************************************************************
+ * Route an SPI or LPI to 'cpu'. Interrupts already pending may still be taken
+ * on the previous CPU.
+ ******************************************************************************/
+int irq_set_affinity(unsigned int intid, unsigned int cpu)
+{
+	assert(irq_chip != NULL);
+
+	if ((cpu >= PLATFORM_CORE_COUNT) || (intid < IRQ_NR_PERCPU) ||
+	    ((intid >= IRQ_NR_DENSE) && (intid < IRQ_MIN_LPI)))
+		return -EINVAL;
+
+	if (irq_chip->set_affinity == NULL)
+		return -EINVAL;
+
+	return irq_chip->set_affinity(intid, cpu);
+}
+
+/*******************************************************************************
+ * Whether the calling CPU is handling a pseudo-NMI.
+ ******************************************************************************/
+bool irq_in_nmi(void)
+{
+	if ((irq_chip == NULL) || (irq_chip->get_running_priority == NULL))
+		return false;
+
+	return irq_chip->get_running_priority() <= IRQ_PRIO_NMI;
+}
+
+uint32_t irq_stat(unsigned int intid, unsigned int cpu)
+{
+	assert((intid < IRQ_NR_DENSE) && (cpu < PLATFORM_CORE_COUNT));
+
+	return *(volatile uint32_t *)&irq_stats[cpu].count[intid];
+}
+
+uint64_t irq_stat_cpu(unsigned int cpu)
+{
+	assert(cpu < PLATFORM_CORE_COUNT);
+
+	return *(volatile uint64_t *)&irq_stats[cpu].total;
+}
+
+#if IRQ_DISPATCH_BENCH
+/*******************************************************************************
+ * Dispatch latency benchmark, meant to be run on QEMU: the time from making
+ * an SGI pending on the calling CPU to its handler running, which covers the
+ * exception entry, the acknowledge and the descriptor dispatch.
+ ******************************************************************************/
+static volatile uint64_t irq_bench_hit;
+
+static irq_return_t irq_bench_fn(unsigned int intid, void *data)
+{
+	irq_bench_hit = hrtimer_now();
+	return IRQ_HANDLED;
+}
+
+void irq_dispatch_bench(unsigned int loops)
+{
+	unsigned int cpu = plat_my_core_pos();
+	uint64_t start, lat, min = UINT64_MAX, max = 0U, sum = 0U;
+	u_register_t flags;
+	int rc;
+
+	assert((loops != 0U) && (irq_chip->set_pending != NULL));
+
+	rc = irq_request(IRQ_BENCH_INTID, IRQ_FLOW_PERCPU, irq_bench_fn, NULL,
+			 "irq-bench");
+	assert(rc == 0);
+	(void)rc;
+
+	flags = read_daif();
+	for (unsigned int i = 0U; i < loops; i++) {
+		disable_irq();
+		irq_bench_hit = 0U;
+		start = hrtimer_now();
+		irq_chip->set_pending(IRQ_BENCH_INTID, cpu);
+		enable_irq();
+		while (irq_bench_hit == 0U)
+			;
+
+		lat = irq_bench_hit - start;
+		min = MIN(min, lat);
+		max = MAX(max, lat);
+		sum += lat;
+	}
+	write_daif(flags);
+
+	irq_free(IRQ_BENCH_INTID);
+
+	INFO("irq dispatch: %s, %u samples, min %llu max %llu avg %llu ns\n",
+	     irq_chip->name, loops, (unsigned long long)min,
+	     (unsigned long long)max, (unsigned long long)(sum / loops));
+}
+#endif /* IRQ_DISPATCH_BENCH */
@@ -0,0 +1,277 @@
+/*
+ * Copyright (c) 2013-2022, Arm Limited and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <platform_def.h>
+
+#include <cassert.h>
+#include <debug.h>
+#include <larged.h>
+#include <lib/xlat_tables/xlat_tables_defs.h>
+#include <linux/bitmap.h>
+#include <spinlock.h>
+
+#if LARGED_TLB_BENCH
+#include <hrtimer.h>
+#endif
+
+#if PLAT_XLAT_TABLES_DYNAMIC
+
+/* The frames are the blocks of the level 2 and level 1 tables */
+CASSERT(LARGED_2M_SIZE == XLAT_BLOCK_SIZE(2U), assert_larged_2m_is_l2_block);
+CASSERT(LARGED_1G_SIZE == XLAT_BLOCK_SIZE(1U), assert_larged_1g_is_l1_block);
+CASSERT(LARGED_MAX_FRAMES <= UINT16_MAX, assert_larged_run_fits_16_bits);
+
+#define LARGED_FRAMES_PER_1G	(LARGED_1G_SIZE >> LARGED_2M_SHIFT)
+
+static uintptr_t larged_base;
+static unsigned int larged_nr_frames;
+static size_t larged_nr_free;
+
+/* Frames in use */
+static DECLARE_BITMAP(larged_map, LARGED_MAX_FRAMES);
+/* Frames of each buffer, recorded on its first frame */
+static uint16_t larged_run[LARGED_MAX_FRAMES];
+
+/* Serialises the bitmap and the changes to the kernel's tables */
+static spinlock_t larged_lock;
+
+static inline unsigned int larged_attr(unsigned int flags)
+{
+	unsigned int mem = ((flags & LARGED_NC) != 0U) ? MT_NON_CACHEABLE :
+							 MT_MEMORY;
+
+	return mem | MT_RW | MT_NS | MT_EXECUTE_NEVER;
+}
+
+/*
+ * Returns the first frame of a free run of 'nr' frames, starting on a 1GB
+ * boundary if 'align_1g', or a frame past the end of the pool if there is none.
+ */
+static unsigned long larged_find(unsigned int nr, bool align_1g)
+{
+	unsigned long mask = align_1g ? (LARGED_FRAMES_PER_1G - 1U) : 0UL;
+	/* Frame 'i' is 1GB aligned when 'i' plus this is a multiple of 512 */
+	unsigned long offset = (larged_base >> LARGED_2M_SHIFT) & mask;
+
+	return bitmap_find_next_zero_area_off(larged_map, larged_nr_frames,
+					      0UL, nr, mask, offset);
+}
+
+/*******************************************************************************
+ * Hand the 2MB frames of [base, base + size) to larged, once at boot. The range
+ * must not be mapped, larged maps the buffers it gives out itself.
+ ******************************************************************************/
+void larged_init(uintptr_t base, size_t size)
+{
+	uintptr_t start = round_up(base, LARGED_2M_SIZE);
+	uintptr_t end = round_down(base + size, LARGED_2M_SIZE);
+	uintptr_t start_1g = round_up(start, LARGED_1G_SIZE);
+	uintptr_t end_1g = round_down(end, LARGED_1G_SIZE);
+
+	assert(larged_nr_frames == 0U);
+	assert(end > start);
+	assert(((end - start) >> LARGED_2M_SHIFT) <= LARGED_MAX_FRAMES);
+
+	larged_base = start;
+	larged_nr_frames = (unsigned int)((end - start) >> LARGED_2M_SHIFT);
+	larged_nr_free = larged_nr_frames;
+	bitmap_zero(larged_map, LARGED_MAX_FRAMES);
+
+	INFO("larged: %u 2MB frames at 0x%lx, room for %lu 1GB ones\n",
+	     larged_nr_frames, larged_base, (end_1g > start_1g) ?
+	     (unsigned long)((end_1g - start_1g) >> LARGED_1G_SHIFT) : 0UL);
+}
+
+/*******************************************************************************
+ * Allocate a physically contiguous buffer of at least 'size' bytes, mapped
+ * with the largest blocks it can be. Its size is rounded up to 2MB, or to 1GB
+ * with LARGED_1G. A buffer of 1GB or more starts on a 1GB boundary, unless
+ * none is free and LARGED_1G isn't given. Returns NULL when no run of free
+ * frames is large enough, or when the buffer can't be mapped.
+ ******************************************************************************/
+void *larged_alloc(size_t size, unsigned int flags)
+{
+	size_t unit = ((flags & LARGED_1G) != 0U) ? LARGED_1G_SIZE :
+						     LARGED_2M_SIZE;
+	unsigned long idx = larged_nr_frames;
+	uintptr_t buf;
+	unsigned int nr;
+	int rc;
+
+	if ((size == 0U) ||
+	    ((uint64_t)size > ((uint64_t)larged_nr_frames << LARGED_2M_SHIFT)))
+		return NULL;
+
+	size = round_up(size, unit);
+	nr = (unsigned int)(size >> LARGED_2M_SHIFT);
+
+	spin_lock(&larged_lock);
+
+	if (size >= LARGED_1G_SIZE)
+		idx = larged_find(nr, true);
+	if (((idx + nr) > larged_nr_frames) && ((flags & LARGED_1G) == 0U))
+		idx = larged_find(nr, false);
+	if ((idx + nr) > larged_nr_frames) {
+		spin_unlock(&larged_lock);
+		return NULL;
+	}
+
+	buf = larged_base + (idx << LARGED_2M_SHIFT);
+	rc = mmap_add_dynamic_region(buf, buf, size, larged_attr(flags));
+	if (rc != 0) {
+		spin_unlock(&larged_lock);
+		WARN("larged: can't map 0x%lx, %d\n", buf, rc);
+		return NULL;
+	}
+
+	bitmap_set(larged_map, idx, nr);
+	larged_run[idx] = (uint16_t)nr;
+	larged_nr_free -= nr;
+
+	spin_unlock(&larged_lock);
+
+	if ((flags & LARGED_ZERO) != 0U)
+		(void)memset((void *)buf, 0, size);
+
+	return (void *)buf;
+}
+
+static unsigned long larged_frame_of(const void *buf)
+{
+	uintptr_t addr = (uintptr_t)buf;
+
+	assert((addr >= larged_base) &&
+	       (((addr - larged_base) >> LARGED_2M_SHIFT) < larged_nr_frames));
+	assert((addr & (LARGED_2M_SIZE - 1U)) == 0U);
+
+	return (addr - larged_base) >> LARGED_2M_SHIFT;
+}
+
+/*******************************************************************************
+ * Unmap and free a buffer returned by larged_alloc(). It must not be accessed
+ * anymore, from any CPU.
+ ******************************************************************************/
+void larged_free(void *buf)
+{
+	unsigned long idx = larged_frame_of(buf);
+	unsigned int nr;
+	int rc;
+
+	spin_lock(&larged_lock);
+
+	nr = larged_run[idx];
+	assert(nr != 0U);
+
+	rc = mmap_remove_dynamic_region((uintptr_t)buf,
+					(size_t)nr << LARGED_2M_SHIFT);
+	assert(rc == 0);
+	(void)rc;
+
+	larged_run[idx] = 0U;
+	bitmap_clear(larged_map, idx, nr);
+	larged_nr_free += nr;
+
+	spin_unlock(&larged_lock);
+}
+
+size_t larged_size(const void *buf)
+{
+	return (size_t)larged_run[larged_frame_of(buf)] << LARGED_2M_SHIFT;
+}
+
+size_t larged_nr_free_frames(void)
+{
+	return __atomic_load_n(&larged_nr_free, __ATOMIC_RELAXED);
+}
+
+#if LARGED_TLB_BENCH
+/* Picoseconds per access of 'loops' passes reading a word of every 4KB page */
+static uint64_t larged_bench_run(const uint8_t *buf, unsigned int loops)
+{
+	size_t pages = LARGED_BENCH_SIZE >> PAGE_SIZE_SHIFT;
+	uint64_t start = hrtimer_now();
+
+	for (unsigned int i = 0U; i < loops; i++) {
+		/* A different line of each page, not to miss in one cache set */
+		for (size_t p = 0U; p < pages; p++)
+			(void)*(volatile const uint64_t *)
+				&buf[(p << PAGE_SIZE_SHIFT) +
+				     ((p * CACHE_WRITEBACK_GRANULE) &
+				      PAGE_SIZE_MASK)];
+	}
+
+	return ((hrtimer_now() - start) * 1000U) / ((uint64_t)loops * pages);
+}
+
+/*******************************************************************************
+ * Stream through a LARGED_BENCH_SIZE buffer, reading a word of every 4KB page,
+ * once mapped with 2MB blocks and once remapped with 4KB pages. The buffer
+ * spans more pages than the TLBs hold, so that with 4KB pages most accesses
+ * miss. With XLAT_TABLES_CONTIG_HINT the pages are mapped with the contiguous
+ * hint, which is then measured as well. Meant for QEMU, run with -icount or on
+ * KVM for meaningful TLB costs.
+ ******************************************************************************/
+void larged_tlb_bench(unsigned int loops)
+{
+	uint64_t blocks, pages;
+	uintptr_t addr;
+	uint8_t *buf;
+	int rc;
+
+	assert(loops != 0U);
+
+	buf = larged_alloc(LARGED_BENCH_SIZE, LARGED_ZERO);
+	assert(buf != NULL);
+	addr = (uintptr_t)buf;
+
+	/* A first pass brings the buffer in the caches */
+	(void)larged_bench_run(buf, 1U);
+	blocks = larged_bench_run(buf, loops);
+
+	/*
+	 * The same frames, mapped with pages; larged_free() unmaps them too.
+	 * That takes a table per 2MB, which the platform must have room for.
+	 */
+	spin_lock(&larged_lock);
+	rc = mmap_remove_dynamic_region(addr, LARGED_BENCH_SIZE);
+	assert(rc == 0);
+	rc = mmap_add_dynamic_region2(addr, addr, LARGED_BENCH_SIZE,
+				      larged_attr(0U), PAGE_SIZE);
+	if (rc != 0) {
+		/* Back to blocks, in the tables the pages couldn't have */
+		int err = mmap_add_dynamic_region(addr, addr, LARGED_BENCH_SIZE,
+						  larged_attr(0U));
+
+		assert(err == 0);
+		(void)err;
+	}
+	spin_unlock(&larged_lock);
+
+	if (rc != 0) {
+		WARN("larged tlb: can't map %lu MB with 4KB pages, %d\n",
+		     (unsigned long)(LARGED_BENCH_SIZE >> 20), rc);
+		larged_free(buf);
+		return;
+	}
+
+	(void)larged_bench_run(buf, 1U);
+	pages = larged_bench_run(buf, loops);
+
+	larged_free(buf);
+
+	INFO("larged tlb: %u passes over %lu MB, %llu ps per access with 2MB "
+	     "pages, %llu ps with 4KB pages\n", loops,
+	     (unsigned long)(LARGED_BENCH_SIZE >> 20),
+	     (unsigned long long)blocks, (unsigned long long)pages);
+}
+#endif /* LARGED_TLB_BENCH */
+
+#endif /* PLAT_XLAT_TABLES_DYNAMIC */
@@ -1 +1,193 @@
-// one os can run in many cores of same chip
\ No newline at end of file
+/*
+ * Copyright (c) 2013-2022, Arm Limited and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+// one os can run in many cores of same chip
+
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+
+#include <platform_def.h>
+
+#include <arch_helpers.h>
+#include <ipi.h>
+#include <irqflags.h>
+#include <linux/bitmap.h>
+#include <linux/llist.h>
+#include <platform.h>
+#include <smp.h>
+
+typedef struct smp_cpu {
+	/* Calls to run on this CPU */
+	struct llist_head queue;
+	bool online;
+	/* Entries this CPU queues on each of the others */
+	smp_call_t calls[PLATFORM_CORE_COUNT];
+} __aligned(CACHE_WRITEBACK_GRANULE) smp_cpu_t;
+
+static smp_cpu_t smp_cpus[PLATFORM_CORE_COUNT];
+
+static inline void smp_call_lock_wait(smp_call_t *call)
+{
+	while (__atomic_load_n(&call->locked, __ATOMIC_ACQUIRE) != 0U)
+		;
+}
+
+static inline void smp_call_unlock(smp_call_t *call)
+{
+	__atomic_store_n(&call->locked, 0U, __ATOMIC_RELEASE);
+}
+
+/* Returns true if the queue of 'cpu' was empty, i.e. it needs an IPI */
+static bool smp_call_queue(unsigned int me, unsigned int cpu,
+			   smp_call_func_t func, void *info, bool wait)
+{
+	smp_call_t *call = &smp_cpus[me].calls[cpu];
+
+	/*
+	 * The previous asynchronous call to 'cpu' may not have run yet. This
+	 * runs with interrupts masked and 'cpu' may be doing the same, waiting
+	 * for a call it queued here: run the calls queued on this CPU while
+	 * waiting, as the IPI handler would.
+	 */
+	while (__atomic_load_n(&call->locked, __ATOMIC_ACQUIRE) != 0U) {
+		if (!llist_empty(&smp_cpus[me].queue))
+			smp_call_function_interrupt();
+	}
+
+	call->locked = 1U;
+	call->func = func;
+	call->info = info;
+	call->wait = wait;
+
+	return llist_add(&call->node, &smp_cpus[cpu].queue);
+}
+
+/*******************************************************************************
+ * Run func(info) on every CPU set in 'cpus' but the calling one. With 'wait',
+ * return once all of them are done; this must not be called with interrupts
+ * masked, two CPUs waiting on each other would never return.
+ ******************************************************************************/
+void smp_call_function_many(const unsigned long *cpus, smp_call_func_t func,
+			    void *info, bool wait)
+{
+	DECLARE_BITMAP(kick, PLATFORM_CORE_COUNT);
+	unsigned int me, cpu;
+	u_register_t flags;
+
+	assert(func != NULL);
+
+	flags = local_irq_save();
+
+	me = plat_my_core_pos();
+	bitmap_zero(kick, PLATFORM_CORE_COUNT);
+
+	for_each_set_bit(cpu, cpus, PLATFORM_CORE_COUNT) {
+		if (cpu == me)
+			continue;
+		if (smp_call_queue(me, cpu, func, info, wait))
+			__set_bit(cpu, kick);
+	}
+
+	if (!bitmap_empty(kick, PLATFORM_CORE_COUNT))
+		ipi_send_many(kick, IPI_CALL_FUNC);
+
+	local_irq_restore(flags);
+
+	if (!wait)
+		return;
+
+	for_each_set_bit(cpu, cpus, PLATFORM_CORE_COUNT) {
+		if (cpu != me)
+			smp_call_lock_wait(&smp_cpus[me].calls[cpu]);
+	}
+}
+
+int smp_call_function_single(unsigned int cpu, smp_call_func_t func,
+			     void *info, bool wait)
+{
+	DECLARE_BITMAP(cpus, PLATFORM_CORE_COUNT);
+	u_register_t flags;
+
+	if ((cpu >= PLATFORM_CORE_COUNT) || !smp_cpus[cpu].online)
+		return -EINVAL;
+
+	if (cpu == plat_my_core_pos()) {
+		flags = local_irq_save();
+		func(info);
+		local_irq_restore(flags);
+		return 0;
+	}
+
+	bitmap_zero(cpus, PLATFORM_CORE_COUNT);
+	__set_bit(cpu, cpus);
+	smp_call_function_many(cpus, func, info, wait);
+
+	return 0;
+}
+
+bool smp_cpu_online(unsigned int cpu)
+{
+	assert(cpu < PLATFORM_CORE_COUNT);
+
+	return __atomic_load_n(&smp_cpus[cpu].online, __ATOMIC_ACQUIRE);
+}
+
+/* Run func(info) on every other online CPU */
+void smp_call_function(smp_call_func_t func, void *info, bool wait)
+{
+	DECLARE_BITMAP(cpus, PLATFORM_CORE_COUNT);
+
+	bitmap_zero(cpus, PLATFORM_CORE_COUNT);
+	for (unsigned int cpu = 0U; cpu < PLATFORM_CORE_COUNT; cpu++) {
+		if (smp_cpus[cpu].online)
+			__set_bit(cpu, cpus);
+	}
+
+	smp_call_function_many(cpus, func, info, wait);
+}
+
+/*******************************************************************************
+ * IPI_CALL_FUNC handler: run everything queued, oldest first. An asynchronous
+ * entry is released before its function runs, a synchronous one after.
+ ******************************************************************************/
+void smp_call_function_interrupt(void)
+{
+	smp_cpu_t *sc = &smp_cpus[plat_my_core_pos()];
+	struct llist_node *list;
+	smp_call_t *call, *tmp;
+	smp_call_func_t func;
+	void *info;
+
+	list = llist_del_all(&sc->queue);
+	list = llist_reverse_order(list);
+
+	llist_for_each_entry_safe(call, tmp, list, node) {
+		func = call->func;
+		info = call->info;
+
+		if (call->wait) {
+			func(info);
+			smp_call_unlock(call);
+		} else {
+			smp_call_unlock(call);
+			func(info);
+		}
+	}
+}
+
+/*
+ * Called by every CPU once its interrupt controller interface is up. Calls
+ * queued earlier stay in the queue until the first IPI.
+ */
+void smp_cpu_init(void)
+{
+	smp_cpu_t *sc = &smp_cpus[plat_my_core_pos()];
+
+	ipi_cpu_init();
+
+	__atomic_store_n(&sc->online, true, __ATOMIC_RELEASE);
+}
@@ -1 +1,515 @@
+/*
+ * Copyright (c) 2013-2022, Arm Limited and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
 // for armv9, has 3 world, non-secure,secure,real
+
+#include <vgic.h>
+
+#if VGIC_SUPPORT
+
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <platform_def.h>
+
+#include <arch_helpers.h>
+#include <debug.h>
+#include <drivers/gic/gicv3.h>
+#include <irq.h>
+#include <irqflags.h>
+#include <platform.h>
+#include <smp.h>
+
+/* Shape of the virtual CPU interface, the same on every CPU */
+static unsigned int vgic_nr_lr;
+static unsigned int vgic_nr_apr;
+static uint8_t vgic_pri_mask;
+
+/* Virtual CPU loaded on each physical CPU */
+static vgic_cpu_t *vgic_loaded[PLATFORM_CORE_COUNT];
+
+static uint64_t vgic_read_lr(unsigned int lr)
+{
+	switch (lr) {
+	case 0U: return read_ich_lr0_el2();
+	case 1U: return read_ich_lr1_el2();
+	case 2U: return read_ich_lr2_el2();
+	case 3U: return read_ich_lr3_el2();
+	case 4U: return read_ich_lr4_el2();
+	case 5U: return read_ich_lr5_el2();
+	case 6U: return read_ich_lr6_el2();
+	case 7U: return read_ich_lr7_el2();
+	case 8U: return read_ich_lr8_el2();
+	case 9U: return read_ich_lr9_el2();
+	case 10U: return read_ich_lr10_el2();
+	case 11U: return read_ich_lr11_el2();
+	case 12U: return read_ich_lr12_el2();
+	case 13U: return read_ich_lr13_el2();
+	case 14U: return read_ich_lr14_el2();
+	case 15U: return read_ich_lr15_el2();
+	default:
+		panic();
+	}
+}
+
+static void vgic_write_lr(unsigned int lr, uint64_t val)
+{
+	switch (lr) {
+	case 0U: write_ich_lr0_el2(val); break;
+	case 1U: write_ich_lr1_el2(val); break;
+	case 2U: write_ich_lr2_el2(val); break;
+	case 3U: write_ich_lr3_el2(val); break;
+	case 4U: write_ich_lr4_el2(val); break;
+	case 5U: write_ich_lr5_el2(val); break;
+	case 6U: write_ich_lr6_el2(val); break;
+	case 7U: write_ich_lr7_el2(val); break;
+	case 8U: write_ich_lr8_el2(val); break;
+	case 9U: write_ich_lr9_el2(val); break;
+	case 10U: write_ich_lr10_el2(val); break;
+	case 11U: write_ich_lr11_el2(val); break;
+	case 12U: write_ich_lr12_el2(val); break;
+	case 13U: write_ich_lr13_el2(val); break;
+	case 14U: write_ich_lr14_el2(val); break;
+	case 15U: write_ich_lr15_el2(val); break;
+	default:
+		panic();
+	}
+}
+
+static uint64_t vgic_read_apr(unsigned int n)
+{
+	switch (n) {
+	case 0U: return read_ich_ap1r0_el2();
+	case 1U: return read_ich_ap1r1_el2();
+	case 2U: return read_ich_ap1r2_el2();
+	default: return read_ich_ap1r3_el2();
+	}
+}
+
+static void vgic_write_apr(unsigned int n, uint64_t val)
+{
+	switch (n) {
+	case 0U: write_ich_ap1r0_el2(val); break;
+	case 1U: write_ich_ap1r1_el2(val); break;
+	case 2U: write_ich_ap1r2_el2(val); break;
+	default: write_ich_ap1r3_el2(val); break;
+	}
+}
+
+static inline unsigned int vgic_lr_state(uint64_t lr)
+{
+	return (unsigned int)((lr >> ICH_LR_STATE_SHIFT) & ICH_LR_STATE_MASK);
+}
+
+static inline unsigned int vgic_lr_priority(uint64_t lr)
+{
+	return (unsigned int)((lr >> ICH_LR_PRIORITY_SHIFT) &
+			      ICH_LR_PRIORITY_MASK);
+}
+
+/*
+ * Pending Group 1 virtual interrupt. The EOI bit is clear: the guest's
+ * deactivation is not trapped, freed list registers are found through
+ * ICH_ELRSR_EL2 instead.
+ */
+static inline uint64_t vgic_lr_make(unsigned int intid, unsigned int priority)
+{
+	return (ICH_LR_STATE_PENDING << ICH_LR_STATE_SHIFT) | ICH_LR_GROUP_BIT |
+	       ((uint64_t)priority << ICH_LR_PRIORITY_SHIFT) |
+	       ((uint64_t)intid & ICH_LR_VINTID_MASK);
+}
+
+/*******************************************************************************
+ * Release the list registers the guest is done with. Must be called on the CPU
+ * 'vcpu' is loaded on.
+ ******************************************************************************/
+static void vgic_sync(vgic_cpu_t *vcpu)
+{
+	uint64_t empty = read_ich_elrsr_el2();
+
+	for (unsigned int lr = 0U; lr < vgic_nr_lr; lr++) {
+		if ((vcpu->lr_intid[lr] != VGIC_LR_FREE) &&
+		    ((empty & BIT_64(lr)) != 0ULL))
+			vcpu->lr_intid[lr] = VGIC_LR_FREE;
+	}
+}
+
+/*
+ * Fold a new edge of an interrupt already held by list register 'lr' into it:
+ * a pending one stays pending, an active one becomes pending and active.
+ */
+static void vgic_merge(unsigned int lr)
+{
+	uint64_t val = vgic_read_lr(lr);
+
+	if (vgic_lr_state(val) == ICH_LR_STATE_ACTIVE) {
+		val |= ICH_LR_STATE_PENDING << ICH_LR_STATE_SHIFT;
+		vgic_write_lr(lr, val);
+	}
+}
+
+/* Highest priority queued interrupt, VGIC_NR_IRQS if none */
+static unsigned int vgic_next(const vgic_cpu_t *vcpu)
+{
+	unsigned int intid, best = VGIC_NR_IRQS;
+
+	for_each_set_bit(intid, vcpu->pending, VGIC_NR_IRQS) {
+		if ((best == VGIC_NR_IRQS) ||
+		    (vcpu->priority[intid] < vcpu->priority[best]))
+			best = intid;
+	}
+
+	return best;
+}
+
+/*
+ * List register to give to an interrupt of 'priority' when none is free: the
+ * lowest priority one which is only pending and below 'priority'. Returns
+ * VGIC_MAX_LRS if there is none.
+ */
+static unsigned int vgic_victim(unsigned int priority)
+{
+	unsigned int lr, victim = VGIC_MAX_LRS, worst = priority;
+
+	for (lr = 0U; lr < vgic_nr_lr; lr++) {
+		uint64_t val = vgic_read_lr(lr);
+
+		if ((vgic_lr_state(val) == ICH_LR_STATE_PENDING) &&
+		    (vgic_lr_priority(val) > worst)) {
+			worst = vgic_lr_priority(val);
+			victim = lr;
+		}
+	}
+
+	return victim;
+}
+
+/*******************************************************************************
+ * Move queued interrupts into list registers, highest priority first, and arm
+ * the underflow maintenance interrupt if some are left queued. Must be called
+ * on the CPU 'vcpu' is loaded on, with its lock held.
+ ******************************************************************************/
+static void vgic_flush(vgic_cpu_t *vcpu)
+{
+	unsigned int intid, lr;
+	uint64_t hcr;
+
+	vgic_sync(vcpu);
+
+	for (lr = 0U; lr < vgic_nr_lr; lr++) {
+		intid = vcpu->lr_intid[lr];
+		if ((intid != VGIC_LR_FREE) && test_bit(intid, vcpu->pending)) {
+			vgic_merge(lr);
+			__clear_bit(intid, vcpu->pending);
+		}
+	}
+
+	while ((intid = vgic_next(vcpu)) != VGIC_NR_IRQS) {
+		for (lr = 0U; lr < vgic_nr_lr; lr++) {
+			if (vcpu->lr_intid[lr] == VGIC_LR_FREE)
+				break;
+		}
+
+		if (lr == vgic_nr_lr) {
+			lr = vgic_victim(vcpu->priority[intid]);
+			if (lr == VGIC_MAX_LRS)
+				break;
+
+			/* Back to the queue, it is delivered later */
+			__set_bit(vcpu->lr_intid[lr], vcpu->pending);
+			vcpu->stats.evictions++;
+		}
+
+		vgic_write_lr(lr, vgic_lr_make(intid, vcpu->priority[intid]));
+		vcpu->lr_intid[lr] = (uint16_t)intid;
+		__clear_bit(intid, vcpu->pending);
+	}
+
+	hcr = read_ich_hcr_el2();
+	if (intid != VGIC_NR_IRQS)
+		hcr |= ICH_HCR_UIE_BIT;
+	else
+		hcr &= ~ICH_HCR_UIE_BIT;
+	write_ich_hcr_el2(hcr);
+	isb();
+}
+
+static irq_return_t vgic_maintenance(unsigned int intid, void *data)
+{
+	vgic_cpu_t *vcpu = vgic_loaded[plat_my_core_pos()];
+	uint32_t misr = (uint32_t)read_ich_misr_el2();
+
+	if (vcpu == NULL) {
+		/* Nothing loaded, stop the source */
+		write_ich_hcr_el2(0ULL);
+		return IRQ_NONE;
+	}
+
+	spin_lock(&vcpu->lock);
+	vcpu->stats.maintenance++;
+	if ((misr & ICH_MISR_U_BIT) != 0U)
+		vgic_flush(vcpu);
+	spin_unlock(&vcpu->lock);
+
+	return IRQ_HANDLED;
+}
+
+/* Cross-CPU call: queue new interrupts on the CPU 'info' is loaded on */
+static void vgic_kick(void *info)
+{
+	vgic_cpu_t *vcpu = info;
+	u_register_t flags = local_irq_save();
+
+	spin_lock(&vcpu->lock);
+	/* It may have been put meanwhile, load flushes then */
+	if (vcpu->cpu == plat_my_core_pos())
+		vgic_flush(vcpu);
+	spin_unlock(&vcpu->lock);
+
+	local_irq_restore(flags);
+}
+
+/*******************************************************************************
+ * Make virtual interrupt 'intid' pending on 'vcpu'. It goes into a list
+ * register right away if 'vcpu' is loaded on the calling CPU, is handed to the
+ * CPU it is loaded on otherwise, or waits for vgic_load().
+ ******************************************************************************/
+int vgic_inject(vgic_cpu_t *vcpu, unsigned int intid, unsigned int priority)
+{
+	unsigned int me = plat_my_core_pos();
+	unsigned int cpu;
+	u_register_t flags;
+
+	if ((intid >= VGIC_NR_IRQS) || (priority > 0xffU) || (vgic_nr_lr == 0U))
+		return -EINVAL;
+
+	flags = local_irq_save();
+	spin_lock(&vcpu->lock);
+
+	vcpu->priority[intid] = (uint8_t)priority & vgic_pri_mask;
+	__set_bit(intid, vcpu->pending);
+	vcpu->stats.injected++;
+
+	cpu = vcpu->cpu;
+	if (cpu == me) {
+		vgic_flush(vcpu);
+		if (test_bit(intid, vcpu->pending))
+			vcpu->stats.overflows++;
+	}
+
+	spin_unlock(&vcpu->lock);
+	local_irq_restore(flags);
+
+	if ((cpu != me) && (cpu != VGIC_NOT_LOADED))
+		return smp_call_function_single(cpu, vgic_kick, vcpu, false);
+
+	return 0;
+}
+
+void vgic_vcpu_init(vgic_cpu_t *vcpu)
+{
+	(void)memset(vcpu, 0, sizeof(*vcpu));
+
+	vcpu->cpu = VGIC_NOT_LOADED;
+	for (unsigned int lr = 0U; lr < VGIC_MAX_LRS; lr++)
+		vcpu->lr_intid[lr] = VGIC_LR_FREE;
+}
+
+/*******************************************************************************
+ * Restore the virtual CPU interface of 'vcpu' on the calling CPU, before
+ * entering its guest.
+ ******************************************************************************/
+void vgic_load(vgic_cpu_t *vcpu)
+{
+	unsigned int me = plat_my_core_pos();
+	u_register_t flags = local_irq_save();
+	unsigned int i;
+
+	assert(vgic_loaded[me] == NULL);
+
+	spin_lock(&vcpu->lock);
+	assert(vcpu->cpu == VGIC_NOT_LOADED);
+
+	for (i = 0U; i < vgic_nr_lr; i++)
+		vgic_write_lr(i, vcpu->lr[i]);
+	for (i = 0U; i < vgic_nr_apr; i++)
+		vgic_write_apr(i, vcpu->ap1r[i]);
+	write_ich_vmcr_el2(vcpu->vmcr);
+	write_ich_hcr_el2(ICH_HCR_EN_BIT);
+	isb();
+
+	vcpu->cpu = me;
+	vgic_loaded[me] = vcpu;
+
+	/* Interrupts injected while it was not loaded */
+	vgic_flush(vcpu);
+
+	spin_unlock(&vcpu->lock);
+	local_irq_restore(flags);
+}
+
+/*******************************************************************************
+ * Save the virtual CPU interface of 'vcpu', loaded on the calling CPU, after
+ * leaving its guest.
+ ******************************************************************************/
+void vgic_put(vgic_cpu_t *vcpu)
+{
+	unsigned int me = plat_my_core_pos();
+	u_register_t flags = local_irq_save();
+	unsigned int i;
+
+	assert(vgic_loaded[me] == vcpu);
+
+	spin_lock(&vcpu->lock);
+
+	vgic_sync(vcpu);
+	for (i = 0U; i < vgic_nr_lr; i++) {
+		vcpu->lr[i] = vgic_read_lr(i);
+		vgic_write_lr(i, 0ULL);
+	}
+	for (i = 0U; i < vgic_nr_apr; i++)
+		vcpu->ap1r[i] = vgic_read_apr(i);
+	vcpu->vmcr = read_ich_vmcr_el2();
+	write_ich_hcr_el2(0ULL);
+	isb();
+
+	vcpu->cpu = VGIC_NOT_LOADED;
+	vgic_loaded[me] = NULL;
+
+	spin_unlock(&vcpu->lock);
+	local_irq_restore(flags);
+}
+
+unsigned int vgic_nr_lrs(void)
+{
+	return vgic_nr_lr;
+}
+
+/*******************************************************************************
+ * Set up the virtual CPU interface of the calling CPU. The kernel must run at
+ * EL2 with the GICv3 system register interface.
+ ******************************************************************************/
+int vgic_cpu_init(void)
+{
+	uint64_t vtr;
+	unsigned int prebits, pribits;
+
+	if (!IS_IN_EL2() ||
+	    (((read_id_aa64pfr0_el1() >> ID_AA64PFR0_GIC_SHIFT) &
+	      ID_AA64PFR0_GIC_MASK) == 0ULL)) {
+		WARN("vGIC: no GICv3 virtual CPU interface at this EL\n");
+		return -ENODEV;
+	}
+
+	vtr = read_ich_vtr_el2();
+	prebits = (unsigned int)((vtr >> ICH_VTR_PREBITS_SHIFT) &
+				 ICH_VTR_PREBITS_MASK) + 1U;
+	pribits = (unsigned int)((vtr >> ICH_VTR_PRIBITS_SHIFT) &
+				 ICH_VTR_PRIBITS_MASK) + 1U;
+
+	vgic_nr_lr = (unsigned int)(vtr & ICH_VTR_LISTREGS_MASK) + 1U;
+	vgic_nr_apr = 1U << (prebits - 5U);
+	vgic_pri_mask = (uint8_t)(0xffU << (8U - pribits));
+
+	write_ich_hcr_el2(0ULL);
+	for (unsigned int lr = 0U; lr < vgic_nr_lr; lr++)
+		vgic_write_lr(lr, 0ULL);
+	isb();
+
+	return irq_request(GICV3_MAINT_INTID, IRQ_FLOW_PERCPU, vgic_maintenance,
+			   NULL, "vgic-maint");
+}
+
+#if VGIC_SELFTEST
+static vgic_cpu_t vgic_selftest_vcpu;
+
+/* Number of list registers holding a valid interrupt */
+static unsigned int vgic_selftest_used(void)
+{
+	uint64_t empty = read_ich_elrsr_el2();
+	unsigned int lr, used = 0U;
+
+	for (lr = 0U; lr < vgic_nr_lr; lr++) {
+		if ((empty & BIT_64(lr)) == 0ULL)
+			used++;
+	}
+
+	return used;
+}
+
+/*******************************************************************************
+ * Overflow the list registers of a virtual CPU loaded on the calling CPU,
+ * check that a high priority interrupt takes a list register back, then play
+ * the guest consuming everything and check that the underflow maintenance
+ * interrupt refills the list registers. Meant for QEMU virt with
+ * virtualization=on; interrupts must be unmasked on the calling CPU.
+ ******************************************************************************/
+int vgic_selftest(void)
+{
+	vgic_cpu_t *vcpu = &vgic_selftest_vcpu;
+	unsigned int nr = vgic_nr_lr + 4U;
+	unsigned int i, lr, used, queued;
+	uint64_t maintenance;
+	bool found = false;
+	int rc = 0;
+
+	if ((vgic_nr_lr == 0U) || (nr >= VGIC_NR_IRQS))
+		return -ENODEV;
+
+	vgic_vcpu_init(vcpu);
+	vgic_load(vcpu);
+
+	for (i = 0U; i < nr; i++)
+		(void)vgic_inject(vcpu, 32U + i, 0xa0U);
+	(void)vgic_inject(vcpu, 32U + nr, 0x20U);
+
+	for (lr = 0U; lr < vgic_nr_lr; lr++) {
+		if ((vgic_read_lr(lr) & ICH_LR_VINTID_MASK) == (32U + nr))
+			found = true;
+	}
+
+	if ((vgic_selftest_used() != vgic_nr_lr) || !found ||
+	    (vcpu->stats.overflows != 4U) || (vcpu->stats.evictions != 1U))
+		rc = -EIO;
+
+	/* Play the guest: everything delivered is done with */
+	maintenance = vcpu->stats.maintenance;
+	local_irq_disable();
+	for (lr = 0U; lr < vgic_nr_lr; lr++)
+		vgic_write_lr(lr, 0ULL);
+	isb();
+	local_irq_enable();
+
+	for (i = 0U; (i < 1000000U) &&
+	     (__atomic_load_n(&vcpu->stats.maintenance, __ATOMIC_RELAXED) ==
+	      maintenance); i++)
+		;
+
+	/* 5 interrupts were left queued */
+	used = vgic_selftest_used();
+	queued = (vgic_nr_lr < 5U) ? (5U - vgic_nr_lr) : 0U;
+	if ((vcpu->stats.maintenance == maintenance) ||
+	    (used != (5U - queued)) ||
+	    (bitmap_weight(vcpu->pending, VGIC_NR_IRQS) != queued))
+		rc = -EIO;
+
+	INFO("vGIC selftest: %u LRs, %llu overflows, %llu evictions, "
+	     "%llu maintenance, %u refilled\n", vgic_nr_lr,
+	     (unsigned long long)vcpu->stats.overflows,
+	     (unsigned long long)vcpu->stats.evictions,
+	     (unsigned long long)vcpu->stats.maintenance, used);
+
+	bitmap_zero(vcpu->pending, VGIC_NR_IRQS);
+	vgic_put(vcpu);
+
+	return rc;
+}
+#endif /* VGIC_SELFTEST */
+
+#endif /* VGIC_SUPPORT */
@@ -1 +1,955 @@
-// image entrypoint
\ No newline at end of file
+/*
+ * Copyright (c) 2013-2022, Arm Limited and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+// image entrypoint
+
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <platform_def.h>
+
+#include <arch.h>
+#include <arch_features.h>
+#include <arch_helpers.h>
+#include <cassert.h>
+#include <debug.h>
+#include <irqflags.h>
+#include <linux/bitmap.h>
+#include <linux/rbtree_augmented.h>
+#include <mm.h>
+#include <platform.h>
+#include <spinlock.h>
+#include <vdso.h>
+#include <vm.h>
+
+#if VM_SWITCH_BENCH
+#include <hrtimer.h>
+#endif
+
+#define VM_ASID_MAX_BITS	U(16)
+#define VM_NR_ASIDS_MAX		(U(1) << VM_ASID_MAX_BITS)
+
+#ifdef NS_DRAM0_BASE
+/* The kernel maps the NS DRAM flat, user areas must stay below it */
+CASSERT(VM_MMAP_END <= NS_DRAM0_BASE, assert_vm_mmap_below_ns_dram);
+#endif
+
+/* Pages vm_area_remove() unmaps with a single TLB invalidation */
+#define VM_UNMAP_BATCH		U(32)
+
+static unsigned int vm_asid_bits;
+static uint64_t vm_asid_mask;
+static bool vm_ttbr_cnp;
+
+/* Current generation, in the bits above the ASID. Starts at 1, 0 is unused */
+static uint64_t vm_generation;
+
+/* ASIDs in use in the current generation. ASID 0 is never given out */
+static DECLARE_BITMAP(vm_asid_map, VM_NR_ASIDS_MAX);
+static unsigned int vm_asid_next = 1U;
+
+/*
+ * ASID each CPU runs with. Zeroed at a rollover, so that a CPU racing with it
+ * takes the slow path. The ASID it had then is kept in vm_reserved[].
+ */
+static uint64_t vm_active[PLATFORM_CORE_COUNT];
+static uint64_t vm_reserved[PLATFORM_CORE_COUNT];
+/* CPUs that must invalidate their TLBs before using a new ASID */
+static DECLARE_BITMAP(vm_flush_pending, PLATFORM_CORE_COUNT);
+
+/* Serialises allocation and rollover */
+static spinlock_t vm_asid_lock;
+
+/* Space each CPU runs, whose faults it handles */
+static vm_space_t *vm_running[PLATFORM_CORE_COUNT];
+
+static inline uint64_t vm_asid_of(uint64_t asid)
+{
+	return asid & vm_asid_mask;
+}
+
+static inline bool vm_asid_current(uint64_t asid)
+{
+	return ((asid ^ __atomic_load_n(&vm_generation, __ATOMIC_RELAXED)) >>
+		vm_asid_bits) == 0U;
+}
+
+/*******************************************************************************
+ * Start a new generation. Every ASID is free again, except the ones the CPUs
+ * are running with, which are reserved for their space.
+ ******************************************************************************/
+static void vm_asid_rollover(void)
+{
+	bitmap_zero(vm_asid_map, VM_NR_ASIDS_MAX);
+
+	for (unsigned int cpu = 0U; cpu < PLATFORM_CORE_COUNT; cpu++) {
+		uint64_t asid = __atomic_exchange_n(&vm_active[cpu], 0U,
+						    __ATOMIC_RELAXED);
+
+		/* Rolled over again before it switched, keep what it runs */
+		if (asid == 0U)
+			asid = vm_reserved[cpu];
+
+		__set_bit((unsigned int)vm_asid_of(asid), vm_asid_map);
+		vm_reserved[cpu] = asid;
+		__set_bit(cpu, vm_flush_pending);
+	}
+}
+
+/*
+ * Moves 'asid' to the current generation if it is reserved by a CPU, which
+ * may be running with it.
+ */
+static bool vm_asid_update_reserved(uint64_t asid, uint64_t new_asid)
+{
+	bool hit = false;
+
+	for (unsigned int cpu = 0U; cpu < PLATFORM_CORE_COUNT; cpu++) {
+		if (vm_reserved[cpu] == asid) {
+			vm_reserved[cpu] = new_asid;
+			hit = true;
+		}
+	}
+
+	return hit;
+}
+
+/* Returns an ASID of the current generation for 'vm', with the lock held */
+static uint64_t vm_asid_alloc(const vm_space_t *vm)
+{
+	uint64_t asid = vm->asid;
+	uint64_t generation = vm_generation;
+	unsigned int nr = 1U << vm_asid_bits;
+	unsigned int idx;
+
+	if (asid != 0U) {
+		uint64_t new_asid = generation | vm_asid_of(asid);
+
+		/* Keep the same ASID if possible, its TLB entries are valid */
+		if (vm_asid_update_reserved(asid, new_asid))
+			return new_asid;
+		if (!test_bit((unsigned int)vm_asid_of(asid), vm_asid_map)) {
+			__set_bit((unsigned int)vm_asid_of(asid), vm_asid_map);
+			return new_asid;
+		}
+	}
+
+	idx = find_next_zero_bit(vm_asid_map, nr, vm_asid_next);
+	if (idx == nr) {
+		generation += U(1) << vm_asid_bits;
+		__atomic_store_n(&vm_generation, generation, __ATOMIC_RELAXED);
+		vm_asid_rollover();
+		idx = find_next_zero_bit(vm_asid_map, nr, 1U);
+		/* At most one ASID is reserved per CPU */
+		assert(idx != nr);
+	}
+
+	__set_bit(idx, vm_asid_map);
+	vm_asid_next = idx;
+
+	return generation | idx;
+}
+
+static inline void vm_write_ttbr0(const vm_space_t *vm, uint64_t asid)
+{
+	uint64_t ttbr0 = (uint64_t)(uintptr_t)vm->base_table |
+			 (vm_asid_of(asid) << TTBR_ASID_SHIFT);
+
+	if (vm_ttbr_cnp)
+		ttbr0 |= TTBR_CNP_BIT;
+
+	/* Table and ASID change together, in a single write */
+	write_ttbr0_el1(ttbr0);
+	isb();
+}
+
+/*******************************************************************************
+ * Switch the calling CPU to address space 'vm'. The TLBs are only invalidated
+ * the first time the CPU runs after an ASID rollover.
+ ******************************************************************************/
+void vm_switch(vm_space_t *vm)
+{
+	unsigned int cpu = plat_my_core_pos();
+	u_register_t flags = local_irq_save();
+	uint64_t asid, active;
+
+	assert(vm_generation != 0U);
+
+	/*
+	 * Fast path: the ASID is of the current generation and no rollover
+	 * is running, which would have zeroed the active ASID.
+	 */
+	asid = __atomic_load_n(&vm->asid, __ATOMIC_RELAXED);
+	active = __atomic_load_n(&vm_active[cpu], __ATOMIC_RELAXED);
+	if ((active != 0U) && vm_asid_current(asid) &&
+	    __atomic_compare_exchange_n(&vm_active[cpu], &active, asid, false,
+					__ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+		vm_write_ttbr0(vm, asid);
+		vm_running[cpu] = vm;
+		local_irq_restore(flags);
+		return;
+	}
+
+	spin_lock(&vm_asid_lock);
+
+	asid = vm->asid;
+	if (!vm_asid_current(asid)) {
+		asid = vm_asid_alloc(vm);
+		__atomic_store_n(&vm->asid, asid, __ATOMIC_RELAXED);
+	}
+
+	if (test_bit(cpu, vm_flush_pending)) {
+		__clear_bit(cpu, vm_flush_pending);
+		tlbivmalle1();
+		dsbnsh();
+	}
+
+	__atomic_store_n(&vm_active[cpu], asid, __ATOMIC_RELAXED);
+
+	spin_unlock(&vm_asid_lock);
+
+	vm_write_ttbr0(vm, asid);
+	vm_running[cpu] = vm;
+	local_irq_restore(flags);
+}
+
+vm_space_t *vm_current(void)
+{
+	return vm_running[plat_my_core_pos()];
+}
+
+/*******************************************************************************
+ * Make 'ctx' the translation context of the empty space 'vm', and map the vDSO
+ * clock page in it.
+ ******************************************************************************/
+int vm_space_init(vm_space_t *vm, xlat_ctx_t *ctx)
+{
+	assert(ctx->xlat_regime == EL1_EL0_REGIME);
+	assert(ctx->va_max_address >= (VM_MMAP_END - 1U));
+
+	vm->base_table = ctx->base_table;
+	vm->asid = 0U;
+	vm->ctx = ctx;
+	vm->areas = RB_ROOT;
+	vm->lock.lock = 0U;
+
+#if PLAT_XLAT_TABLES_DYNAMIC
+	return vdso_map(ctx, VDSO_USER_VA);
+#else
+	return 0;
+#endif
+}
+
+unsigned int vm_space_asid(const vm_space_t *vm)
+{
+	return (unsigned int)vm_asid_of(__atomic_load_n(&vm->asid,
+							__ATOMIC_RELAXED));
+}
+
+/*******************************************************************************
+ * Set up the ASID allocator, once on the boot CPU. The kernel must run in the
+ * EL1&0 translation regime: the ASID size is the one enabled in TCR_EL1.
+ ******************************************************************************/
+void vm_asid_init(void)
+{
+	assert(IS_IN_EL1());
+
+	vm_asid_bits = ((read_tcr_el1() & TCR_AS_BIT) != 0U) ? 16U : 8U;
+	vm_asid_mask = (U(1) << vm_asid_bits) - 1U;
+	vm_ttbr_cnp = is_armv8_2_ttcnp_present();
+	vm_generation = U(1) << vm_asid_bits;
+
+	/* ASID 0 is what the kernel ran with so far */
+	__set_bit(0U, vm_asid_map);
+
+	INFO("vm: %u-bit ASIDs\n", vm_asid_bits);
+}
+
+#if PLAT_XLAT_TABLES_DYNAMIC
+/* What a read fault maps, shared by all spaces. VA == PA like the whole image */
+static const uint8_t vm_zero_page[PAGE_SIZE] __aligned(PAGE_SIZE);
+
+/* Unused areas, carved from pages of the allocator and never given back */
+static vm_area_t *vm_area_cache;
+static spinlock_t vm_area_cache_lock;
+
+static inline uintptr_t vm_area_gap_of(const vm_area_t *area)
+{
+	return area->gap;
+}
+
+RB_DECLARE_CALLBACKS_MAX(static, vm_area_gap_cb, vm_area_t, node, uintptr_t,
+			 subtree_gap, vm_area_gap_of)
+
+static inline vm_area_t *vm_area_entry(struct rb_node *node)
+{
+	return (node != NULL) ? rb_entry(node, vm_area_t, node) : NULL;
+}
+
+static inline uintptr_t vm_gap_size(uintptr_t base, uintptr_t end)
+{
+	base = (base > VM_MMAP_BASE) ? base : VM_MMAP_BASE;
+
+	return (end > base) ? (end - base) : 0U;
+}
+
+/* Gap between 'area' and the area before it */
+static uintptr_t vm_area_gap_below(const vm_area_t *area)
+{
+	const vm_area_t *prev = vm_area_entry(rb_prev(&area->node));
+
+	return vm_gap_size((prev != NULL) ? prev->end : 0U, area->start);
+}
+
+/* Attributes of the read-only mappings of an area */
+static inline uint32_t vm_area_ro_attr(const vm_area_t *area)
+{
+	uint32_t attr = area->attr & ~MT_RW;
+
+	/* Writable memory is never executable, keep it so */
+	if ((area->attr & MT_RW) != 0U)
+		attr |= MT_EXECUTE_NEVER;
+
+	return attr;
+}
+
+static vm_area_t *vm_area_alloc(void)
+{
+	vm_area_t *area;
+
+	spin_lock(&vm_area_cache_lock);
+
+	if (vm_area_cache == NULL) {
+		vm_area_t *page = mm_page_alloc(0U);
+
+		if (page == NULL) {
+			spin_unlock(&vm_area_cache_lock);
+			return NULL;
+		}
+
+		for (unsigned int i = 0U; i < PAGE_SIZE / sizeof(*page); i++) {
+			page[i].next = vm_area_cache;
+			vm_area_cache = &page[i];
+		}
+	}
+
+	area = vm_area_cache;
+	vm_area_cache = area->next;
+
+	spin_unlock(&vm_area_cache_lock);
+
+	return area;
+}
+
+static void vm_area_free(vm_area_t *area)
+{
+	spin_lock(&vm_area_cache_lock);
+	area->next = vm_area_cache;
+	vm_area_cache = area;
+	spin_unlock(&vm_area_cache_lock);
+}
+
+/* Area holding 'addr' */
+static vm_area_t *vm_area_find(const vm_space_t *vm, uintptr_t addr)
+{
+	struct rb_node *node = vm->areas.rb_node;
+
+	while (node != NULL) {
+		vm_area_t *area = vm_area_entry(node);
+
+		if (addr < area->start)
+			node = node->rb_left;
+		else if (addr >= area->end)
+			node = node->rb_right;
+		else
+			return area;
+	}
+
+	return NULL;
+}
+
+/* Lowest area ending above 'addr' */
+static vm_area_t *vm_area_find_above(const vm_space_t *vm, uintptr_t addr)
+{
+	struct rb_node *node = vm->areas.rb_node;
+	vm_area_t *found = NULL;
+
+	while (node != NULL) {
+		vm_area_t *area = vm_area_entry(node);
+
+		if (addr < area->end) {
+			found = area;
+			node = node->rb_left;
+		} else {
+			node = node->rb_right;
+		}
+	}
+
+	return found;
+}
+
+/*******************************************************************************
+ * Lowest start of a free range of 'size' bytes in [VM_MMAP_BASE, VDSO_USER_VA),
+ * or 0. Subtrees whose largest gap is too small are skipped.
+ ******************************************************************************/
+static uintptr_t vm_area_find_gap(const vm_space_t *vm, size_t size)
+{
+	struct rb_node *node = vm->areas.rb_node;
+	const vm_area_t *last;
+	uintptr_t base;
+
+	if ((node != NULL) && (vm_area_entry(node)->subtree_gap >= size)) {
+		for (;;) {
+			vm_area_t *area = vm_area_entry(node);
+			vm_area_t *left = vm_area_entry(node->rb_left);
+
+			if ((left != NULL) && (left->subtree_gap >= size)) {
+				node = node->rb_left;
+				continue;
+			}
+
+			if (area->gap >= size) {
+				base = area->start - area->gap;
+				/* Gaps above this one start even higher */
+				return ((VDSO_USER_VA - base) >= size) ?
+					base : 0U;
+			}
+
+			node = node->rb_right;
+			assert((node != NULL) &&
+			       (vm_area_entry(node)->subtree_gap >= size));
+		}
+	}
+
+	/* Above the last area */
+	last = vm_area_entry(rb_last(&vm->areas));
+	base = (last != NULL) ? last->end : 0U;
+	base = (base > VM_MMAP_BASE) ? base : VM_MMAP_BASE;
+
+	return (vm_gap_size(base, VDSO_USER_VA) >= size) ? base : 0U;
+}
+
+static void vm_area_link(vm_space_t *vm, vm_area_t *area)
+{
+	struct rb_node **link = &vm->areas.rb_node;
+	struct rb_node *parent = NULL;
+	vm_area_t *prev = NULL, *next;
+
+	/* The gaps of the path down are updated on the way */
+	while (*link != NULL) {
+		vm_area_t *cur = vm_area_entry(*link);
+
+		parent = *link;
+		if (area->start < cur->start) {
+			link = &parent->rb_left;
+		} else {
+			prev = cur;
+			link = &parent->rb_right;
+		}
+	}
+
+	area->gap = vm_gap_size((prev != NULL) ? prev->end : 0U, area->start);
+	area->subtree_gap = area->gap;
+
+	for (struct rb_node *up = parent; up != NULL; up = rb_parent(up)) {
+		vm_area_t *cur = vm_area_entry(up);
+
+		if (cur->subtree_gap >= area->gap)
+			break;
+		cur->subtree_gap = area->gap;
+	}
+
+	rb_link_node(&area->node, parent, link);
+	rb_insert_augmented(&area->node, &vm->areas, &vm_area_gap_cb);
+
+	/* The area splits the gap below the next one */
+	next = vm_area_entry(rb_next(&area->node));
+	if (next != NULL) {
+		next->gap = vm_gap_size(area->end, next->start);
+		vm_area_gap_cb_propagate(&next->node, NULL);
+	}
+}
+
+static void vm_area_unlink(vm_space_t *vm, vm_area_t *area)
+{
+	vm_area_t *next = vm_area_entry(rb_next(&area->node));
+
+	rb_erase_augmented(&area->node, &vm->areas, &vm_area_gap_cb);
+
+	if (next != NULL) {
+		next->gap = vm_area_gap_below(next);
+		vm_area_gap_cb_propagate(&next->node, NULL);
+	}
+}
+
+/*******************************************************************************
+ * Add the area [start, start + size) to 'vm', with its translation tables but
+ * no pages. Called with the lock of 'vm' held.
+ ******************************************************************************/
+static int vm_area_add(vm_space_t *vm, uintptr_t start, size_t size,
+		       uint32_t attr)
+{
+	mmap_region_t mm = MAP_REGION2(0U, start, size, attr | MT_DEMAND,
+				       PAGE_SIZE);
+	const vm_area_t *above = vm_area_find_above(vm, start);
+	vm_area_t *area;
+	int rc;
+
+	if ((above != NULL) && (above->start < (start + size)))
+		return -EEXIST;
+
+	area = vm_area_alloc();
+	if (area == NULL)
+		return -ENOMEM;
+
+	rc = mmap_add_dynamic_region_ctx(vm->ctx, &mm);
+	if (rc != 0) {
+		vm_area_free(area);
+		return rc;
+	}
+
+	area->start = start;
+	area->end = start + size;
+	area->attr = attr;
+	vm_area_link(vm, area);
+
+	return 0;
+}
+
+/*
+ * Drop the pages of 'area' and remove it. Called with the lock held.
+ *
+ * A page is only put once it is unmapped and the TLBs are invalidated, as
+ * another CPU may still write to it through a stale entry until then. The
+ * pages are unmapped by batches of VM_UNMAP_BATCH, each with a single TLB
+ * invalidation.
+ */
+static void vm_area_remove(vm_space_t *vm, vm_area_t *area)
+{
+	unsigned long long pa[VM_UNMAP_BATCH];
+	uintptr_t va = area->start;
+	int rc;
+
+	while (va < area->end) {
+		uintptr_t batch_va = va;
+		unsigned int nr = 0U;
+
+		for (; (va < area->end) && (nr < VM_UNMAP_BATCH);
+		     va += PAGE_SIZE) {
+			if ((xlat_page_lookup_ctx(vm->ctx, va, &pa[nr],
+						  NULL) == 0) &&
+			    mm_page_in_pool((void *)(uintptr_t)pa[nr]))
+				nr++;
+		}
+
+		rc = xlat_unmap_pages_ctx(vm->ctx, batch_va, va - batch_va);
+		assert(rc == 0);
+
+		for (unsigned int i = 0U; i < nr; i++)
+			mm_page_put((void *)(uintptr_t)pa[i]);
+	}
+
+	rc = mmap_remove_dynamic_region_ctx(vm->ctx, area->start,
+					    area->end - area->start);
+	assert(rc == 0);
+	(void)rc;
+
+	vm_area_unlink(vm, area);
+	vm_area_free(area);
+}
+
+/*******************************************************************************
+ * Add an area of 'size' bytes to 'vm', at '*addr' or, if it is 0, at the
+ * lowest free range, returned in '*addr'. Either way it lies in
+ * [VM_MMAP_BASE, VDSO_USER_VA). Its pages are only mapped when touched. 'attr' holds the attributes of
+ * VM_AREA_ATTR_MASK, the pages are normal non-secure memory for EL0.
+ ******************************************************************************/
+int vm_map(vm_space_t *vm, uintptr_t *addr, size_t size, uint32_t attr)
+{
+	uintptr_t start = *addr;
+	int rc;
+
+	if ((size == 0U) || !IS_PAGE_ALIGNED(size) || !IS_PAGE_ALIGNED(start) ||
+	    ((attr & ~VM_AREA_ATTR_MASK) != 0U))
+		return -EINVAL;
+
+	/* A given range must fit in the window, without wrapping around */
+	if ((start != 0U) &&
+	    ((start < VM_MMAP_BASE) || (start >= VDSO_USER_VA) ||
+	     (size > (VDSO_USER_VA - start))))
+		return -EINVAL;
+
+	attr |= MT_MEMORY | MT_USER | MT_NS;
+	/* Writable memory is never executable */
+	if ((attr & MT_RW) != 0U)
+		attr |= MT_EXECUTE_NEVER;
+
+	spin_lock(&vm->lock);
+
+	if (start == 0U)
+		start = vm_area_find_gap(vm, size);
+
+	rc = (start != 0U) ? vm_area_add(vm, start, size, attr) : -ENOMEM;
+	if (rc == 0)
+		*addr = start;
+
+	spin_unlock(&vm->lock);
+
+	return rc;
+}
+
+/*******************************************************************************
+ * Remove the area added at 'addr' with 'size' bytes. Areas go as a whole.
+ ******************************************************************************/
+int vm_unmap(vm_space_t *vm, uintptr_t addr, size_t size)
+{
+	vm_area_t *area;
+	int rc = 0;
+
+	spin_lock(&vm->lock);
+
+	area = vm_area_find(vm, addr);
+	if ((area == NULL) || (area->start != addr) ||
+	    ((area->end - area->start) != size))
+		rc = -EINVAL;
+	else
+		vm_area_remove(vm, area);
+
+	spin_unlock(&vm->lock);
+
+	return rc;
+}
+
+void vm_space_destroy(vm_space_t *vm)
+{
+	struct rb_node *node;
+
+	spin_lock(&vm->lock);
+	while ((node = rb_first(&vm->areas)) != NULL)
+		vm_area_remove(vm, vm_area_entry(node));
+	spin_unlock(&vm->lock);
+}
+
+/*******************************************************************************
+ * Give the empty space 'child' the areas of 'parent', sharing their pages.
+ * Both get them read-only, the first write to one of a writable area makes a
+ * copy. On error, 'child' is left empty.
+ ******************************************************************************/
+int vm_space_fork(vm_space_t *child, vm_space_t *parent)
+{
+	unsigned long long pa;
+	int rc = 0;
+
+	assert(RB_EMPTY_ROOT(&child->areas));
+
+	spin_lock(&parent->lock);
+	spin_lock(&child->lock);
+
+	for (struct rb_node *node = rb_first(&parent->areas);
+	     node != NULL; node = rb_next(node)) {
+		const vm_area_t *area = vm_area_entry(node);
+		size_t size = area->end - area->start;
+
+		rc = vm_area_add(child, area->start, size, area->attr);
+		if (rc != 0)
+			break;
+
+		if ((area->attr & MT_RW) != 0U) {
+			rc = xlat_wrprotect_pages_ctx(parent->ctx, area->start,
+						      size);
+			assert(rc == 0);
+		}
+
+		for (uintptr_t va = area->start; va < area->end;
+		     va += PAGE_SIZE) {
+			if (xlat_page_lookup_ctx(parent->ctx, va, &pa,
+						 NULL) != 0)
+				continue;
+
+			if (mm_page_in_pool((void *)(uintptr_t)pa))
+				mm_page_get((void *)(uintptr_t)pa);
+
+			rc = xlat_map_page_ctx(child->ctx, va, pa,
+					       vm_area_ro_attr(area));
+			assert(rc == 0);
+		}
+	}
+
+	spin_unlock(&child->lock);
+	spin_unlock(&parent->lock);
+
+	if (rc != 0)
+		vm_space_destroy(child);
+
+	return rc;
+}
+
+/*
+ * Map the zero page at the unmapped pages of the window around 'va', within
+ * 'area'. A sequential reader then faults once per window.
+ */
+static void vm_fault_around(vm_space_t *vm, const vm_area_t *area,
+			    uintptr_t va)
+{
+	const size_t window = VM_FAULT_AROUND_PAGES * PAGE_SIZE;
+	uintptr_t start = va & ~(window - 1U);
+	uintptr_t end = start + window;
+	unsigned long long pa;
+
+	start = (start > area->start) ? start : area->start;
+	end = (end < area->end) ? end : area->end;
+
+	for (uintptr_t addr = start; addr < end; addr += PAGE_SIZE) {
+		if ((addr == va) ||
+		    (xlat_page_lookup_ctx(vm->ctx, addr, &pa, NULL) != -ENOENT))
+			continue;
+
+		(void)xlat_map_page_ctx(vm->ctx, addr,
+					(uintptr_t)vm_zero_page,
+					vm_area_ro_attr(area));
+	}
+}
+
+/* Write to the read-only page at 'pa' of a writable area */
+static int vm_fault_copy(vm_space_t *vm, const vm_area_t *area, uintptr_t va,
+			 unsigned long long pa)
+{
+	void *old = (void *)(uintptr_t)pa;
+	void *page;
+
+	/* No other space holds it any more, and none can take it meanwhile */
+	if (mm_page_in_pool(old) && (mm_page_count(old) == 1U))
+		return xlat_map_page_ctx(vm->ctx, va, pa, area->attr);
+
+	page = mm_page_alloc(0U);
+	if (page == NULL)
+		return -ENOMEM;
+
+	(void)memcpy(page, old, PAGE_SIZE);
+	(void)xlat_map_page_ctx(vm->ctx, va, (uintptr_t)page, area->attr);
+
+	if (mm_page_in_pool(old))
+		mm_page_put(old);
+
+	return 0;
+}
+
+/*******************************************************************************
+ * Handle a translation or permission fault at 'addr' of 'vm'. 'flags' are
+ * the VM_FAULT_* bits of the access. Returns 0 when the access can be
+ * retried, -EFAULT when it isn't allowed and -ENOMEM when out of pages.
+ ******************************************************************************/
+int vm_fault(vm_space_t *vm, uintptr_t addr, unsigned int flags)
+{
+	uintptr_t va = addr & ~(uintptr_t)PAGE_SIZE_MASK;
+	bool write = (flags & VM_FAULT_WRITE) != 0U;
+	const vm_area_t *area;
+	unsigned long long pa;
+	bool writable;
+	int rc;
+
+	if (vm == NULL)
+		return -EFAULT;
+
+	spin_lock(&vm->lock);
+
+	area = vm_area_find(vm, addr);
+	if ((area == NULL) || (write && ((area->attr & MT_RW) == 0U)) ||
+	    (((flags & VM_FAULT_EXEC) != 0U) &&
+	     ((area->attr & MT_EXECUTE_NEVER) != 0U))) {
+		spin_unlock(&vm->lock);
+		return -EFAULT;
+	}
+
+	rc = xlat_page_lookup_ctx(vm->ctx, va, &pa, &writable);
+	if (rc == -ENOENT) {
+		if (write) {
+			void *page = mm_page_alloc(MM_ZERO);
+
+			rc = (page != NULL) ?
+				xlat_map_page_ctx(vm->ctx, va,
+						  (uintptr_t)page, area->attr) :
+				-ENOMEM;
+		} else {
+			rc = xlat_map_page_ctx(vm->ctx, va,
+					       (uintptr_t)vm_zero_page,
+					       vm_area_ro_attr(area));
+			vm_fault_around(vm, area, va);
+		}
+	} else if ((rc == 0) && write && !writable) {
+		rc = vm_fault_copy(vm, area, va, pa);
+	}
+	/* Otherwise another CPU mapped the page meanwhile */
+
+	spin_unlock(&vm->lock);
+
+	return rc;
+}
+#endif /* PLAT_XLAT_TABLES_DYNAMIC */
+
+#if VM_SWITCH_BENCH
+#define VM_BENCH_PAGES		U(32)
+/* Tables from the base level of the kernel's regime to the last one */
+#define VM_BENCH_LEVELS		(XLAT_TABLE_LEVEL_MAX + 1U -		\
+				 GET_XLAT_TABLE_LEVEL_BASE(PLAT_VIRT_ADDR_SPACE_SIZE))
+
+/* The pages are mapped at VM_MMAP_BASE, by a last level table of their own */
+CASSERT((VM_MMAP_BASE & (XLAT_BLOCK_SIZE(2U) - 1U)) == 0U,
+	assert_vm_bench_base_is_l2_aligned);
+CASSERT(VM_BENCH_PAGES <= XLAT_TABLE_ENTRIES, assert_vm_bench_fits_one_table);
+
+static uint8_t vm_bench_buf[VM_BENCH_PAGES * PAGE_SIZE] __aligned(PAGE_SIZE);
+static vm_space_t vm_bench_spaces[2];
+static uint64_t vm_bench_tables[2][VM_BENCH_LEVELS][XLAT_TABLE_ENTRIES]
+	__aligned(XLAT_TABLE_SIZE);
+
+/* Descriptor of the kernel's mapping of 'va', a page or a block */
+static uint64_t vm_bench_kernel_desc(const uint64_t *table, uintptr_t va)
+{
+	unsigned int level = GET_XLAT_TABLE_LEVEL_BASE(PLAT_VIRT_ADDR_SPACE_SIZE);
+	uint64_t desc;
+
+	for (;;) {
+		desc = table[XLAT_TABLE_IDX(va, level)];
+		if ((level == XLAT_TABLE_LEVEL_MAX) ||
+		    ((desc & DESC_MASK) != TABLE_DESC))
+			break;
+		table = (const uint64_t *)(uintptr_t)(desc & TABLE_ADDR_MASK);
+		level++;
+	}
+
+	assert((desc & DESC_MASK) != INVALID_DESC);
+
+	return desc;
+}
+
+/*
+ * Make 'vm' a space of its own: the kernel's tables are copied along the path
+ * to VM_MMAP_BASE, where a last level table of the space maps vm_bench_buf
+ * with user, non-global pages. Everything else is shared with the kernel.
+ */
+static void vm_bench_space_init(vm_space_t *vm,
+				uint64_t (*tables)[XLAT_TABLE_ENTRIES],
+				const uint64_t *kernel)
+{
+	unsigned int level = GET_XLAT_TABLE_LEVEL_BASE(PLAT_VIRT_ADDR_SPACE_SIZE);
+	size_t entries = GET_NUM_BASE_LEVEL_ENTRIES(PLAT_VIRT_ADDR_SPACE_SIZE);
+	const uint64_t *src = kernel;
+	uint64_t attr;
+
+	/* The attributes of the kernel's mapping, for EL0 and tagged */
+	attr = vm_bench_kernel_desc(kernel, (uintptr_t)vm_bench_buf) &
+	       ~(TABLE_ADDR_MASK | DESC_MASK | UPPER_ATTRS(CONT_HINT));
+	attr |= LOWER_ATTRS(AP_ACCESS_UNPRIVILEGED | NON_GLOBAL) |
+		UPPER_ATTRS(UXN) | PAGE_DESC;
+
+	for (unsigned int n = 0U; n < VM_BENCH_LEVELS; n++, level++) {
+		uint64_t *dst = tables[n];
+		uint64_t desc;
+
+		(void)memset(dst, 0, XLAT_TABLE_SIZE);
+		if (src != NULL)
+			(void)memcpy(dst, src, entries * sizeof(uint64_t));
+		entries = XLAT_TABLE_ENTRIES;
+
+		if (level == XLAT_TABLE_LEVEL_MAX)
+			break;
+
+		/* The kernel must not map anything in the user window */
+		desc = dst[XLAT_TABLE_IDX(VM_MMAP_BASE, level)];
+		assert((desc & DESC_MASK) != BLOCK_DESC);
+		src = ((desc & DESC_MASK) == TABLE_DESC) ?
+			(const uint64_t *)(uintptr_t)(desc & TABLE_ADDR_MASK) :
+			NULL;
+
+		dst[XLAT_TABLE_IDX(VM_MMAP_BASE, level)] =
+			(uint64_t)(uintptr_t)tables[n + 1U] | TABLE_DESC;
+	}
+
+	for (unsigned int i = 0U; i < VM_BENCH_PAGES; i++) {
+		uintptr_t va = VM_MMAP_BASE + (i * PAGE_SIZE);
+
+		tables[VM_BENCH_LEVELS - 1U][XLAT_TABLE_IDX(va,
+						XLAT_TABLE_LEVEL_MAX)] =
+			attr | (uintptr_t)&vm_bench_buf[i * PAGE_SIZE];
+	}
+
+	/* The tables are written before the walker can see them */
+	dsbishst();
+
+	vm->base_table = tables[0];
+	vm->asid = 0U;
+}
+
+static void vm_bench_touch(void)
+{
+	for (unsigned int i = 0U; i < VM_BENCH_PAGES; i++)
+		(void)*(volatile uint8_t *)(VM_MMAP_BASE + (i * PAGE_SIZE));
+}
+
+/* Nanoseconds per switch and refill of the working set */
+static uint64_t vm_bench_run(unsigned int loops, bool asids)
+{
+	uint64_t start = hrtimer_now();
+
+	for (unsigned int i = 0U; i < loops; i++) {
+		for (unsigned int s = 0U; s < 2U; s++) {
+			if (asids) {
+				vm_switch(&vm_bench_spaces[s]);
+			} else {
+				/* What a switch costs without ASIDs */
+				vm_write_ttbr0(&vm_bench_spaces[s], 0U);
+				tlbivmalle1();
+				dsbnsh();
+				isb();
+			}
+			vm_bench_touch();
+		}
+	}
+
+	return (hrtimer_now() - start) / (2U * loops);
+}
+
+/*******************************************************************************
+ * Switch back and forth between two address spaces, touching a few pages
+ * after each switch, once with ASIDs and once invalidating the TLBs at every
+ * switch instead. Each space maps the pages with non-global user entries of
+ * its own, at the same VA, so that their TLB entries are tagged with its
+ * ASID; the kernel's tables are shared. Meant for QEMU, run with -icount or
+ * on KVM for meaningful TLB costs.
+ ******************************************************************************/
+void vm_switch_bench(unsigned int loops)
+{
+	const uint64_t *table = (const uint64_t *)(uintptr_t)
+		(read_ttbr0_el1() & ~(TTBR_CNP_BIT |
+				      (TTBR_ASID_MASK << TTBR_ASID_SHIFT)));
+	vm_space_t kernel = { .base_table = table, .asid = 0U };
+	uint64_t with, without;
+
+	assert(loops != 0U);
+
+	for (unsigned int s = 0U; s < 2U; s++)
+		vm_bench_space_init(&vm_bench_spaces[s], vm_bench_tables[s],
+				    table);
+
+	without = vm_bench_run(loops, false);
+	with = vm_bench_run(loops, true);
+
+	/* Back to ASID 0, which the kernel space keeps */
+	vm_write_ttbr0(&kernel, 0U);
+	tlbivmalle1();
+	dsbnsh();
+	isb();
+
+	INFO("vm switch: %u loops, %llu ns without ASIDs, %llu ns with "
+	     "ASIDs %u and %u\n", loops, (unsigned long long)without,
+	     (unsigned long long)with, vm_space_asid(&vm_bench_spaces[0]),
+	     vm_space_asid(&vm_bench_spaces[1]));
+}
+#endif /* VM_SWITCH_BENCH */
@@ -1 +1,95 @@
-// function
\ No newline at end of file
+/*
+ * Copyright (c) 2013-2022, Arm Limited and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+// function
+
+#include <assert.h>
+#include <stdbool.h>
+
+#include <platform_def.h>
+
+#include <linux/llist.h>
+#include <platform.h>
+#include <workqueue.h>
+
+typedef struct wq_cpu {
+	struct llist_head list[WQ_NR];
+} __aligned(CACHE_WRITEBACK_GRANULE) wq_cpu_t;
+
+static wq_cpu_t wq_cpus[PLATFORM_CORE_COUNT];
+
+void work_init(work_t *work, work_fn_t func)
+{
+	assert(func != NULL);
+
+	work->func = func;
+	work->pending = 0U;
+}
+
+/*******************************************************************************
+ * Queue 'work' on the calling CPU. Returns false if it was already queued, in
+ * which case it runs only once.
+ ******************************************************************************/
+bool queue_work(work_t *work, wq_prio_t prio)
+{
+	assert(prio < WQ_NR);
+
+	if (__atomic_exchange_n(&work->pending, 1U, __ATOMIC_ACQ_REL) != 0U)
+		return false;
+
+	(void)llist_add(&work->node, &wq_cpus[plat_my_core_pos()].list[prio]);
+
+	return true;
+}
+
+bool workqueue_pending(void)
+{
+	const wq_cpu_t *wc = &wq_cpus[plat_my_core_pos()];
+
+	for (unsigned int prio = 0U; prio < WQ_NR; prio++) {
+		if (!llist_empty(&wc->list[prio]))
+			return true;
+	}
+
+	return false;
+}
+
+/* Run one batch of 'prio', oldest first. Returns false if it was empty. */
+static bool workqueue_run_one(wq_cpu_t *wc, wq_prio_t prio)
+{
+	struct llist_node *list;
+	work_t *work, *tmp;
+
+	list = llist_del_all(&wc->list[prio]);
+	if (list == NULL)
+		return false;
+
+	list = llist_reverse_order(list);
+	llist_for_each_entry_safe(work, tmp, list, node) {
+		/* It may be queued again from now on, e.g. by its interrupt */
+		__atomic_store_n(&work->pending, 0U, __ATOMIC_RELEASE);
+		work->func(work);
+	}
+
+	return true;
+}
+
+/*******************************************************************************
+ * Run the work queued on the calling CPU until there is none left. Called
+ * from the idle loop, with interrupts unmasked.
+ ******************************************************************************/
+void workqueue_run(void)
+{
+	wq_cpu_t *wc = &wq_cpus[plat_my_core_pos()];
+	wq_prio_t prio = WQ_HIGHPRI;
+
+	while (prio < WQ_NR) {
+		if (workqueue_run_one(wc, prio))
+			prio = WQ_HIGHPRI;
+		else
+			prio++;
+	}
+}
@@ -0,0 +1,24 @@
+#
+# Copyright (c) 2016, ARM Limited and Contributors. All rights reserved.
+#
+# SPDX-License-Identifier: BSD-3-Clause
+#
+
+cmake_minimum_required(VERSION 3.14)
+
+# libfdt, as lib/libfdt/libfdt.mk builds it
+add_sources(
+    DEP ""
+    PREFIX lib/libfdt
+    CFILES
+        fdt.c
+        fdt_addresses.c
+        fdt_empty_tree.c
+        fdt_ro.c
+        fdt_rw.c
+        fdt_strerror.c
+        fdt_sw.c
+        fdt_wip.c
+)
+
+include_directories("include/lib/libfdt")
@@ -15,12 +15,16 @@
 /*
  * Only print the output if PLAT_LOG_LEVEL_ASSERT is higher or equal to
  * LOG_LEVEL_INFO, which is the default value for builds with DEBUG=1.
+ *
+ * Whatever the log rings still hold is written out first, and the report
+ * itself then bypasses them, as it would never be drained.
  */
 
 #if PLAT_LOG_LEVEL_ASSERT >= LOG_LEVEL_VERBOSE
 void __dead2 __assert(const char *file, unsigned int line,
 		      const char *assertion)
 {
+	console_ring_emergency();
 	printf("ASSERT: %s:%u:%s\n", file, line, assertion);
 	backtrace("assert");
 	console_flush();
@@ -29,6 +33,7 @@ void __dead2 __assert(const char *file, unsigned int line,
 #elif PLAT_LOG_LEVEL_ASSERT >= LOG_LEVEL_INFO
 void __dead2 __assert(const char *file, unsigned int line)
 {
+	console_ring_emergency();
 	printf("ASSERT: %s:%u\n", file, line);
 	backtrace("assert");
 	console_flush();
@@ -37,6 +42,7 @@ void __dead2 __assert(const char *file, unsigned int line)
 #else
 void __dead2 __assert(void)
 {
+	console_ring_emergency();
 	backtrace("assert");
 	console_flush();
 	plat_panic_handler();
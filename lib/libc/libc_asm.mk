@@ -9,9 +9,6 @@ LIBC_SRCS	:=	$(addprefix lib/libc/,		\
 			assert.c			\
 			exit.c				\
 			memchr.c			\
-			memcmp.c			\
-			memcpy.c			\
-			memmove.c			\
 			memrchr.c			\
 			printf.c			\
 			putchar.c			\
@@ -33,10 +30,18 @@ LIBC_SRCS	:=	$(addprefix lib/libc/,		\
 
 ifeq (${ARCH},aarch64)
 LIBC_SRCS	+=	$(addprefix lib/libc/aarch64/,	\
+			memcmp.S			\
+			memcpy.S			\
+			memmove.S			\
 			memset.S			\
 			setjmp.S)
 else
+LIBC_SRCS	+=	$(addprefix lib/libc/,		\
+			memcmp.c			\
+			memmove.c)
+
 LIBC_SRCS	+=	$(addprefix lib/libc/aarch32/,	\
+			memcpy.S			\
 			memset.S)
 endif
 
@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2020, Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+#ifndef LIBC_PRIVATE_H
+#define LIBC_PRIVATE_H
+
+#include <stdint.h>
+
+/*
+ * Helpers for the word-at-a-time string and memory routines. A word is the
+ * native register width, so every aligned load stays within one page and
+ * never faults even when it reads past the end of the string.
+ */
+#define WORD_SIZE		sizeof(uintptr_t)
+#define WORD_MASK		(WORD_SIZE - 1U)
+
+#define WORD_ALIGNED(p)		(((uintptr_t)(p) & WORD_MASK) == 0U)
+#define WORD_CO_ALIGNED(p, q)	((((uintptr_t)(p) ^ (uintptr_t)(q)) & WORD_MASK) == 0U)
+
+/* 0x0101...01 and 0x8080...80 for the native word size. */
+#define WORD_ONES		((uintptr_t)-1 / 0xffU)
+#define WORD_HIGHS		(WORD_ONES * 0x80U)
+
+/* Copy of the byte 'c' in every byte lane of a word. */
+#define WORD_REPEAT(c)		(WORD_ONES * (unsigned char)(c))
+
+/*
+ * Non-zero if and only if one of the bytes of 'x' is zero. Which lane is
+ * flagged is not reliable above the first zero byte, so callers rescan the
+ * word byte-per-byte once it reports a hit.
+ */
+#define WORD_HAS_ZERO(x)	(((x) - WORD_ONES) & ~(x) & WORD_HIGHS)
+
+#endif /* LIBC_PRIVATE_H */
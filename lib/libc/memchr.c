@@ -6,11 +6,32 @@
 
 #include <stddef.h>
 #include <string.h>
+#include <stdint.h>
+
+#include "libc_private.h"
 
 void *memchr(const void *src, int c, size_t len)
 {
 	const unsigned char *s = src;
+	const uintptr_t *word;
+	uintptr_t pattern = WORD_REPEAT(c);
+
+	/* Handle the first part, until the pointer becomes word aligned. */
+	while ((len != 0U) && !WORD_ALIGNED(s)) {
+		if (*s == (unsigned char)c)
+			return (void *) s;
+		s++;
+		len--;
+	}
+
+	/* Skip whole words that do not contain 'c'. */
+	word = (const uintptr_t *)s;
+	while ((len >= WORD_SIZE) && (WORD_HAS_ZERO(*word ^ pattern) == 0U)) {
+		word++;
+		len -= WORD_SIZE;
+	}
 
+	s = (const unsigned char *)word;
 	while (len--) {
 		if (*s == (unsigned char)c)
 			return (void *) s;
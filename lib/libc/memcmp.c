@@ -6,14 +6,45 @@
 
 #include <stddef.h>
 #include <string.h>
+#include <stdint.h>
+
+#include "libc_private.h"
 
 int memcmp(const void *s1, const void *s2, size_t len)
 {
 	const unsigned char *s = s1;
 	const unsigned char *d = s2;
+	const uintptr_t *s_word;
+	const uintptr_t *d_word;
 	unsigned char sc;
 	unsigned char dc;
 
+	/*
+	 * Skip over equal words first. The first differing word is then
+	 * rescanned byte-per-byte, which keeps the result independent of
+	 * the endianness.
+	 */
+	if (WORD_CO_ALIGNED(s, d)) {
+		while ((len != 0U) && !WORD_ALIGNED(s)) {
+			sc = *s++;
+			dc = *d++;
+			if (sc - dc)
+				return (sc - dc);
+			len--;
+		}
+
+		s_word = (const uintptr_t *)s;
+		d_word = (const uintptr_t *)d;
+		while ((len >= WORD_SIZE) && (*s_word == *d_word)) {
+			s_word++;
+			d_word++;
+			len -= WORD_SIZE;
+		}
+
+		s = (const unsigned char *)s_word;
+		d = (const unsigned char *)d_word;
+	}
+
 	while (len--) {
 		sc = *s++;
 		dc = *d++;
@@ -6,12 +6,50 @@
 
 #include <stddef.h>
 #include <string.h>
+#include <stdint.h>
+
+#include "libc_private.h"
 
 void *memcpy(void *dst, const void *src, size_t len)
 {
 	const char *s = src;
 	char *d = dst;
+	const uintptr_t *s_word;
+	uintptr_t *d_word;
+
+	/*
+	 * Word copies are only possible when both pointers can become aligned
+	 * at the same time. Otherwise fall back to the byte loop below, since
+	 * unaligned accesses fault while the MMU is off.
+	 */
+	if (WORD_CO_ALIGNED(s, d)) {
+		/* Handle the first part, until the pointers become aligned. */
+		while ((len != 0U) && !WORD_ALIGNED(d)) {
+			*d++ = *s++;
+			len--;
+		}
+
+		s_word = (const uintptr_t *)s;
+		d_word = (uintptr_t *)d;
+
+		/* Copy four words per iteration for as long as possible. */
+		for (; len >= (4U * WORD_SIZE); len -= 4U * WORD_SIZE) {
+			d_word[0] = s_word[0];
+			d_word[1] = s_word[1];
+			d_word[2] = s_word[2];
+			d_word[3] = s_word[3];
+			d_word += 4;
+			s_word += 4;
+		}
+
+		for (; len >= WORD_SIZE; len -= WORD_SIZE)
+			*d_word++ = *s_word++;
+
+		s = (const char *)s_word;
+		d = (char *)d_word;
+	}
 
+	/* Handle the remaining part byte-per-byte. */
 	while (len--)
 		*d++ = *s++;
 
@@ -5,6 +5,9 @@
  */
 
 #include <string.h>
+#include <stdint.h>
+
+#include "libc_private.h"
 
 void *memmove(void *dst, const void *src, size_t len)
 {
@@ -24,6 +27,28 @@ void *memmove(void *dst, const void *src, size_t len)
 		const char *end = dst;
 		const char *s = (const char *)src + len;
 		char *d = (char *)dst + len;
+		const uintptr_t *s_word;
+		uintptr_t *d_word;
+
+		/*
+		 * Same as memcpy(), use whole words when both end pointers can
+		 * be aligned together. 'd' is above 's', so each word is read
+		 * before the store that may overwrite it.
+		 */
+		if (WORD_CO_ALIGNED(s, d)) {
+			while ((d != end) && !WORD_ALIGNED(d))
+				*--d = *--s;
+
+			s_word = (const uintptr_t *)s;
+			d_word = (uintptr_t *)d;
+
+			while ((size_t)((char *)d_word - end) >= WORD_SIZE)
+				*--d_word = *--s_word;
+
+			s = (const char *)s_word;
+			d = (char *)d_word;
+		}
+
 		while (d != end)
 			*--d = *--s;
 	}
@@ -5,13 +5,36 @@
  */
 
 #include <string.h>
+#include <stdint.h>
+
+#include "libc_private.h"
 
 #undef memrchr
 
 void *memrchr(const void *src, int c, size_t len)
 {
-	const unsigned char *s = src + (len - 1);
+	const unsigned char *s = (const unsigned char *)src + (len - 1);
+	const uintptr_t *word;
+	uintptr_t pattern = WORD_REPEAT(c);
+
+	/* Handle the last part, until the end of the range is word aligned. */
+	while ((len != 0U) && !WORD_ALIGNED(s + 1)) {
+		if (*s == (unsigned char)c) {
+			return (void*) s;
+		}
+
+		s--;
+		len--;
+	}
+
+	/* Skip whole words that do not contain 'c', walking backwards. */
+	word = (const uintptr_t *)(s + 1);
+	while ((len >= WORD_SIZE) && (WORD_HAS_ZERO(word[-1] ^ pattern) == 0U)) {
+		word--;
+		len -= WORD_SIZE;
+	}
 
+	s = (const unsigned char *)word - 1;
 	while (len--) {
 		if (*s == (unsigned char)c) {
 			return (void*) s;
@@ -10,6 +10,8 @@
 #include <stdint.h>
 
 #include <debug.h>
+#include <platform.h>
+#include <platform_def.h>
 
 #define get_num_va_args(_args, _lcount)				\
 	(((_lcount) > 1)  ? va_arg(_args, long long int) :	\
@@ -21,22 +23,77 @@
 	(((_lcount) == 1) ? va_arg(_args, unsigned long int) :		\
 			    va_arg(_args, unsigned int)))
 
-static int string_print(const char *str)
+/*
+ * vprintf() renders into a per-CPU buffer that is handed to the console layer
+ * in one go, instead of walking the console list once per character. A print
+ * that interrupts another one on the same CPU finds the buffer busy and falls
+ * back to unbuffered output.
+ */
+#define PRINTF_BUF_SIZE		128U
+
+typedef struct printf_buf {
+	char data[PRINTF_BUF_SIZE];
+	unsigned int len;
+	bool busy;
+} printf_buf_t;
+
+static printf_buf_t printf_bufs[PLATFORM_CORE_COUNT];
+
+static printf_buf_t *printf_buf_get(void)
+{
+	printf_buf_t *buf = &printf_bufs[plat_my_core_pos()];
+
+	if (buf->busy)
+		return NULL;
+
+	buf->busy = true;
+	return buf;
+}
+
+static void printf_buf_flush(printf_buf_t *buf)
+{
+	if ((buf != NULL) && (buf->len != 0U)) {
+		(void)console_write(buf->data, buf->len);
+		buf->len = 0U;
+	}
+}
+
+static void printf_buf_put(printf_buf_t *buf)
+{
+	if (buf != NULL) {
+		printf_buf_flush(buf);
+		buf->busy = false;
+	}
+}
+
+static void printf_buf_putc(printf_buf_t *buf, char c)
+{
+	if (buf == NULL) {
+		(void)putchar(c);
+		return;
+	}
+
+	buf->data[buf->len++] = c;
+	if (buf->len == PRINTF_BUF_SIZE)
+		printf_buf_flush(buf);
+}
+
+static int string_print(printf_buf_t *buf, const char *str)
 {
 	int count = 0;
 
 	assert(str != NULL);
 
 	for ( ; *str != '\0'; str++) {
-		(void)putchar(*str);
+		printf_buf_putc(buf, *str);
 		count++;
 	}
 
 	return count;
 }
 
-static int unsigned_num_print(unsigned long long int unum, unsigned int radix,
-			      char padc, int padn)
+static int unsigned_num_print(printf_buf_t *buf, unsigned long long int unum,
+			      unsigned int radix, char padc, int padn)
 {
 	/* Just need enough space to store 64 bit decimal integer */
 	char num_buf[20];
@@ -55,14 +112,14 @@ static int unsigned_num_print(unsigned long long int unum, unsigned int radix,
 
 	if (padn > 0) {
 		while (i < padn) {
-			(void)putchar(padc);
+			printf_buf_putc(buf, padc);
 			count++;
 			padn--;
 		}
 	}
 
 	while (--i >= 0) {
-		(void)putchar(num_buf[i]);
+		printf_buf_putc(buf, num_buf[i]);
 		count++;
 	}
 
@@ -98,6 +155,7 @@ int vprintf(const char *fmt, va_list args)
 	char padc = '\0'; /* Padding character */
 	int padn; /* Number of characters to pad */
 	int count = 0; /* Number of printed characters */
+	printf_buf_t *buf = printf_buf_get();
 
 	while (*fmt != '\0') {
 		l_count = 0;
@@ -109,38 +167,38 @@ int vprintf(const char *fmt, va_list args)
 loop:
 			switch (*fmt) {
 			case '%':
-				(void)putchar('%');
+				printf_buf_putc(buf, '%');
 				break;
 			case 'i': /* Fall through to next one */
 			case 'd':
 				num = get_num_va_args(args, l_count);
 				if (num < 0) {
-					(void)putchar('-');
+					printf_buf_putc(buf, '-');
 					unum = (unsigned long long int)-num;
 					padn--;
 				} else
 					unum = (unsigned long long int)num;
 
-				count += unsigned_num_print(unum, 10,
+				count += unsigned_num_print(buf, unum, 10,
 							    padc, padn);
 				break;
 			case 's':
 				str = va_arg(args, char *);
-				count += string_print(str);
+				count += string_print(buf, str);
 				break;
 			case 'p':
 				unum = (uintptr_t)va_arg(args, void *);
 				if (unum > 0U) {
-					count += string_print("0x");
+					count += string_print(buf, "0x");
 					padn -= 2;
 				}
 
-				count += unsigned_num_print(unum, 16,
+				count += unsigned_num_print(buf, unum, 16,
 							    padc, padn);
 				break;
 			case 'x':
 				unum = get_unum_va_args(args, l_count);
-				count += unsigned_num_print(unum, 16,
+				count += unsigned_num_print(buf, unum, 16,
 							    padc, padn);
 				break;
 			case 'z':
@@ -155,7 +213,7 @@ loop:
 				goto loop;
 			case 'u':
 				unum = get_unum_va_args(args, l_count);
-				count += unsigned_num_print(unum, 10,
+				count += unsigned_num_print(buf, unum, 10,
 							    padc, padn);
 				break;
 			case '0':
@@ -174,16 +232,19 @@ loop:
 				assert(0); /* Unreachable */
 			default:
 				/* Exit on any other format specifier */
+				printf_buf_put(buf);
 				return -1;
 			}
 			fmt++;
 			continue;
 		}
-		(void)putchar(*fmt);
+		printf_buf_putc(buf, *fmt);
 		fmt++;
 		count++;
 	}
 
+	printf_buf_put(buf);
+
 	return count;
 }
 
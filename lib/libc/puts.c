@@ -5,20 +5,20 @@
  */
 
 #include <stdio.h>
+#include <string.h>
+
+#include <drivers/console/console.h>
 
 int puts(const char *s)
 {
-	int count = 0;
+	size_t len = strlen(s);
 
-	while (*s != '\0') {
-		if (putchar(*s) == EOF)
-			return EOF;
-		s++;
-		count++;
-	}
+	/* Hand the whole string to the consoles as a single batch. */
+	if (console_write(s, len) < 0)
+		return EOF;
 
 	if (putchar('\n') == EOF)
 		return EOF;
 
-	return count + 1;
+	return (int)len + 1;
 }
@@ -36,14 +36,36 @@
 
 #include <stddef.h>
 #include <string.h>
+#include <stdint.h>
+
+#include "libc_private.h"
 
 char *
 strchr(const char *p, int ch)
 {
+	const uintptr_t *word;
+	uintptr_t pattern;
 	char c;
 
 	c = ch;
-	for (;; ++p) {
+	for (; !WORD_ALIGNED(p); ++p) {
+		if (*p == c)
+			return ((char *)p);
+		if (*p == '\0')
+			return (NULL);
+	}
+
+	/*
+	 * Skip whole words holding neither 'c' nor the terminator, then let
+	 * the byte loop below find which of the two comes first.
+	 */
+	pattern = WORD_REPEAT(c);
+	for (word = (const uintptr_t *)p;
+	     (WORD_HAS_ZERO(*word) | WORD_HAS_ZERO(*word ^ pattern)) == 0U;
+	     ++word)
+		;
+
+	for (p = (const char *)word;; ++p) {
 		if (*p == c)
 			return ((char *)p);
 		if (*p == '\0')
@@ -38,6 +38,9 @@
  */
 
 #include <string.h>
+#include <stdint.h>
+
+#include "libc_private.h"
 
 /*
  * Compare strings.
@@ -45,6 +48,30 @@
 int
 strcmp(const char *s1, const char *s2)
 {
+	const uintptr_t *w1;
+	const uintptr_t *w2;
+
+	/*
+	 * When both strings can be aligned together, skip equal words that
+	 * hold no terminator. The byte loop below then resolves the result.
+	 */
+	if (WORD_CO_ALIGNED(s1, s2)) {
+		for (; !WORD_ALIGNED(s1); s1++, s2++)
+			if (*s1 != *s2 || *s1 == '\0')
+				return (*(const unsigned char *)s1 -
+					*(const unsigned char *)s2);
+
+		w1 = (const uintptr_t *)s1;
+		w2 = (const uintptr_t *)s2;
+		while (*w1 == *w2 && WORD_HAS_ZERO(*w1) == 0U) {
+			w1++;
+			w2++;
+		}
+
+		s1 = (const char *)w1;
+		s2 = (const char *)w2;
+	}
+
 	while (*s1 == *s2++)
 		if (*s1++ == '\0')
 			return (0);
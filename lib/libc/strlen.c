@@ -5,11 +5,28 @@
  */
 
 #include <string.h>
+#include <stdint.h>
+
+#include "libc_private.h"
 
 size_t strlen(const char *s)
 {
 	const char *cursor = s;
+	const uintptr_t *word;
+
+	/* Handle the first part, until the cursor becomes word aligned. */
+	while (!WORD_ALIGNED(cursor)) {
+		if (*cursor == '\0')
+			return cursor - s;
+		cursor++;
+	}
+
+	/* Skip whole words until one of them contains the terminator. */
+	word = (const uintptr_t *)cursor;
+	while (WORD_HAS_ZERO(*word) == 0U)
+		word++;
 
+	cursor = (const char *)word;
 	while (*cursor)
 		cursor++;
 
@@ -32,13 +32,29 @@
  */
 
 #include <string.h>
+#include <stdint.h>
+
+#include "libc_private.h"
 
 size_t
 strnlen(const char *s, size_t maxlen)
 {
+	const uintptr_t *word;
 	size_t len;
 
-	for (len = 0; len < maxlen; len++, s++) {
+	for (len = 0; len < maxlen && !WORD_ALIGNED(s); len++, s++) {
+		if (!*s)
+			return (len);
+	}
+
+	/* Skip whole words that fit in 'maxlen' and hold no terminator. */
+	word = (const uintptr_t *)s;
+	while (maxlen - len >= WORD_SIZE && WORD_HAS_ZERO(*word) == 0U) {
+		word++;
+		len += WORD_SIZE;
+	}
+
+	for (s = (const char *)word; len < maxlen; len++, s++) {
 		if (!*s)
 			break;
 	}
@@ -1 +1,167 @@
-// memory class
\ No newline at end of file
+/*
+ * Copyright (c) 2013-2022, Arm Limited and Contributors. All rights reserved.
+ *
+ * SPDX-License-Identifier: BSD-3-Clause
+ */
+
+// memory class
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <debug.h>
+#include <lib/xlat_tables/xlat_tables_defs.h>
+#include <mm.h>
+#include <spinlock.h>
+
+/* End of the free list */
+#define MM_NO_PAGE		UINT32_MAX
+
+typedef struct mm_page {
+	/* References, 0 while the page is free */
+	uint32_t count;
+	/* Next free page, only valid while the page is free */
+	uint32_t next;
+} mm_page_t;
+
+static mm_page_t *mm_pages;
+static uintptr_t mm_base;
+static uint32_t mm_nr_pages;
+
+static uint32_t mm_free_head = MM_NO_PAGE;
+static size_t mm_nr_free;
+
+/* Serialises the free list */
+static spinlock_t mm_lock;
+
+static inline mm_page_t *mm_page_of(const void *page)
+{
+	uintptr_t addr = (uintptr_t)page;
+
+	assert(mm_page_in_pool(page));
+	assert(IS_PAGE_ALIGNED(addr));
+
+	return &mm_pages[(addr - mm_base) >> PAGE_SIZE_SHIFT];
+}
+
+static inline void *mm_page_addr(uint32_t idx)
+{
+	return (void *)(mm_base + ((uintptr_t)idx << PAGE_SIZE_SHIFT));
+}
+
+/*******************************************************************************
+ * Hand the pages of [base, base + size) to the allocator, once at boot. The
+ * range must be mapped read-write in the kernel's tables, with VA == PA.
+ ******************************************************************************/
+void mm_init(uintptr_t base, size_t size)
+{
+	uintptr_t start = round_up(base, PAGE_SIZE);
+	uintptr_t end = round_down(base + size, PAGE_SIZE);
+	size_t total = (end - start) >> PAGE_SIZE_SHIFT;
+	size_t desc_pages;
+
+	assert(mm_pages == NULL);
+	assert(end > start);
+
+	/* Descriptors of all the pages, then the pages themselves */
+	desc_pages = round_up(total * sizeof(mm_page_t), PAGE_SIZE) >>
+		     PAGE_SIZE_SHIFT;
+	assert(total > desc_pages);
+	assert((total - desc_pages) < MM_NO_PAGE);
+
+	mm_pages = (mm_page_t *)start;
+	mm_base = start + (desc_pages << PAGE_SIZE_SHIFT);
+	mm_nr_pages = (uint32_t)(total - desc_pages);
+
+	/* Lowest addresses first */
+	for (uint32_t i = 0U; i < mm_nr_pages; i++) {
+		mm_pages[i].count = 0U;
+		mm_pages[i].next = (i + 1U < mm_nr_pages) ? (i + 1U) :
+							   MM_NO_PAGE;
+	}
+
+	mm_free_head = 0U;
+	mm_nr_free = mm_nr_pages;
+
+	INFO("mm: %u pages at 0x%lx\n", mm_nr_pages, mm_base);
+}
+
+/*******************************************************************************
+ * Allocate a page, with a single reference. Returns NULL when none is left.
+ ******************************************************************************/
+void *mm_page_alloc(unsigned int flags)
+{
+	uint32_t idx;
+	void *page;
+
+	spin_lock(&mm_lock);
+
+	idx = mm_free_head;
+	if (idx == MM_NO_PAGE) {
+		spin_unlock(&mm_lock);
+		return NULL;
+	}
+
+	mm_free_head = mm_pages[idx].next;
+	mm_nr_free--;
+	mm_pages[idx].count = 1U;
+
+	spin_unlock(&mm_lock);
+
+	page = mm_page_addr(idx);
+	if ((flags & MM_ZERO) != 0U)
+		(void)memset(page, 0, PAGE_SIZE);
+
+	return page;
+}
+
+void mm_page_get(void *page)
+{
+	mm_page_t *desc = mm_page_of(page);
+	uint32_t old;
+
+	old = __atomic_fetch_add(&desc->count, 1U, __ATOMIC_RELAXED);
+	assert(old != 0U);
+	(void)old;
+}
+
+/*******************************************************************************
+ * Drop a reference to 'page', which is freed with the last one.
+ ******************************************************************************/
+void mm_page_put(void *page)
+{
+	mm_page_t *desc = mm_page_of(page);
+	uint32_t idx = (uint32_t)(desc - mm_pages);
+
+	assert(__atomic_load_n(&desc->count, __ATOMIC_RELAXED) != 0U);
+
+	/* Whatever the other holders wrote to it is done before it is freed */
+	if (__atomic_sub_fetch(&desc->count, 1U, __ATOMIC_ACQ_REL) != 0U)
+		return;
+
+	spin_lock(&mm_lock);
+	desc->next = mm_free_head;
+	mm_free_head = idx;
+	mm_nr_free++;
+	spin_unlock(&mm_lock);
+}
+
+unsigned int mm_page_count(const void *page)
+{
+	return __atomic_load_n(&mm_page_of(page)->count, __ATOMIC_ACQUIRE);
+}
+
+bool mm_page_in_pool(const void *page)
+{
+	uintptr_t addr = (uintptr_t)page;
+
+	return (addr >= mm_base) &&
+	       (((addr - mm_base) >> PAGE_SIZE_SHIFT) < mm_nr_pages);
+}
+
+size_t mm_nr_free_pages(void)
+{
+	return __atomic_load_n(&mm_nr_free, __ATOMIC_RELAXED);
+}